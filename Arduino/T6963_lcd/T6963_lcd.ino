@@ -175,6 +175,10 @@ static uint8_t displayMode;
 // Track graphic mode (ROM/RAM CG, OR, XOR, AND)
 static uint8_t graphicMode;
 
+// Auto mode in progress: T6963_AUTO_WRITE_SET, T6963_AUTO_READ_SET or 0.
+// STA0/STA1 are not valid during auto mode, so waits check STA2/STA3.
+static uint8_t autoMode;
+
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -199,6 +203,9 @@ static bool ports_init()
   pinMode(T6963_FONT, OUTPUT);
   digitalWrite(T6963_FONT, HIGH);  // 6x8 font
   //digitalWrite(T6963_FONT, LOW);   // 8x8 font
+#if defined(__AVR__)
+  bus_init();
+#endif
   setDataDirection(OUTPUT);
   
   delay(5);
@@ -214,6 +221,124 @@ static bool ports_init()
   return rtn;
 }
 
+#if defined(__AVR__)
+
+// Direct port register backend.  Data bits that sit on consecutive bits of
+// one port form a run, so the default wiring (D4-D11) is two register
+// writes per byte instead of eight digitalWrite calls.
+struct PortRun
+{
+  volatile uint8_t* out;
+  volatile uint8_t* in;
+  volatile uint8_t* mode;
+  uint8_t portMask;    // bits of the port used by this run
+  uint8_t dataMask;    // bits of the data byte in this run
+  int8_t shift;        // port bit - data bit
+};
+static PortRun runs[8];
+static uint8_t numRuns;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn bus_init
+///  @brief  Maps the T6963_D0..T6963_D7 pins onto port register runs
+////////////////////////////////////////////////////////////////////////////////
+static void bus_init()
+{
+  const uint8_t busPins[8] = { T6963_D0, T6963_D1, T6963_D2, T6963_D3,
+                               T6963_D4, T6963_D5, T6963_D6, T6963_D7 };
+  numRuns = 0;
+  for(int b = 0; b < 8; b++)
+  {
+    uint8_t port = digitalPinToPort(busPins[b]);
+    uint8_t mask = digitalPinToBitMask(busPins[b]);
+    int8_t bit = 0;
+    while( (1 << bit) != mask)
+    {
+      bit++;
+    }
+    PortRun* r = (numRuns > 0) ? &runs[numRuns - 1] : NULL;
+    if(r != NULL && r->out == portOutputRegister(port) && r->shift == bit - b)
+    {
+      r->portMask |= mask;
+      r->dataMask |= (1 << b);
+    }
+    else
+    {
+      r = &runs[numRuns++];
+      r->out = portOutputRegister(port);
+      r->in = portInputRegister(port);
+      r->mode = portModeRegister(port);
+      r->portMask = mask;
+      r->dataMask = (1 << b);
+      r->shift = bit - b;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setDataDirection
+///  @brief  Sets Data Bus pins direction
+///  @param[in]  INPUT, OUTPUT to choose direction
+////////////////////////////////////////////////////////////////////////////////
+
+static void setDataDirection(int dir)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  for(uint8_t r = 0; r < numRuns; r++)
+  {
+    if(dir == OUTPUT)
+    {
+      *runs[r].mode |= runs[r].portMask;
+    }
+    else
+    {
+      *runs[r].mode &= ~runs[r].portMask;
+      *runs[r].out &= ~runs[r].portMask;  // no pull-ups
+    }
+  }
+  SREG = oldSREG;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setDataBits
+///  @brief Sets output data onto data bus pins
+///  @param[in] d: Byte to set on bus pins
+////////////////////////////////////////////////////////////////////////////////
+
+static void setDataBits(uint8_t d)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  for(uint8_t r = 0; r < numRuns; r++)
+  {
+    uint8_t v = d & runs[r].dataMask;
+    v = (runs[r].shift >= 0) ? (v << runs[r].shift) : (v >> -runs[r].shift);
+    *runs[r].out = (*runs[r].out & ~runs[r].portMask) | v;
+  }
+  SREG = oldSREG;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn getDataBits
+///  @brief  Reads data bus pins
+///  @return  Byte value read from pins
+////////////////////////////////////////////////////////////////////////////////
+
+static uint8_t getDataBits()
+{
+  uint8_t rtn = 0;
+  for(uint8_t r = 0; r < numRuns; r++)
+  {
+    uint8_t v = *runs[r].in & runs[r].portMask;
+    rtn |= (runs[r].shift >= 0) ? (v >> runs[r].shift) : (v << -runs[r].shift);
+  }
+  return rtn;
+}
+
+#else  // portable digitalWrite fallback
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn setDataDirection
 ///  @brief  Sets Data Bus pins direction
@@ -305,26 +430,43 @@ static uint8_t getDataBits()
 }
 
 
+#endif  // __AVR__
+
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_init
-///  @brief  Initialize display for use
-///  @return  True if initialized, false otherwise
-////////////////////////////////////////////////////////////////////////////////
-static bool T6963_init()
+///  @brief  Initialize display state for a panel.  The graphic area sits at
+///          the top of RAM; text starts at 0 and may scroll through all the
+///          RAM below the graphic area.
+///  @param[in] pixelsWide  Panel width in pixels
+///  @param[in] pixelsHigh  Panel height in pixels (multiple of 8)
+///  @param[in] fontWidth   6 or 8, as selected by the FS pin
+///  @param[in] ramSize     Display RAM fitted, in bytes
+///  @return  True if initialized, false if the layout does not fit
+////////////////////////////////////////////////////////////////////////////////
+static bool T6963_init(uint16_t pixelsWide, uint8_t pixelsHigh, uint8_t fontWidth, uint16_t ramSize)
 {
-  width = 40;
-  height = 8;
+  bool rtn = false;
+  uint16_t cols = (pixelsWide + fontWidth - 1) / fontWidth;
+  uint16_t rows = pixelsHigh / 8;
+  width = cols;
+  height = rows;
   cursorX = 0;
   cursorY = 0;
   textBaseAddress = 0;
   textPointer = 0;
   textDisplayRow = 0;
   textDisplayCol = 0;
-  graphicBaseAddress = 6144;  //(my display has 8K ram)
+  textDisplayAddress = 0;
+  graphicBaseAddress = 0;
   displayMode = 0;  // no graphics, no text, no cursor, no blink
   graphicMode = 0;  // ROM cg, OR mode
-  
-  
+  if(cols <= 128 && rows <= 32 && (uint32_t)cols * (rows + pixelsHigh) <= ramSize)
+  {
+    graphicBaseAddress = ramSize - cols * pixelsHigh;
+    rtn = true;
+  }
+  return rtn;
 }
 
 
@@ -376,7 +518,7 @@ uint8_t T6963_getData()
 ////////////////////////////////////////////////////////////////////////////////
 static void wait()
 {
-  while(T6963_getStatus() & 0x03 != 3);
+  while( (T6963_getStatus() & 0x03) != 3);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -385,7 +527,7 @@ static void wait()
 ////////////////////////////////////////////////////////////////////////////////
 static void waitAuto()
 {
-  while(T6963_getStatus() & 0x0c == 0);  // wait while neither bit set
+  while( (T6963_getStatus() & 0x0c) == 0);  // wait while neither bit set
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -394,7 +536,7 @@ static void waitAuto()
 ////////////////////////////////////////////////////////////////////////////////
 static void waitAutoRead()
 {
-  while(T6963_getStatus() & 0x04 != 4);
+  while( (T6963_getStatus() & 0x04) != 4);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -403,17 +545,16 @@ static void waitAutoRead()
 ////////////////////////////////////////////////////////////////////////////////
 static void waitAutoWrite()
 {
-  while(T6963_getStatus() & 0x08 != 8);
+  while( (T6963_getStatus() & 0x08) != 8);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_writeDataByte
-///  @brief  Send a byte of data to controller
+///  @fn putData
+///  @brief  Strobe a data byte onto the bus, no status check
 ///  @param[in]  dat The data byte to send
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_writeDataByte(uint8_t dat)
+static void putData(uint8_t dat)
 {
-  wait();
   setDataDirection(OUTPUT);
   setDataBits(dat);
   digitalWrite(T6963_CD, LOW);
@@ -425,13 +566,12 @@ void T6963_writeDataByte(uint8_t dat)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn writeCommandByte
-///  @brief  Sends a command byte to controller. Send parameters prior to cmd.
+///  @fn putCommand
+///  @brief  Strobe a command byte onto the bus, no status check
 ///  @param[in] cmd The command byte to send
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_writeCommandByte(uint8_t cmd)
+static void putCommand(uint8_t cmd)
 {
-  wait();
   setDataDirection(OUTPUT);
   setDataBits(cmd);
   digitalWrite(T6963_CD, HIGH);
@@ -442,17 +582,47 @@ void T6963_writeCommandByte(uint8_t cmd)
   digitalWrite(T6963_WR, HIGH);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963_writeDataByte
+///  @brief  Send a byte of data to controller.  In auto write mode this
+///          checks STA3, otherwise STA0/STA1.
+///  @param[in]  dat The data byte to send
+////////////////////////////////////////////////////////////////////////////////
+void T6963_writeDataByte(uint8_t dat)
+{
+  if(autoMode == T6963_AUTO_WRITE_SET)
+  {
+    waitAutoWrite();
+  }
+  else
+  {
+    wait();
+  }
+  putData(dat);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeCommandByte
+///  @brief  Sends a command byte to controller. Send parameters prior to cmd.
+///  @param[in] cmd The command byte to send
+////////////////////////////////////////////////////////////////////////////////
+void T6963_writeCommandByte(uint8_t cmd)
+{
+  wait();
+  putCommand(cmd);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_setCursor
 ///  @brief  Set cursor location
-///  @param[in] x The horizontal coordinate (0 to 127)
-///  @param[in] y The vertical coordinate (0 to 63)
+///  @param[in] x The horizontal coordinate (0 to width - 1)
+///  @param[in] y The vertical coordinate (0 to height - 1)
 ///  @return  Zero on success, -1 if out of bounds
 ////////////////////////////////////////////////////////////////////////////////
 int T6963_setCursor(int x, int y)
 {
   int rtn = 0;
-  if(x < 0 || x > 127 || y < 0 || y > 63)
+  if(x < 0 || x >= width || y < 0 || y >= height)
   {
     rtn = -1;
   }
@@ -516,8 +686,11 @@ void T6963_setTextHomeAddress(uint16_t addr)
   textDisplayAddress = addr;
   // calc row and col
   uint16_t offset = addr - textBaseAddress;
-  // start col = offset % width
-  // start row = offset / width;
+  if(width != 0)
+  {
+    textDisplayCol = offset % width;
+    textDisplayRow = offset / width;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -690,6 +863,7 @@ void T6963_setCursorSize(uint8_t siz)
 void T6963_setAutoWrite()
 {
   T6963_writeCommandByte(T6963_AUTO_WRITE_SET);
+  autoMode = T6963_AUTO_WRITE_SET;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -699,15 +873,30 @@ void T6963_setAutoWrite()
 void T6963_setAutoRead()
 {
   T6963_writeCommandByte(T6963_AUTO_READ_SET);
+  autoMode = T6963_AUTO_READ_SET;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_setAutoReset
-///  @brief  Ends autoread or autowrite mode.
+///  @brief  Ends autoread or autowrite mode.  Waits on the auto bit of the
+///          mode in progress, since STA0/STA1 are not valid until the reset.
 ////////////////////////////////////////////////////////////////////////////////
 void T6963_setAutoReset()
 {
-  T6963_writeCommandByte(T6963_AUTO_RESET);
+  if(autoMode == T6963_AUTO_WRITE_SET)
+  {
+    waitAutoWrite();
+  }
+  else if(autoMode == T6963_AUTO_READ_SET)
+  {
+    waitAutoRead();
+  }
+  else
+  {
+    wait();
+  }
+  putCommand(T6963_AUTO_RESET);
+  autoMode = 0;
 }
 
 #define T6963_DATA_WRITE_INC              0xc0     // write data and increment
@@ -765,10 +954,9 @@ void T6963_dataWrite(uint8_t dat)
 uint8_t T6963_dataReadIncrement()
 {
   uint8_t rtn = 0;
-  wait();
   T6963_writeCommandByte(T6963_DATA_READ_INC);
   wait();
- // TODO rtn =T6963_readDataByte();
+  rtn = T6963_getData();
   return rtn;
 }
 
@@ -780,10 +968,9 @@ uint8_t T6963_dataReadIncrement()
 uint8_t T6963_dataReadDecrement()
 {
   uint8_t rtn = 0;
-  wait();
   T6963_writeCommandByte(T6963_DATA_READ_DEC);
   wait();
- // TODO rtn =T6963_readDataByte();
+  rtn = T6963_getData();
   return rtn;
 }
 
@@ -795,38 +982,40 @@ uint8_t T6963_dataReadDecrement()
 uint8_t T6963_dataRead()
 {
   uint8_t rtn = 0;
-  wait();
   T6963_writeCommandByte(T6963_DATA_READ);
   wait();
- // TODO rtn =T6963_readDataByte();
+  rtn = T6963_getData();
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_screenPeek
 ///  @brief  Read display byte from screen, using address pointer to graphics.
+///          Returns 0 if the address is outside the displayed graphic area.
 ///  @return Byte read from screen.
 ////////////////////////////////////////////////////////////////////////////////
 uint8_t T6963_screenPeek()
 {
   uint8_t rtn = 0;
-  wait();
   T6963_writeCommandByte(T6963_SCREEN_PEEK);
   wait();
- // TODO rtn =T6963_readDataByte();
+  if( (T6963_getStatus() & 0x40) == 0)  // STA6: peek error
+  {
+    rtn = T6963_getData();
+  }
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_screenCopy
 ///  @brief Copy one row of screen to graphics area
+///  @return  True on success, false if the address was outside the display
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_screenCopy()
+bool T6963_screenCopy()
 {
-  wait();
   T6963_writeCommandByte(T6963_SCREEN_COPY);
   wait();
- // TODO rtn =T6963_readDataByte();
+  return (T6963_getStatus() & 0x40) == 0;  // STA6: copy error
 }
 
 
@@ -862,56 +1051,161 @@ void T6963_resetBit(uint8_t b)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963_fill
+///  @brief  Write one byte value to a run of RAM with a single auto write.
+///          Each byte waits for STA3 only; STA0/STA1 are not checked
+///          until the auto reset.
+///  @param[in] addr  RAM address of the first byte
+///  @param[in] d     The byte to write
+///  @param[in] len   Number of bytes
+////////////////////////////////////////////////////////////////////////////////
+static void T6963_fill(uint16_t addr, uint8_t d, uint16_t len)
+{
+  T6963_setAddress(addr);
+  T6963_setAutoWrite();
+  for(uint16_t i = 0; i < len; i++)
+  {
+    waitAutoWrite();
+    putData(d);
+  }
+  T6963_setAutoReset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963_clearRow
+///  @brief  Blank one displayed text row with a single auto write
+///  @param[in] row  Row on screen (0 to height - 1)
+////////////////////////////////////////////////////////////////////////////////
+static void T6963_clearRow(uint8_t row)
+{
+  T6963_fill(textDisplayAddress + (uint16_t)row * width, 0, width);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963_scrollUp
+///  @brief  Scroll text up one row by moving the text home address.  The
+///          RAM from textBaseAddress to graphicBaseAddress is used as a ring
+///          of rows; the visible rows are only copied back to the start
+///          when the bottom of the screen reaches the end of the ring.
+////////////////////////////////////////////////////////////////////////////////
+static void T6963_scrollUp()
+{
+  uint16_t screen = (uint16_t)width * height;
+  uint16_t next = textDisplayAddress + width;
+  if(next + screen > graphicBaseAddress)
+  {
+    // out of ring, copy rows 1 to height - 1 to the start
+    uint8_t buf[40];
+    uint16_t len = screen - width;
+    uint16_t done = 0;
+    while(done < len)
+    {
+      uint16_t n = len - done;
+      if(n > sizeof(buf))
+      {
+        n = sizeof(buf);
+      }
+      T6963_setAddress(next + done);
+      T6963_setAutoRead();
+      for(uint16_t i = 0; i < n; i++)
+      {
+        waitAutoRead();
+        buf[i] = T6963_getData();
+      }
+      T6963_setAutoReset();
+      T6963_setAddress(textBaseAddress + done);
+      T6963_setAutoWrite();
+      for(uint16_t i = 0; i < n; i++)
+      {
+        T6963_writeDataByte(buf[i]);   // checks STA3 in auto write
+      }
+      T6963_setAutoReset();
+      done += n;
+    }
+    next = textBaseAddress;
+  }
+  T6963_setTextHomeAddress(next);
+  T6963_clearRow(height - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963_newline
+///  @brief  Move to the start of the next row, scrolling at the bottom
+////////////////////////////////////////////////////////////////////////////////
+static void T6963_newline()
+{
+  cursorX = 0;
+  cursorY++;
+  if(cursorY == height)
+  {
+    T6963_scrollUp();
+    cursorY = height - 1;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_printChar
-///  @brief  Print a single ASCII character to LCD
+///  @brief  Print a single ASCII character to LCD.  Handles BS, TAB, LF, FF
+///          and CR; the character after ESC is dropped.
 ///  @param[in] c Character to print
 ////////////////////////////////////////////////////////////////////////////////
 void T6963_printChar(char c)
 {
   static uint8_t  escaped = 0;
-  // TODO: make this more sophisticated
+  if(escaped)
+  {
+    escaped = 0;
+    return;
+  }
   switch(c)
   {
     case 8:
       // bs
+      if(cursorX > 0)
+      {
+        cursorX--;
+      }
       break;
     case 9:
       // tab
+      cursorX = (cursorX | 7) + 1;
+      if(cursorX >= width)
+      {
+        cursorX = width - 1;
+      }
       break;
     case 10:
       // lf
+      T6963_newline();
       break;
     case 12:
       // ff
+      T6963_textClear();
+      cursorX = 0;
+      cursorY = 0;
       break;
     case 13:
       // cr
+      cursorX = 0;
       break;
     case 27:
       escaped = 1;
       break;
     default:
-      c -= 32;
-      T6963_dataWriteIncrement(c);
-      cursorX++;
-      if(cursorX == width)
+      if(c >= ' ')
       {
-        cursorX = 0;
-        cursorY++;
+        T6963_setAddress(textDisplayAddress + (uint16_t)cursorY * width + cursorX);
+        T6963_dataWriteIncrement(c - 32);
+        cursorX++;
+        if(cursorX == width)
+        {
+          T6963_newline();
+        }
       }
+      break;
   }
-  T6963_dataWriteIncrement(c - 32);
-  cursorX++;
-  if(cursorX == width)
-  {
-    cursorX = 0;
-    cursorY++;
-    if(cursorY == height)
-    {
-      // scroll up
-    }
-  }
+  T6963_setCursor(cursorX, cursorY);
 }
 
 
@@ -925,29 +1219,20 @@ void T6963_printString(char* str)
   if(str != NULL)
   {
     char ch;
-    while( (ch = *str) != 0)
+    while( (ch = *str++) != 0)
     {
-      
+      T6963_printChar(ch);
     }
   }
 }
 
-////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_clear
-///  @brief  Clear all text and data from screen
-////////////////////////////////////////////////////////////////////////////////
-static void T6963_clear()
-{
-  
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn T6963_textClear
 ///  @brief  Clear all text from screen
 ////////////////////////////////////////////////////////////////////////////////
 static void T6963_textClear()
 {
-  
+  T6963_fill(textDisplayAddress, 0, (uint16_t)width * height);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -956,7 +1241,17 @@ static void T6963_textClear()
 ////////////////////////////////////////////////////////////////////////////////
 static void T6963_graphicsClear()
 {
-  
+  T6963_fill(graphicBaseAddress, 0, (uint16_t)width * height * 8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963_clear
+///  @brief  Clear all text and data from screen
+////////////////////////////////////////////////////////////////////////////////
+static void T6963_clear()
+{
+  T6963_textClear();
+  T6963_graphicsClear();
 }
 
 
@@ -989,31 +1284,19 @@ void setup()
   // put your setup code here, to run once:
   delay(100);
   ports_init();
+  T6963_init(240, 64, 6, 8192);
   T6963_setAddress(0);
   T6963_setCursor(0,0);
-  T6963_setTextHomeAddress(0);
-  T6963_setGraphicHomeAddress(2000);
+  T6963_setTextHomeAddress(textBaseAddress);
+  T6963_setGraphicHomeAddress(graphicBaseAddress);
   T6963_setDisplayMode(1,0,1,1);  // text, graphics, cursor, blink
  // T6963_setAddress(0);
-  T6963_setTextArea(64);
-  T6963_setGraphicArea(40);
+  T6963_setTextArea(width);
+  T6963_setGraphicArea(width);
   T6963_setOrMode(0);
-  width = 64;
-  cursorX = 0;
-  cursorY = 0;
   
   delay(100);
-  for(int i = 0; i < 800; i++)
-  {
-    T6963_dataWriteIncrement(0);
-  }
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 2000; i < 4000; i++)
-  {
-    T6963_writeDataByte(0);
-  }
-  T6963_setAutoReset();
+  T6963_clear();
   
   T6963_setAddress(0);
   for(uint8_t i = 0; i < 128; i++)
@@ -1026,37 +1309,25 @@ void setup()
   }
   delay(500);
 
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 0; i < 320; i++)
-  {
-    T6963_writeDataByte(0);  // space, clear screen
-  }
-  T6963_setAutoReset();
+  T6963_textClear();
   delay(500);
   
   T6963_setAddress(0);
   T6963_setAutoWrite();
-  for(int i = 0; i < 320; i++)
+  for(uint16_t i = 0; i < (uint16_t)width * height; i++)
   {
     T6963_writeDataByte( (uint8_t) (i & 0x7f) );
   }
   T6963_setAutoReset();
   delay(2000);
-  T6963_setAddress(2000);
-  T6963_setAutoWrite();
-  for(int i = 2000; i < 4000; i++)
-  {
-    T6963_writeDataByte( 0x55);
-  }
-  T6963_setAutoReset();
+  T6963_fill(graphicBaseAddress, 0x55, (uint16_t)width * height * 8);
 //  for(int i = 0; i <20; i++)
 //  {
 //    T6963_setTextHomeAddress(i);
 //    delay(200);
 //  }
 
-  for(int x = 0; x <50; x++)
+  for(int x = 0; x < width; x++)
   {
     T6963_setCursor(x,3);
     delay(200);
@@ -4,8 +4,19 @@
 /// @brief Controls 240x64 T6963 display using T6963 (DG-24064-09-S2RB)
 //////////////////////////////////////////////////////////////////////////////
 
-#include T6963.h
+#include "T6963.h"
+#if T6963_BUS == T6963_BUS_FAST
+#include "T6963_fast.h"
+#endif
 
+// Time an API call into its histogram when instrumentation is built in
+#if T6963_TRACE
+#define T6963_TIME_START()      unsigned long opStart = micros()
+#define T6963_TIME_STOP(op)     timeOp(op, micros() - opStart)
+#else
+#define T6963_TIME_START()
+#define T6963_TIME_STOP(op)
+#endif
 
 
 
@@ -20,21 +31,40 @@
 
 enum pinmap
 {
-  PIN_D0    0,
-  PIN_D1    1,
-  PIN_D2    2,
-  PIN_D3    3,
-  PIN_D4    4,
-  PIN_D5    5,
-  PIN_D6    6,
-  PIN_D7    7,
-  PIN_WR    8,
-  PIN_RD    9,
-  PIN_CE   10,
-  PIN_CD   11,
-  PIN_RES  12,
-  PIN_FS   13
-}
+  PIN_D0   = 0,
+  PIN_D1   = 1,
+  PIN_D2   = 2,
+  PIN_D3   = 3,
+  PIN_D4   = 4,
+  PIN_D5   = 5,
+  PIN_D6   = 6,
+  PIN_D7   = 7,
+  PIN_WR   = 8,
+  PIN_RD   = 9,
+  PIN_CE   = 10,
+  PIN_CD   = 11,
+  PIN_RES  = 12,
+  PIN_FS   = 13
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  register cache
+///  @brief which bit of cacheValid says a cached register value is known
+////////////////////////////////////////////////////////////////////////////////
+
+enum cachebits
+{
+  CACHE_ADDRESS       = (1 << 0),
+  CACHE_TEXT_HOME     = (1 << 1),
+  CACHE_TEXT_AREA     = (1 << 2),
+  CACHE_GRAPHIC_HOME  = (1 << 3),
+  CACHE_GRAPHIC_AREA  = (1 << 4),
+  CACHE_OFFSET        = (1 << 5),
+  CACHE_CURSOR        = (1 << 6),
+  CACHE_MODE          = (1 << 7),
+  CACHE_DISPLAY       = (1 << 8),
+  CACHE_CURSOR_SIZE   = (1 << 9)
+};
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -57,7 +87,7 @@ enum pinmap
 ////////////////////////////////////////////////////////////////////////////////
 
 T6963::T6963(int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7, 
-             int wr, int rd, int ce, int cd, int res = 0, int fs = 0)
+             int wr, int rd, int ce, int cd, int res, int fs)
 {
   pins[PIN_D0] = d0;
   pins[PIN_D1] = d1;
@@ -73,67 +103,305 @@ T6963::T6963(int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7,
   pins[PIN_CD] = cd;
   pins[PIN_RES] = res;
   pins[PIN_FS] = fs;
-  
-              
+  fontWidth = 6;
+  init_state();
+}
+
+#if T6963_BUS == T6963_BUS_EXTERNAL
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963
+///  @brief  Constructor for the external bus backend.  No pins are used.
+///  @param[in] bus  The byte level bus to drive, e.g. a T6963Emulator
+////////////////////////////////////////////////////////////////////////////////
+T6963::T6963(T6963Bus& bus)
+{
+  for(int p = 0; p < 14; p++)
+  {
+    pins[p] = 0;
+  }
+  this->bus = &bus;
+  fontWidth = 6;
+  init_state();
+}
+#endif
+
+#if T6963_BUS == T6963_BUS_FAST
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963
+///  @brief  Constructor for the fast backend.  The pins are the template
+///          parameters of T6963_FAST_BUS, so none are stored here.
+////////////////////////////////////////////////////////////////////////////////
+T6963::T6963()
+{
+  for(int p = 0; p < 14; p++)
+  {
+    pins[p] = 0;
+  }
+  fontWidth = 6;
+  init_state();
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn init_state
+///  @brief  Resets the cached controller state to power-on values
+////////////////////////////////////////////////////////////////////////////////
+void T6963::init_state()
+{
+  busDirection = -1;
+  readyStrategy = T6963_READY_POLL;
+  spinLimit = T6963_SPIN_LIMIT;
+  for(uint8_t c = 0; c < T6963_READY_CLASSES; c++)
+  {
+    readyDelay[c] = 0;
+  }
+  lastClass = T6963_CLASS_COMMAND;
+  calibrating = false;
+  timeouts = 0;
+  cacheValid = 0;
+  skippedCommands = 0;
+  skippedAddressSets = 0;
+  mode = 0;
+  displayMode = 0;
+  cursorSize = 0;
+  autoMode = 0;
+  cursorPointer = 0;
+  offsetPointer = 0;
+  addressPointer = 0;
+  textHomeAddress = 0;
+  textArea = 0;
+  graphicHomeAddres = 0;
+  graphicArea = 0;
+  panelWidth = 0;
+  panelHeight = 0;
+  drawPage = false;
+  textDrawAddress = 0;
+  graphicDrawAddress = 0;
+  screenError = false;
+#if T6963_TRACE
+  resetStats();
+  tracing = false;
+  traceHead = 0;
+  traceCount = 0;
+  traceLost = 0;
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn ports_init
-///  @brief  Initializes all gpio ports for use
+///  @brief  Initializes all gpio ports for use and resets the panel where
+///          RES is wired.  Every backend then forgets the cached controller
+///          registers and any auto mode; settings made on this object
+///          (ready strategy, delays, panel size, draw page) are kept.
 ///  @return  True if initialized, false otherwise
 ////////////////////////////////////////////////////////////////////////////////
 bool T6963::ports_init()
 {
   bool rtn = false;
   
-  pinMode(pins[PIN_CE], OUTPUT);
-  digitalWrite(pins[PIN_CE], HIGH);
-  pinMode(pins[PIN_WR], OUTPUT);
-  digitalWrite(pins[PIN_WR], HIGH);
-  pinMode(pins[PIN_RD], OUTPUT);
-  digitalWrite(pins[PIN_CD], HIGH);
-  pinMode(pins[PIN_CD], OUTPUT);
+#if T6963_BUS == T6963_BUS_EXTERNAL
+  rtn = (bus != NULL);
+#elif T6963_BUS == T6963_BUS_FAST
+  T6963_FAST_BUS::ports_init(fontWidth);
+  rtn = true;
+#else
+#if T6963_BUS == T6963_BUS_PORT
+  if(bus_init())
+#endif
+  {
+    pinMode(pins[PIN_CE], OUTPUT);
+    setControl(PIN_CE, HIGH);
+    pinMode(pins[PIN_WR], OUTPUT);
+    setControl(PIN_WR, HIGH);
+    pinMode(pins[PIN_RD], OUTPUT);
+    setControl(PIN_RD, HIGH);
+    setControl(PIN_CD, HIGH);
+    pinMode(pins[PIN_CD], OUTPUT);
+
+    if(pins[PIN_RES] != 0)
+    {
+      pinMode(pins[PIN_RES], OUTPUT);
+      digitalWrite(pins[PIN_RES], LOW);   // Reset while we're here
+    }
+    if(pins[PIN_FS] != 0)
+    {
+      pinMode(pins[PIN_FS], OUTPUT);
+      digitalWrite(pins[PIN_FS], fontWidth == 8 ? LOW : HIGH);  // HIGH: 6x8, LOW: 8x8
+    }
+
+    busDirection = -1;    // unknown, force the first switch
+    setDataDirection(OUTPUT);
 
-  if(pins[PIN_RES] != 0)
+    delay(5);  // Give RESET 5 milliseconds
+    if(pins[PIN_RES] != 0)
+    {
+      digitalWrite(pins[PIN_RES], HIGH);
+    }
+
+    rtn = true;
+  }
+#endif
+  invalidateCache();
+  autoMode = 0;
+  return rtn;
+}
+
+#if T6963_BUS == T6963_BUS_PORT
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn bus_init
+///  @brief  Maps the pins[] layout onto port registers for the port backend.
+///          Data bits on consecutive bits of the same port are grouped into
+///          one run so each run costs a single register access per byte.
+///  @return  True if mapped, false if a data pin has no single port bit
+////////////////////////////////////////////////////////////////////////////////
+bool T6963::bus_init()
+{
+  bool rtn = true;
+  numRuns = 0;
+  for(int b = 0; b < 8 && rtn; b++)
   {
-    pinMode(pins[PIN_RES], OUTPUT);
-    digitalWrite(pins[PIN_RES], LOW);   // Reset while we're here
+    uint8_t pin = pins[PIN_D0 + b];
+    uint8_t port = digitalPinToPort(pin);
+    T6963_PORT_REG_TYPE mask = digitalPinToBitMask(pin);
+    int8_t bit = 0;
+    while(bit < (int8_t)(sizeof(T6963_PORT_REG_TYPE) * 8) &&
+          (T6963_PORT_REG_TYPE)((T6963_PORT_REG_TYPE)1 << bit) != mask)
+    {
+      bit++;
+    }
+
+    PortRun* r = (numRuns > 0) ? &runs[numRuns - 1] : NULL;
+    if(bit == (int8_t)(sizeof(T6963_PORT_REG_TYPE) * 8))
+    {
+      rtn = false;    // not a pin, or no single bit (mask 0)
+    }
+    else if(r != NULL && r->out == portOutputRegister(port) &&
+            (r->dataMask & (1 << (b - 1))) && r->shift == bit - b)
+    {
+      r->portMask |= mask;   // extends the previous run
+      r->dataMask |= (1 << b);
+    }
+    else
+    {
+      r = &runs[numRuns++];
+      r->out = portOutputRegister(port);
+      r->in = portInputRegister(port);
+      r->mode = portModeRegister(port);
+      r->portMask = mask;
+      r->dataMask = (1 << b);
+      r->shift = bit - b;
+    }
   }
-  if(pins[PIN_FS] != 0)
+
+  for(int c = 0; c < 4; c++)
   {
-    pinMode(pins[PIN_FS], OUTPUT);
-    digitalWrite(pins[PIN_FS], HIGH);  // 6x8 font
+    ctrlOut[c] = portOutputRegister(digitalPinToPort(pins[PIN_WR + c]));
+    ctrlMask[c] = digitalPinToBitMask(pins[PIN_WR + c]);
   }
-  
-  setDataDirection(OUTPUT);
-  
-  delay(5);  // Give RESET 5 milliseconds
-  digitalWrite(pins[PIN_RES], HIGH);
+  return rtn;
+}
 
-  rtn = true;
+////////////////////////////////////////////////////////////////////////////////
+///  @fn applyDataDirection
+///  @brief  Drives the Data Bus pins direction registers
+///  @param[in]  INPUT, OUTPUT to choose direction
+////////////////////////////////////////////////////////////////////////////////
+
+void T6963::applyDataDirection(int dir)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  for(uint8_t r = 0; r < numRuns; r++)
+  {
+    if(dir == OUTPUT)
+    {
+      *runs[r].mode |= runs[r].portMask;
+    }
+    else
+    {
+      *runs[r].mode &= ~runs[r].portMask;
+      *runs[r].out &= ~runs[r].portMask;  // no pull-ups
+    }
+  }
+  SREG = oldSREG;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setDataBits
+///  @brief Sets output data onto data bus pins
+///  @param[in] d: Byte to set on bus pins
+////////////////////////////////////////////////////////////////////////////////
+
+void T6963::setDataBits(uint8_t d)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  for(uint8_t r = 0; r < numRuns; r++)
+  {
+    const PortRun& run = runs[r];
+    T6963_PORT_REG_TYPE v = d & run.dataMask;
+    v = (run.shift >= 0) ? (v << run.shift) : (v >> -run.shift);
+    *run.out = (*run.out & ~run.portMask) | v;
+  }
+  SREG = oldSREG;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn getDataBits
+///  @brief  Reads data bus pins
+///  @return  Byte value read from pins
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t T6963::getDataBits()
+{
+  uint8_t rtn = 0;
+  for(uint8_t r = 0; r < numRuns; r++)
+  {
+    const PortRun& run = runs[r];
+    T6963_PORT_REG_TYPE v = *run.in & run.portMask;
+    rtn |= (run.shift >= 0) ? (v >> run.shift) : (v << -run.shift);
+  }
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn setDataDirection
-///  @brief  Sets Data Bus pins direction
+///  @fn setControl
+///  @brief  Drives one of the WR, RD, CE, CD control lines
+///  @param[in] pin   PIN_WR, PIN_RD, PIN_CE or PIN_CD
+///  @param[in] level HIGH or LOW
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setControl(uint8_t pin, uint8_t level)
+{
+  uint8_t c = pin - PIN_WR;
+  uint8_t oldSREG = SREG;
+  cli();
+  if(level == LOW)
+  {
+    *ctrlOut[c] &= ~ctrlMask[c];
+  }
+  else
+  {
+    *ctrlOut[c] |= ctrlMask[c];
+  }
+  SREG = oldSREG;
+}
+
+#else  // T6963_BUS_DIGITAL
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn applyDataDirection
+///  @brief  Drives the Data Bus pins direction registers
 ///  @param[in]  INPUT, OUTPUT to choose direction
 ////////////////////////////////////////////////////////////////////////////////
 
-void T6963::setDataDirection(int dir)
+void T6963::applyDataDirection(int dir)
 {
   for(int p = PIN_D0; p <= PIN_D7; p++)  // assumes data pins in order in array
   {
     pinMode(pins[p], dir);
   }
-//  pinMode(T6963_D0, dir);
-//  pinMode(T6963_D1, dir);
-//  pinMode(T6963_D2, dir);
-//  pinMode(T6963_D3, dir);
-//  pinMode(T6963_D4, dir);
-//  pinMode(T6963_D5, dir);
-//  pinMode(T6963_D6, dir);
-//  pinMode(T6963_D7, dir);
 }
 
 
@@ -147,24 +415,9 @@ void T6963::setDataBits(uint8_t d)
 {
   for(int b = 0; b < 8; b++)   // assumes data pins in order (0 to 7) in array
   {
-    digitalWrite(pins[PIN_D0 + b], d & 0x01)
+    digitalWrite(pins[PIN_D0 + b], d & 0x01);
     d >>= 1;
   }
-  //digitalWrite(T6963_D0, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D1, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D2, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D3, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D4, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D5, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D6, d & 0x01);
-  //d >>= 1;
-  //digitalWrite(T6963_D7, d & 0x01);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -184,43 +437,58 @@ uint8_t T6963::getDataBits()
       rtn |= 0x01;
     }
   }
-  
-//  if(digitalRead(T6963_D7) == HIGH)
-//  {
-//    rtn |= (1 << 7);
-//  }
-//  if(digitalRead(T6963_D6) == HIGH)
-//  {
-//    rtn |= (1 << 6);
-//  }
-//  if(digitalRead(T6963_D5) == HIGH)
-//  {
-//    rtn |= (1 << 5);
-//  }
-//  if(digitalRead(T6963_D4) == HIGH)
-//  {
-//    rtn |= (1 << 4);
-//  }
-//  if(digitalRead(T6963_D3) == HIGH)
-//  {
-//    rtn |= (1 << 3);
-//  }
-//  if(digitalRead(T6963_D2) == HIGH)
-//  {
-//    rtn |= (1 << 2);
-//  }
-//  if(digitalRead(T6963_D1) == HIGH)
-//  {
-//    rtn |= (1 << 1);
-//  }
-//  if(digitalRead(T6963_D0) == HIGH)
-//  {
-//    rtn |= (1 << 0);
-//  }
-
   return rtn;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setControl
+///  @brief  Drives one of the WR, RD, CE, CD control lines
+///  @param[in] pin   PIN_WR, PIN_RD, PIN_CE or PIN_CD
+///  @param[in] level HIGH or LOW
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setControl(uint8_t pin, uint8_t level)
+{
+  digitalWrite(pins[pin], level);
+}
+
+#endif  // T6963_BUS
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setFontWidth
+///  @brief  Select the 6x8 or 8x8 font.  Drives FS if it is wired, otherwise
+///          records how the panel's FS is strapped.  Text columns and
+///          graphic bytes are fontWidth pixels wide.
+///  @param[in] width  6 or 8
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setFontWidth(uint8_t width)
+{
+  fontWidth = (width == 8) ? 8 : 6;
+#if T6963_BUS == T6963_BUS_FAST
+  T6963_FAST_BUS::setFontWidth(fontWidth);
+#else
+  if(pins[PIN_FS] != 0)
+  {
+    digitalWrite(pins[PIN_FS], fontWidth == 8 ? LOW : HIGH);
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setDataDirection
+///  @brief  Sets Data Bus pins direction, only touching the pins when the
+///          bus is not already in that direction.  Reads leave the bus as
+///          input; the next write switches it back.
+///  @param[in]  INPUT, OUTPUT to choose direction
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setDataDirection(int dir)
+{
+  if(busDirection != dir)
+  {
+    applyDataDirection(dir);
+    busDirection = dir;
+  }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn getStatus
@@ -230,16 +498,23 @@ uint8_t T6963::getDataBits()
 uint8_t T6963::getStatus()
 {
   uint8_t rtn = 0;
+#if T6963_TRACE
+  stats.statusPolls++;
+#endif
+#if T6963_BUS == T6963_BUS_EXTERNAL
+  rtn = bus->read(HIGH);
+#elif T6963_BUS == T6963_BUS_FAST
+  rtn = T6963_FAST_BUS::read(HIGH);
+#else
   setDataDirection(INPUT);
-  digitalWrite(pins[PIN_CD], HIGH);
-  digitalWrite(pins[PIN_RD], LOW);
-  digitalWrite(pins[PIN_CE], LOW);
+  setControl(PIN_CD, HIGH);
+  setControl(PIN_RD, LOW);
+  setControl(PIN_CE, LOW);
   rtn = getDataBits();
-  digitalWrite(pins[PIN_CE], HIGH);
-  digitalWrite(pins[PIN_RD], HIGH);
-  setDataDirection(OUTPUT);
+  setControl(PIN_CE, HIGH);
+  setControl(PIN_RD, HIGH);
+#endif
   return rtn;
-  
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -250,17 +525,79 @@ uint8_t T6963::getStatus()
 uint8_t T6963::getData()
 {
   uint8_t rtn = 0;
+  lastClass = (autoMode != 0) ? T6963_CLASS_AUTO : T6963_CLASS_DATA;
+#if T6963_BUS == T6963_BUS_EXTERNAL
+  rtn = bus->read(LOW);
+#elif T6963_BUS == T6963_BUS_FAST
+  rtn = T6963_FAST_BUS::read(LOW);
+#else
   setDataDirection(INPUT);
-  digitalWrite(pins[PIN_CD], LOW);
-  digitalWrite(pins[PIN_RD], LOW);
-  digitalWrite(pins[PIN_CE], LOW);
+  setControl(PIN_CD, LOW);
+  setControl(PIN_RD, LOW);
+  setControl(PIN_CE, LOW);
  // delay(1);
   rtn = getDataBits();
-  digitalWrite(pins[PIN_CE], HIGH);
-  digitalWrite(pins[PIN_RD], HIGH);
-  setDataDirection(OUTPUT);
+  setControl(PIN_CE, HIGH);
+  setControl(PIN_RD, HIGH);
+#endif
+#if T6963_TRACE
+  stats.dataReads++;
+  record(T6963_REC_READ, rtn);
+#endif
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn waitStatus
+///  @brief  Waits until all bits in mask are set in the status byte, using
+///          the selected ready strategy.  T6963_READY_DELAY skips the status
+///          read and waits the calibrated time for the previous operation.
+///  @param[in] mask  Status bits that must be set
+///  @return  True if ready, false if T6963_READY_BOUNDED gave up
+////////////////////////////////////////////////////////////////////////////////
+bool T6963::waitStatus(uint8_t mask)
+{
+  bool rtn = true;
+  if(readyStrategy == T6963_READY_DELAY)
+  {
+    if(readyDelay[lastClass] != 0)
+    {
+      delayMicroseconds(readyDelay[lastClass]);
+    }
+  }
+  else
+  {
+    uint16_t spins = 0;
+    unsigned long start = calibrating ? micros() : 0;
+    while(rtn && (getStatus() & mask) != mask)
+    {
+      if(spins < 0xffff)
+      {
+        spins++;
+      }
+      if(readyStrategy == T6963_READY_BOUNDED && spins >= spinLimit)
+      {
+        timeouts++;
+        rtn = false;
+      }
+    }
+#if T6963_TRACE
+    if(spins != 0)
+    {
+      stats.spins += spins;
+      record(T6963_REC_POLLS, (spins > 0xff) ? 0xff : spins);
+    }
+#endif
+    if(calibrating)
+    {
+      unsigned long us = micros() - start + 1;  // round up
+      if(us > readyDelay[lastClass])
+      {
+        readyDelay[lastClass] = (us > 0xffff) ? 0xffff : us;
+      }
+    }
+  }
   return rtn;
-  
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -269,7 +606,7 @@ uint8_t T6963::getData()
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::wait()
 {
-  while(getStatus() & 0x03 != 3);
+  waitStatus(0x03);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -278,7 +615,7 @@ void T6963::wait()
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::waitAuto()
 {
-  while(getStatus() & 0x0c == 0);  // wait while neither bit set
+  waitStatus(autoMode == T6963_AUTO_READ_SET ? 0x04 : 0x08);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -287,7 +624,7 @@ void T6963::waitAuto()
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::waitAutoRead()
 {
-  while(getStatus() & 0x04 != 4);
+  waitStatus(0x04);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -296,25 +633,158 @@ void T6963::waitAutoRead()
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::waitAutoWrite()
 {
-  while(getStatus() & 0x08 != 8);
+  waitStatus(0x08);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn writeDataByte
-///  @brief  Send a byte of data to controller
+///  @fn setReadyStrategy
+///  @brief  Choose how the driver waits for the controller
+///  @param[in] strategy   T6963_READY_POLL, T6963_READY_BOUNDED or
+///                        T6963_READY_DELAY
+///  @param[in] limit      Status reads before T6963_READY_BOUNDED gives up
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setReadyStrategy(uint8_t strategy, uint16_t limit)
+{
+  readyStrategy = strategy;
+  spinLimit = (limit == 0) ? 1 : limit;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setReadyDelay
+///  @brief  Set the fixed wait used by T6963_READY_DELAY after an operation
+///  @param[in] cls  T6963_CLASS_DATA, T6963_CLASS_COMMAND or T6963_CLASS_AUTO
+///  @param[in] us   Microseconds to wait, 0 for none
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setReadyDelay(uint8_t cls, uint16_t us)
+{
+  if(cls < T6963_READY_CLASSES)
+  {
+    readyDelay[cls] = us;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn getReadyDelay
+///  @return  Wait used by T6963_READY_DELAY after the given operation class
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963::getReadyDelay(uint8_t cls)
+{
+  uint16_t rtn = 0;
+  if(cls < T6963_READY_CLASSES)
+  {
+    rtn = readyDelay[cls];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn calibrate
+///  @brief  Measure the real busy time of each operation class by polling
+///          with micros() timing, and store it for T6963_READY_DELAY.
+///          Reads 8 bytes at address 0 and writes them back unchanged.
+///          The previous ready strategy is restored afterwards.
+////////////////////////////////////////////////////////////////////////////////
+void T6963::calibrate()
+{
+  uint8_t saved = readyStrategy;
+  uint8_t buf[8];
+
+  readyStrategy = T6963_READY_POLL;
+  for(uint8_t c = 0; c < T6963_READY_CLASSES; c++)
+  {
+    readyDelay[c] = 0;
+  }
+  calibrating = true;
+  invalidateCache();    // make sure real commands go out
+  for(uint8_t pass = 0; pass < 4; pass++)
+  {
+    readBlock(0, buf, sizeof(buf));
+    invalidateCache();
+    writeBlock(0, buf, sizeof(buf));
+    invalidateCache();
+  }
+  calibrating = false;
+  readyStrategy = saved;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn putData
+///  @brief  Strobe a data byte onto the bus without any status check
 ///  @param[in]  dat The data byte to send
 ////////////////////////////////////////////////////////////////////////////////
-void T6963::writeDataByte(uint8_t dat)
+void T6963::putData(uint8_t dat)
 {
-  wait();
+  lastClass = (autoMode != 0) ? T6963_CLASS_AUTO : T6963_CLASS_DATA;
+#if T6963_TRACE
+  stats.dataBytes++;
+  record(T6963_REC_DATA, dat);
+#endif
+#if T6963_BUS == T6963_BUS_EXTERNAL
+  bus->write(LOW, dat);
+#elif T6963_BUS == T6963_BUS_FAST
+  T6963_FAST_BUS::write(LOW, dat);
+#else
   setDataDirection(OUTPUT);
   setDataBits(dat);
-  digitalWrite(T6963_CD, LOW);
-  digitalWrite(T6963_WR, LOW);
-  digitalWrite(T6963_CE, LOW);
+  setControl(PIN_CD, LOW);
+  setControl(PIN_WR, LOW);
+  setControl(PIN_CE, LOW);
  // delay(1);
-  digitalWrite(T6963_CE, HIGH);  // min pulse width 80 nS
-  digitalWrite(T6963_WR, HIGH);
+  setControl(PIN_CE, HIGH);  // min pulse width 80 nS
+  setControl(PIN_WR, HIGH);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn putCommand
+///  @brief  Strobe a command byte onto the bus without any status check
+///  @param[in] cmd The command byte to send
+////////////////////////////////////////////////////////////////////////////////
+void T6963::putCommand(uint8_t cmd)
+{
+  lastClass = T6963_CLASS_COMMAND;
+#if T6963_TRACE
+  stats.commandBytes++;
+  if(cmd == T6963_AUTO_WRITE_SET || cmd == T6963_AUTO_READ_SET)
+  {
+    stats.autoBursts++;
+  }
+  record(T6963_REC_COMMAND, cmd);
+#endif
+#if T6963_BUS == T6963_BUS_EXTERNAL
+  bus->write(HIGH, cmd);
+#elif T6963_BUS == T6963_BUS_FAST
+  T6963_FAST_BUS::write(HIGH, cmd);
+#else
+  setDataDirection(OUTPUT);
+  setDataBits(cmd);
+  setControl(PIN_CD, HIGH);
+  setControl(PIN_WR, LOW);
+  setControl(PIN_CE, LOW);
+ // delay(1);
+  setControl(PIN_CE, HIGH);  // min pulse width 80 nS
+  setControl(PIN_WR, HIGH);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeDataByte
+///  @brief  Send a byte of data to controller.  In auto write mode this
+///          checks STA3 instead of STA0/STA1, as the datasheet requires.
+///  @param[in]  dat The data byte to send
+////////////////////////////////////////////////////////////////////////////////
+void T6963::writeDataByte(uint8_t dat)
+{
+  if(autoMode == T6963_AUTO_WRITE_SET)
+  {
+    waitAutoWrite();
+    addressPointer++;   // each auto write advances the pointer
+  }
+  else
+  {
+    wait();
+  }
+  putData(dat);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -325,35 +795,137 @@ void T6963::writeDataByte(uint8_t dat)
 void T6963::writeCommandByte(uint8_t cmd)
 {
   wait();
-  setDataDirection(OUTPUT);
-  setDataBits(cmd);
-  digitalWrite(T6963_CD, HIGH);
-  digitalWrite(T6963_WR, LOW);
-  digitalWrite(T6963_CE, LOW);
- // delay(1);
-  digitalWrite(T6963_CE, HIGH);  // min pulse width 80 nS
-  digitalWrite(T6963_WR, HIGH);
+  putCommand(cmd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn tryDataByte
+///  @brief  Send a data byte only if the controller is ready now.  Reads
+///          status once (STA3 in auto write, STA0/STA1 otherwise) whatever
+///          the ready strategy, and never waits.
+///  @param[in]  dat The data byte to send
+///  @return  True if sent, false if the controller was busy
+////////////////////////////////////////////////////////////////////////////////
+bool T6963::tryDataByte(uint8_t dat)
+{
+  bool rtn = false;
+  uint8_t mask = (autoMode == T6963_AUTO_WRITE_SET) ? 0x08 : 0x03;
+  if( (getStatus() & mask) == mask)
+  {
+    if(autoMode == T6963_AUTO_WRITE_SET)
+    {
+      addressPointer++;
+    }
+    putData(dat);
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn tryCommandByte
+///  @brief  Send a command byte only if the controller is ready now.  Auto
+///          write/read set and auto reset are tracked as by setAutoWrite etc.
+///          Any other command may change registers behind the cache, so the
+///          cache is dropped.
+///  @param[in] cmd The command byte to send
+///  @return  True if sent, false if the controller was busy
+////////////////////////////////////////////////////////////////////////////////
+bool T6963::tryCommandByte(uint8_t cmd)
+{
+  bool rtn = false;
+  uint8_t mask = 0x03;
+  if(autoMode == T6963_AUTO_WRITE_SET)
+  {
+    mask = 0x08;
+  }
+  else if(autoMode == T6963_AUTO_READ_SET)
+  {
+    mask = 0x04;
+  }
+  if( (getStatus() & mask) == mask)
+  {
+    putCommand(cmd);
+    if(cmd == T6963_AUTO_WRITE_SET || cmd == T6963_AUTO_READ_SET)
+    {
+      autoMode = cmd;
+    }
+    else if( (cmd & 0xfe) == T6963_AUTO_RESET)
+    {
+      autoMode = 0;
+    }
+    else
+    {
+      cacheValid = 0;
+    }
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn isCached
+///  @brief  Checks whether the controller already holds a register value.
+///          Counts the skipped command when it does.
+///  @param[in] bit   The cachebits flag for the register
+///  @param[in] cur   The cached register value
+///  @param[in] val   The value about to be sent
+///  @return  True if the command can be skipped
+////////////////////////////////////////////////////////////////////////////////
+bool T6963::isCached(uint16_t bit, uint16_t cur, uint16_t val)
+{
+  bool rtn = false;
+  if( (cacheValid & bit) != 0 && cur == val)
+  {
+    skippedCommands++;
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn invalidateCache
+///  @brief  Forget all cached register values, e.g. after raw commands sent
+///          with writeCommandByte or a reset of the panel.
+////////////////////////////////////////////////////////////////////////////////
+void T6963::invalidateCache()
+{
+  cacheValid = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCacheCounters
+///  @brief  Zero the skipped command counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963::resetCacheCounters()
+{
+  skippedCommands = 0;
+  skippedAddressSets = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn setCursor
 ///  @brief  Set cursor location
-///  @param[in] x The horizontal coordinate (0 to 127)
-///  @param[in] y The vertical coordinate (0 to 63)
+///  @param[in] x The text column (0 to 127, and inside the text area)
+///  @param[in] y The text row (0 to 31, and on the panel if its size is set)
 ///  @return  Zero on success, -1 if out of bounds
 ////////////////////////////////////////////////////////////////////////////////
 int T6963::setCursor(int x, int y)
 {
   int rtn = 0;
-  if(x < 0 || x > 127 || y < 0 || y > 63)
+  if(x < 0 || x > 127 || y < 0 || y > 31 ||
+     (textArea != 0 && x >= textArea) ||
+     (panelHeight != 0 && y >= panelHeight / 8))
   {
     rtn = -1;
   }
-  else
+  else if(!isCached(CACHE_CURSOR, cursorPointer, (y << 8) | x))
   {
     writeDataByte(x);
     writeDataByte(y);
     writeCommandByte(T6963_SET_CURSOR_POINTER);
+    cursorPointer = (y << 8) | x;
+    cacheValid |= CACHE_CURSOR;
   }
   return rtn;
 }
@@ -372,11 +944,13 @@ int T6963::setOffsetPointer(uint8_t offs)
   {
     rtn = -1;
   }
-  else
+  else if(!isCached(CACHE_OFFSET, offsetPointer, offs))
   {
     writeDataByte(offs);
     writeDataByte(0);
     writeCommandByte(T6963_SET_OFFSET_REGISTER);
+    offsetPointer = offs;
+    cacheValid |= CACHE_OFFSET;
   }
   return rtn;
 }
@@ -389,9 +963,26 @@ int T6963::setOffsetPointer(uint8_t offs)
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::setAddress(uint16_t addr)
 {
-  writeDataByte(addr & 0xff); // low byte
-  writeDataByte( (addr >> 8) & 0xff);  // high byte
-  writeCommandByte(T6963_SET_ADDRESS_POINTER);
+  T6963_TIME_START();
+  if(isCached(CACHE_ADDRESS, addressPointer, addr))
+  {
+    skippedAddressSets++;
+#if T6963_TRACE
+    stats.redundantAddressSets++;
+#endif
+  }
+  else
+  {
+    writeDataByte(addr & 0xff); // low byte
+    writeDataByte( (addr >> 8) & 0xff);  // high byte
+    writeCommandByte(T6963_SET_ADDRESS_POINTER);
+    addressPointer = addr;
+    cacheValid |= CACHE_ADDRESS;
+#if T6963_TRACE
+    stats.addressSets++;
+#endif
+  }
+  T6963_TIME_STOP(T6963_OP_SET_ADDRESS);
 }
 
 
@@ -402,9 +993,14 @@ void T6963::setAddress(uint16_t addr)
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::setTextHomeAddress(uint16_t addr)
 {
-  writeDataByte(addr & 0xff);
-  writeDataByte( (addr >> 8) & 0xff);
-  writeCommandByte(T6963_SET_TEXT_HOME_ADDRESS);
+  if(!isCached(CACHE_TEXT_HOME, textHomeAddress, addr))
+  {
+    writeDataByte(addr & 0xff);
+    writeDataByte( (addr >> 8) & 0xff);
+    writeCommandByte(T6963_SET_TEXT_HOME_ADDRESS);
+    textHomeAddress = addr;
+    cacheValid |= CACHE_TEXT_HOME;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -414,9 +1010,50 @@ void T6963::setTextHomeAddress(uint16_t addr)
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::setGraphicHomeAddress(uint16_t addr)
 {
-  writeDataByte(addr & 0xff);
-  writeDataByte( (addr >> 8) & 0xff);
-  _writeCommandByte(T6963_SET_GRAPHIC_HOME_ADDRESS);
+  if(!isCached(CACHE_GRAPHIC_HOME, graphicHomeAddres, addr))
+  {
+    writeDataByte(addr & 0xff);
+    writeDataByte( (addr >> 8) & 0xff);
+    writeCommandByte(T6963_SET_GRAPHIC_HOME_ADDRESS);
+    graphicHomeAddres = addr;
+    cacheValid |= CACHE_GRAPHIC_HOME;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setPanelSize
+///  @brief  Record the panel size so cursor positions can be range checked
+///  @param[in] width   Panel width in pixels
+///  @param[in] height  Panel height in pixels
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setPanelSize(uint16_t width, uint8_t height)
+{
+  panelWidth = width;
+  panelHeight = height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setDrawPage
+///  @brief  Send drawing to RAM other than the displayed text and graphic
+///          areas, e.g. the back page when page flipping.  Classes that
+///          draw use getTextDrawAddress / getGraphicDrawAddress.
+///  @param[in] text     RAM address of the text page to draw on
+///  @param[in] graphic  RAM address of the graphic page to draw on
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setDrawPage(uint16_t text, uint16_t graphic)
+{
+  textDrawAddress = text;
+  graphicDrawAddress = graphic;
+  drawPage = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clearDrawPage
+///  @brief  Draw on the displayed text and graphic areas again
+////////////////////////////////////////////////////////////////////////////////
+void T6963::clearDrawPage()
+{
+  drawPage = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -426,9 +1063,14 @@ void T6963::setGraphicHomeAddress(uint16_t addr)
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::setTextArea(uint8_t cols)
 {
-  writeDataByte(cols);
-  writeDataByte(0);
-  writeCommandByte(T6963_SET_TEXT_AREA);
+  if(!isCached(CACHE_TEXT_AREA, textArea, cols))
+  {
+    writeDataByte(cols);
+    writeDataByte(0);
+    writeCommandByte(T6963_SET_TEXT_AREA);
+    textArea = cols;
+    cacheValid |= CACHE_TEXT_AREA;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -438,9 +1080,29 @@ void T6963::setTextArea(uint8_t cols)
 ////////////////////////////////////////////////////////////////////////////////
 void T6963::setGraphicArea(uint8_t cols)
 {
-  writeDataByte(cols);
-  writeDataByte(0);
-  writeCommandByte(T6963_SET_GRAPHIC_AREA);
+  if(!isCached(CACHE_GRAPHIC_AREA, graphicArea, cols))
+  {
+    writeDataByte(cols);
+    writeDataByte(0);
+    writeCommandByte(T6963_SET_GRAPHIC_AREA);
+    graphicArea = cols;
+    cacheValid |= CACHE_GRAPHIC_AREA;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setMode
+///  @brief Send a mode set command unless the controller already has it
+///  @param[in] cmd T6963_SET_MODE plus logic mode and CG bits
+////////////////////////////////////////////////////////////////////////////////
+void T6963::setMode(uint8_t cmd)
+{
+  if(!isCached(CACHE_MODE, mode, cmd))
+  {
+    writeCommandByte(cmd);
+    mode = cmd;
+    cacheValid |= CACHE_MODE;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -448,13 +1110,13 @@ void T6963::setGraphicArea(uint8_t cols)
 ///  @brief Set mode to OR text and graphic data and choose character generator
 ///  @param[in] CG choose 0 (default) for ROM, non-zero for RAM char gen
 ////////////////////////////////////////////////////////////////////////////////
-void T6963::setOrMode(uint8_t CG = 0)
+void T6963::setOrMode(uint8_t CG)
 {
   if(CG != 0)
   {
     CG = T6963_MODE_RAM_CG;
   }
-  writeCommandByte(T6963_SET_OR_MODE | CG);
+  setMode(T6963_SET_OR_MODE | CG);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -462,13 +1124,13 @@ void T6963::setOrMode(uint8_t CG = 0)
 ///  @brief Set mode to XOR text and graphic data, choose character generator
 ///  @param[in] CG choose 0 (default) for ROM, non-zero for RAM char gen
 ////////////////////////////////////////////////////////////////////////////////
-void T6963::setXorMode(uint8_t CG = 0)
+void T6963::setXorMode(uint8_t CG)
 {
   if(CG != 0)
   {
     CG = T6963_MODE_RAM_CG;
   }
-  writeCommandByte(T6963_SET_EXOR_MODE | CG);
+  setMode(T6963_SET_EXOR_MODE | CG);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -476,13 +1138,13 @@ void T6963::setXorMode(uint8_t CG = 0)
 ///  @brief Set mode to AND text and graphic data, choose character generator
 ///  @param[in] CG choose 0 (default) for ROM, non-zero for RAM char gen
 ////////////////////////////////////////////////////////////////////////////////
-void T6963::setAndMode(uint8_t CG = 0)
+void T6963::setAndMode(uint8_t CG)
 {
   if(CG != 0)
   {
     CG = T6963_MODE_RAM_CG;
   }
-  writeCommandByte(T6963_SET_AND_MODE | CG);
+  setMode(T6963_SET_AND_MODE | CG);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -490,13 +1152,13 @@ void T6963::setAndMode(uint8_t CG = 0)
 ///  @brief Set text attribute mode and choose character generator
 ///  @param[in] CG choose 0 (default) for ROM, non-zero for RAM char gen
 ////////////////////////////////////////////////////////////////////////////////
-void T6963::setTextAttributeMode(uint8_t CG = 0)
+void T6963::setTextAttributeMode(uint8_t CG)
 {
   if(CG != 0)
   {
     CG = T6963_MODE_RAM_CG;
   }
-  writeCommandByte(T6963_SET_TEXT_ATTRIBUTE_MODE | CG);
+  setMode(T6963_SET_TEXT_ATTRIBUTE_MODE | CG);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -507,7 +1169,7 @@ void T6963::setTextAttributeMode(uint8_t CG = 0)
 ///  @param[in] curs Set non-zero to display the cursor.
 ///  @param[in] blnk Set non-zero to make the cursor blink.
 ////////////////////////////////////////////////////////////////////////////////
-void T6963::setDisplayMode(uint8_t txt = 0, uint8_t grph = 0, uint8_t curs = 0, uint8_t blnk = 0)
+void T6963::setDisplayMode(uint8_t txt, uint8_t grph, uint8_t curs, uint8_t blnk)
 {
   uint8_t cmd = T6963_DISPLAY_MODE;
   if(txt != 0)
@@ -526,7 +1188,12 @@ void T6963::setDisplayMode(uint8_t txt = 0, uint8_t grph = 0, uint8_t curs = 0,
   {
     cmd |= T6963_DISPLAY_BLINK;
   }
-  writeCommandByte(cmd);
+  if(!isCached(CACHE_DISPLAY, displayMode, cmd))
+  {
+    writeCommandByte(cmd);
+    displayMode = cmd;
+    cacheValid |= CACHE_DISPLAY;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -545,7 +1212,12 @@ void T6963::setCursorSize(uint8_t siz)
     siz = 1;
   }
   siz--;  // Convert 1 to 8 to 0 to 7
-  writeCommandByte(T6963_CURSOR_SIZE  | siz );
+  if(!isCached(CACHE_CURSOR_SIZE, cursorSize, siz))
+  {
+    writeCommandByte(T6963_CURSOR_SIZE  | siz );
+    cursorSize = siz;
+    cacheValid |= CACHE_CURSOR_SIZE;
+  }
 }
 
 #define T6963_AUTO_WRITE_SET              0xb0     // Set auto write mode
@@ -564,37 +1236,246 @@ void T6963::setCursorSize(uint8_t siz)
 //  data read                  data write
 
 //  repeat                     repeat
-//  status check 2             status check 2
+//  status check 2             status check 3
 //  data read                  data write
 
-//  status check 2             status check 2
+//  status check 2             status check 3
 //  auto reset                 auto reset
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_setAutoWrite
+///  @fn setAutoWrite
 ///  @brief  Begins the autowrite mode.  Stays in that mode until autoreset.
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_setAutoWrite()
+void T6963::setAutoWrite()
 {
-  T6963_writeCommandByte(T6963_AUTO_WRITE_SET);
+  writeCommandByte(T6963_AUTO_WRITE_SET);
+  autoMode = T6963_AUTO_WRITE_SET;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_setAutoRead
+///  @fn setAutoRead
 ///  @brief Begins the autoread mode.  Stays in that mode until autoreset.
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_setAutoRead()
+void T6963::setAutoRead()
 {
-  T6963_writeCommandByte(T6963_AUTO_READ_SET);
+  writeCommandByte(T6963_AUTO_READ_SET);
+  autoMode = T6963_AUTO_READ_SET;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_setAutoReset
-///  @brief  Ends autoread or autowrite mode.
+///  @fn setAutoReset
+///  @brief  Ends autoread or autowrite mode.  STA0/STA1 are not valid while
+///          in auto mode, so check STA3 (write) or STA2 (read) first.
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_setAutoReset()
+void T6963::setAutoReset()
 {
-  T6963_writeCommandByte(T6963_AUTO_RESET);
+  if(autoMode == T6963_AUTO_WRITE_SET)
+  {
+    waitAutoWrite();
+  }
+  else if(autoMode == T6963_AUTO_READ_SET)
+  {
+    waitAutoRead();
+  }
+  else
+  {
+    wait();
+  }
+  putCommand(T6963_AUTO_RESET);
+  autoMode = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeBlock
+///  @brief  Write a block of bytes to RAM with one auto write transfer.
+///          One address set, then one status check and one data strobe
+///          per byte instead of a data byte plus a command per byte.
+///  @param[in] addr  RAM address of the first byte
+///  @param[in] buf   Bytes to write
+///  @param[in] len   Number of bytes
+////////////////////////////////////////////////////////////////////////////////
+void T6963::writeBlock(uint16_t addr, const uint8_t* buf, uint16_t len)
+{
+  T6963_TIME_START();
+  if(buf != NULL && len > 0)
+  {
+    setAddress(addr);
+    setAutoWrite();
+    for(uint16_t i = 0; i < len; i++)
+    {
+      waitAutoWrite();
+      putData(buf[i]);
+    }
+    setAutoReset();
+    addressPointer = addr + len;
+  }
+  T6963_TIME_STOP(T6963_OP_WRITE_BLOCK);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readBlock
+///  @brief  Read a block of bytes from RAM with one auto read transfer
+///  @param[in]  addr  RAM address of the first byte
+///  @param[out] buf   Where to store the bytes
+///  @param[in]  len   Number of bytes
+////////////////////////////////////////////////////////////////////////////////
+void T6963::readBlock(uint16_t addr, uint8_t* buf, uint16_t len)
+{
+  T6963_TIME_START();
+  if(buf != NULL && len > 0)
+  {
+    setAddress(addr);
+    setAutoRead();
+    for(uint16_t i = 0; i < len; i++)
+    {
+      waitAutoRead();
+      buf[i] = getData();
+    }
+    setAutoReset();
+    addressPointer = addr + len;
+  }
+  T6963_TIME_STOP(T6963_OP_READ_BLOCK);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fill
+///  @brief  Write one byte value to a run of RAM with one auto write burst.
+///          The inner loop only waits for STA3 and strobes the same byte,
+///          so any text, graphic, attribute or CG RAM region (CG page n
+///          starts at n << 11) is cleared at the bus rate.
+///  @param[in] addr  RAM address of the first byte
+///  @param[in] d     The byte to write
+///  @param[in] len   Number of bytes
+////////////////////////////////////////////////////////////////////////////////
+void T6963::fill(uint16_t addr, uint8_t d, uint16_t len)
+{
+  if(len > 0)
+  {
+    setAddress(addr);
+    setAutoWrite();
+    for(uint16_t i = 0; i < len; i++)
+    {
+      waitAutoWrite();
+      putData(d);
+    }
+    setAutoReset();
+    addressPointer = addr + len;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillPattern
+///  @brief  Repeat a short pattern over a run of RAM in one auto write
+///          burst, e.g. a dither for the graphic area or a row of glyphs
+///  @param[in] addr     RAM address of the first byte
+///  @param[in] pattern  Bytes to repeat
+///  @param[in] n        Pattern length
+///  @param[in] len      Number of bytes to write
+////////////////////////////////////////////////////////////////////////////////
+void T6963::fillPattern(uint16_t addr, const uint8_t* pattern, uint8_t n, uint16_t len)
+{
+  if(pattern != NULL && n > 0 && len > 0)
+  {
+    uint8_t j = 0;
+    setAddress(addr);
+    setAutoWrite();
+    for(uint16_t i = 0; i < len; i++)
+    {
+      waitAutoWrite();
+      putData(pattern[j]);
+      j = (j + 1 < n) ? j + 1 : 0;
+    }
+    setAutoReset();
+    addressPointer = addr + len;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillRect
+///  @brief  Fill a rectangle of bytes.  When the rectangle spans whole rows
+///          (cols equal to stride) it is one burst, otherwise one per row.
+///  @param[in] addr    RAM address of the top left byte
+///  @param[in] stride  Bytes from one row to the next (the area width)
+///  @param[in] cols    Bytes per row
+///  @param[in] rows    Number of rows
+///  @param[in] d       The byte to write
+////////////////////////////////////////////////////////////////////////////////
+void T6963::fillRect(uint16_t addr, uint8_t stride, uint8_t cols, uint8_t rows, uint8_t d)
+{
+  if(cols == stride)
+  {
+    fill(addr, d, (uint16_t)cols * rows);
+  }
+  else
+  {
+    for(uint8_t r = 0; r < rows; r++)
+    {
+      fill(addr + (uint16_t)r * stride, d, cols);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillColumnBit
+///  @brief  Set or clear one bit in each byte of a column, e.g. a one pixel
+///          vertical line, using bit set/reset so the other bits are kept
+///          and no read back is needed
+///  @param[in] addr    RAM address of the top byte
+///  @param[in] stride  Bytes from one row to the next
+///  @param[in] rows    Number of rows
+///  @param[in] bit     Bit number (0 to 7, 0 is the rightmost pixel)
+///  @param[in] on      True to set, false to clear
+////////////////////////////////////////////////////////////////////////////////
+void T6963::fillColumnBit(uint16_t addr, uint8_t stride, uint8_t rows, uint8_t bit, bool on)
+{
+  for(uint8_t r = 0; r < rows; r++)
+  {
+    setAddress(addr + (uint16_t)r * stride);
+    if(on)
+    {
+      setBit(bit);
+    }
+    else
+    {
+      resetBit(bit);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clearText
+///  @brief  Fill the text drawing page, one burst
+///  @param[in] c  Character code to fill with (0 is a space in CG ROM)
+////////////////////////////////////////////////////////////////////////////////
+void T6963::clearText(uint8_t c)
+{
+  uint8_t rows = (panelHeight != 0) ? panelHeight / 8 : 8;
+  fill(getTextDrawAddress(), c, (uint16_t)textArea * rows);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clearGraphic
+///  @brief  Fill the graphic (or attribute) drawing page, one burst
+///  @param[in] d  Byte to fill with
+////////////////////////////////////////////////////////////////////////////////
+void T6963::clearGraphic(uint8_t d)
+{
+  uint8_t height = (panelHeight != 0) ? panelHeight : 64;
+  if( (mode & 0x07) == T6963_MODE_TEXT_ATTRIBUTE)
+  {
+    height = height / 8;   // one attribute byte per text cell
+  }
+  fill(getGraphicDrawAddress(), d, (uint16_t)graphicArea * height);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clear
+///  @brief  Clear text and graphics on the drawing page
+////////////////////////////////////////////////////////////////////////////////
+void T6963::clear()
+{
+  clearText();
+  clearGraphic();
 }
 
 #define T6963_DATA_WRITE_INC              0xc0     // write data and increment
@@ -605,115 +1486,132 @@ void T6963_setAutoReset()
 #define T6963_DATA_READ                   0xc5     // Read and stay in place
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_dataWriteIncrement
+///  @fn dataWriteIncrement
 ///  @brief  Write data at current address, increment address
 ///  @param[in] dat The data to write to RAM
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_dataWriteIncrement(uint8_t dat)
+void T6963::dataWriteIncrement(uint8_t dat)
 {
-  wait();
-  T6963_writeDataByte(dat);
-  wait();
-  T6963_writeCommandByte(T6963_DATA_WRITE_INC);
+  T6963_TIME_START();
+  writeDataByte(dat);
+  writeCommandByte(T6963_DATA_WRITE_INC);
+  addressPointer++;
+  T6963_TIME_STOP(T6963_OP_DATA_WRITE);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_dataWriteDecrement
+///  @fn dataWriteDecrement
 ///  @brief Write data at current address, decrement address
 ///  @param[in] dat The data to write to RAM
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_dataWriteDecrement(uint8_t dat)
+void T6963::dataWriteDecrement(uint8_t dat)
 {
-  wait();
-  T6963_writeDataByte(dat);
-  wait();
-  T6963_writeCommandByte(T6963_DATA_WRITE_DEC);
+  T6963_TIME_START();
+  writeDataByte(dat);
+  writeCommandByte(T6963_DATA_WRITE_DEC);
+  addressPointer--;
+  T6963_TIME_STOP(T6963_OP_DATA_WRITE);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_dataWrite
+///  @fn dataWrite
 ///  @brief  Write data at current address, leave address as is.
 ///  @param[in] dat The data to write to RAM
 ///  @return
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_dataWrite(uint8_t dat)
+void T6963::dataWrite(uint8_t dat)
 {
-  wait();
-  T6963_writeDataByte(dat);
-  wait();
-  T6963_writeCommandByte(T6963_DATA_WRITE_INC);
+  T6963_TIME_START();
+  writeDataByte(dat);
+  writeCommandByte(T6963_DATA_WRITE);
+  T6963_TIME_STOP(T6963_OP_DATA_WRITE);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_dataReadIncrement
-///  @brief  Read data from current address, increment address
+///  @fn dataReadIncrement
+///  @brief  Read data from current address, increment address.  The byte
+///          is fetched once STA0/STA1 show the read has completed.
 ///  @return  The byte read from RAM
 ////////////////////////////////////////////////////////////////////////////////
-uint8_t T6963_dataReadIncrement()
+uint8_t T6963::dataReadIncrement()
 {
   uint8_t rtn = 0;
+  T6963_TIME_START();
+  writeCommandByte(T6963_DATA_READ_INC);
+  addressPointer++;
   wait();
-  T6963_writeCommandByte(T6963_DATA_READ_INC);
-  wait();
- // TODO rtn =T6963_readDataByte();
+  rtn = getData();
+  T6963_TIME_STOP(T6963_OP_DATA_READ);
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_dataReadDecrement
+///  @fn dataReadDecrement
 ///  @brief Read Data from current address, decrement address
 ///  @return The byte read from RAM
 ////////////////////////////////////////////////////////////////////////////////
-uint8_t T6963_dataReadDecrement()
+uint8_t T6963::dataReadDecrement()
 {
   uint8_t rtn = 0;
+  T6963_TIME_START();
+  writeCommandByte(T6963_DATA_READ_DEC);
+  addressPointer--;
   wait();
-  T6963_writeCommandByte(T6963_DATA_READ_DEC);
-  wait();
- // TODO rtn =T6963_readDataByte();
+  rtn = getData();
+  T6963_TIME_STOP(T6963_OP_DATA_READ);
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_dataRead
+///  @fn dataRead
 ///  @brief Read byte from current address, leave address as is.
 ///  @return The byte read from RAM
 ////////////////////////////////////////////////////////////////////////////////
-uint8_t T6963_dataRead()
+uint8_t T6963::dataRead()
 {
   uint8_t rtn = 0;
+  T6963_TIME_START();
+  writeCommandByte(T6963_DATA_READ);
   wait();
-  T6963_writeCommandByte(T6963_DATA_READ);
-  wait();
- // TODO rtn =T6963_readDataByte();
+  rtn = getData();
+  T6963_TIME_STOP(T6963_OP_DATA_READ);
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_screenPeek
-///  @brief  Read display byte from screen, using address pointer to graphics.
+///  @fn screenPeek
+///  @brief  Read one displayed byte, text and graphics combined as the
+///          panel shows them.  The address pointer must lie in the displayed
+///          graphic area; if not the controller sets STA6, the result is 0
+///          and getScreenError() returns true.
 ///  @return Byte read from screen.
 ////////////////////////////////////////////////////////////////////////////////
-uint8_t T6963_screenPeek()
+uint8_t T6963::screenPeek()
 {
   uint8_t rtn = 0;
+  writeCommandByte(T6963_SCREEN_PEEK);
   wait();
-  T6963_writeCommandByte(T6963_SCREEN_PEEK);
-  wait();
- // TODO rtn =T6963_readDataByte();
+  screenError = (getStatus() & T6963_STA6) != 0;
+  if(!screenError)
+  {
+    rtn = getData();
+  }
   return rtn;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_screenCopy
-///  @brief Copy one row of screen to graphics area
+///  @fn screenCopy
+///  @brief Copy one displayed pixel row, text and graphics combined, into
+///         the graphic area at the same row.  The address pointer selects
+///         the row and must lie in the displayed graphic area.
+///  @return  True on success, false if the controller reported STA6
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_screenCopy()
+bool T6963::screenCopy()
 {
+  writeCommandByte(T6963_SCREEN_COPY);
   wait();
-  T6963_writeCommandByte(T6963_SCREEN_COPY);
-  wait();
- // TODO rtn =T6963_readDataByte();
+  screenError = (getStatus() & T6963_STA6) != 0;
+  return !screenError;
 }
 
 
@@ -721,122 +1619,130 @@ void T6963_screenCopy()
 #define T6963_SET                         0xf8     // Set any bit (add bit #)
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_setBit
+///  @fn setBit
 ///  @brief  Set a single bit at location in address pointer.
 ///  @param[in] b Bit number to set in byte (0 to 7)
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_setBit(uint8_t b)
+void T6963::setBit(uint8_t b)
 {
   if(b < 8)
   {
-    wait();
-    T6963_writeCommandByte(T6963_SET | b);
+    writeCommandByte(T6963_SET | b);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn T6963_resetBit
+///  @fn resetBit
 ///  @brief  Clear a single bit at location in addrss pointer
 ///  @param[in] b Bit number to clear in byte (0 to 7)
 ///  @return
 ////////////////////////////////////////////////////////////////////////////////
-void T6963_resetBit(uint8_t b)
+void T6963::resetBit(uint8_t b)
 {
   if(b < 8)
   {
-    wait();
-    T6963_writeCommandByte(T6963_RESET | b);
+    writeCommandByte(T6963_RESET | b);
   }
 }
 
 
+#if T6963_TRACE
 
-
-
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetStats
+///  @brief  Zero the counters and timing histograms
+////////////////////////////////////////////////////////////////////////////////
+void T6963::resetStats()
+{
+  memset(&stats, 0, sizeof(stats));
+}
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn ports_init
-///  @brief
-///  @param[]
-///  @return
+///  @fn startTrace
+///  @brief  Empty the trace buffer and start recording bus transactions
 ////////////////////////////////////////////////////////////////////////////////
+void T6963::startTrace()
+{
+  traceHead = 0;
+  traceCount = 0;
+  traceLost = 0;
+  tracing = true;
+}
 
-void setup() 
+////////////////////////////////////////////////////////////////////////////////
+///  @fn record
+///  @brief  Add one record to the trace ring, overwriting the oldest when
+///          it is full
+////////////////////////////////////////////////////////////////////////////////
+void T6963::record(uint8_t type, uint8_t value)
 {
-  // put your setup code here, to run once:
-  delay(100);
-  ports_init();
-  T6963_setAddress(0);
-  T6963_setCursor(0,0);
-  T6963_setTextHomeAddress(0);
-  T6963_setGraphicHomeAddress(2000);
-  T6963_setDisplayMode(1,1,1,1);  // text, graphics, cursor, blink
- // T6963_setAddress(0);
-  T6963_setTextArea(40);
-  T6963_setGraphicArea(40);
-  T6963_setOrMode(0);
-  delay(100);
-  for(int i = 0; i < 800; i++)
+  if(tracing)
   {
-    T6963_dataWriteIncrement(0);
-  }
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 2000; i < 4000; i++)
-  {
-    T6963_writeDataByte(0);
-  }
-  T6963_setAutoReset();
-  
-  T6963_setAddress(0);
-  for(uint8_t i = 0; i < 128; i++)
-  {
-    T6963_dataWriteIncrement(i);
-  }
-  for(uint8_t i = 0; i < 128; i++)
-  {
-    T6963_dataWriteIncrement(128-i);
+    trace[traceHead][0] = type;
+    trace[traceHead][1] = value;
+    traceHead = (traceHead + 1) % T6963_TRACE_SIZE;
+    if(traceCount < T6963_TRACE_SIZE)
+    {
+      traceCount++;
+    }
+    else
+    {
+      traceLost++;
+    }
   }
-  delay(500);
+}
 
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 0; i < 320; i++)
-  {
-    T6963_writeDataByte(0);  // space, clear screen
-  }
-  T6963_setAutoReset();
-  delay(500);
-  
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 0; i < 320; i++)
+////////////////////////////////////////////////////////////////////////////////
+///  @fn timeOp
+///  @brief  Count one call of a timed operation in its histogram
+///  @param[in] op  T6963_OP_*
+///  @param[in] us  Time taken in microseconds
+////////////////////////////////////////////////////////////////////////////////
+void T6963::timeOp(uint8_t op, unsigned long us)
+{
+  uint8_t b = 0;
+  while(us >= 2 && b < T6963_BUCKETS - 1)
   {
-    T6963_writeDataByte( (uint8_t) (i & 0x7f) );
+    us >>= 1;
+    b++;
   }
-  T6963_setAutoReset();
-  delay(2000);
-  T6963_setAddress(2000);
-  T6963_setAutoWrite();
-  for(int i = 2000; i < 4000; i++)
+  if(stats.histogram[op][b] != 0xffff)
   {
-    T6963_writeDataByte( 0x55);
+    stats.histogram[op][b]++;
   }
-  T6963_setAutoReset();
-  
- 
-
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///  @fn ports_init
-///  @brief
-///  @param[]
-///  @return
+///  @fn dumpTrace
+///  @brief  Print the trace, oldest record first, for tools/t6963_trace:
+///            T6963 TRACE <records> <lost>
+///            hex bytes, type then value, 32 bytes per line
+///            END
+///  @param[in] out  Where to print, e.g. Serial
 ////////////////////////////////////////////////////////////////////////////////
-
-void loop() 
+void T6963::dumpTrace(Print& out)
 {
-  // put your main code here, to run repeatedly:
-
+  static const char hex[] = "0123456789abcdef";
+  uint16_t first = (traceHead + T6963_TRACE_SIZE - traceCount) % T6963_TRACE_SIZE;
+  out.print("T6963 TRACE ");
+  out.print((unsigned long)traceCount);
+  out.print(" ");
+  out.print((unsigned long)traceLost);
+  out.print("\n");
+  for(uint16_t i = 0; i < traceCount; i++)
+  {
+    const uint8_t* r = trace[(first + i) % T6963_TRACE_SIZE];
+    for(uint8_t j = 0; j < 2; j++)
+    {
+      out.write(hex[r[j] >> 4]);
+      out.write(hex[r[j] & 0x0f]);
+    }
+    if(i % 16 == 15 || i + 1 == traceCount)
+    {
+      out.print("\n");
+    }
+  }
+  out.print("END\n");
 }
+
+#endif
@@ -67,6 +67,14 @@
 #define T6963_MODE_AND                    0x03     // AND mode
 #define T6963_MODE_TEXT_ATTRIBUTE         0x04     // TEXT ATTRIBUTE MODE
 
+// Text attribute codes, one byte per character in the graphic area when
+// TEXT ATTRIBUTE MODE is set.  BLINK may be added to the others.
+#define T6963_ATTR_NORMAL                 0x00     // Normal display
+#define T6963_ATTR_REVERSE                0x05     // Reverse display
+#define T6963_ATTR_INHIBIT                0x03     // Inhibit display
+#define T6963_ATTR_BLINK                  0x08     // Blink
+#define T6963_ATTR_BOLD                   0x05     // No bold on the T6963: reverse
+
 
 
 
@@ -143,6 +151,119 @@
 #define T6963_RESET_6                     0xf6     // Reset bit 6
 #define T6963_RESET_7                     0xf7     // Reset bit 7
 
+// Status bits
+#define T6963_STA0                        0x01     // command execution capable
+#define T6963_STA1                        0x02     // data read/write capable
+#define T6963_STA2                        0x04     // auto read capable
+#define T6963_STA3                        0x08     // auto write capable
+#define T6963_STA5                        0x20     // controller operation capable
+#define T6963_STA6                        0x40     // screen peek/copy error
+#define T6963_STA7                        0x80     // blink condition
+
+
+// Bus backends.  Define T6963_BUS before including this file to override.
+//   T6963_BUS_DIGITAL  portable pinMode / digitalWrite / digitalRead
+//   T6963_BUS_PORT     direct port registers (one access per port per byte)
+//   T6963_BUS_EXTERNAL byte level T6963Bus object, e.g. T6963Emulator
+//   T6963_BUS_FAST     pins fixed at compile time, called without a vtable
+//                      (T6963_FAST_BUS in T6963_fast.h names the bus type)
+#define T6963_BUS_DIGITAL                 0
+#define T6963_BUS_PORT                    1
+#define T6963_BUS_EXTERNAL                2
+#define T6963_BUS_FAST                    3
+
+#ifndef T6963_BUS
+#if defined(__AVR__)
+#define T6963_BUS                         T6963_BUS_PORT
+#else
+#define T6963_BUS                         T6963_BUS_DIGITAL
+#endif
+#endif
+
+// Port register width used by the port backend (8 bits on AVR)
+#ifndef T6963_PORT_REG_TYPE
+#define T6963_PORT_REG_TYPE               uint8_t
+#endif
+
+
+// Ready strategies, see T6963::setReadyStrategy
+#define T6963_READY_POLL                  0     // poll status until ready
+#define T6963_READY_BOUNDED               1     // poll, give up after limit
+#define T6963_READY_DELAY                 2     // no status read, fixed delay
+
+// Operation classes with their own ready delay
+#define T6963_CLASS_DATA                  0     // data / parameter byte
+#define T6963_CLASS_COMMAND               1     // command byte
+#define T6963_CLASS_AUTO                  2     // auto read / write byte
+#define T6963_READY_CLASSES               3
+
+// Default status reads before T6963_READY_BOUNDED reports a timeout
+#ifndef T6963_SPIN_LIMIT
+#define T6963_SPIN_LIMIT               1000
+#endif
+
+// Instrumentation: define T6963_TRACE as 1 to build in the counters,
+// timing histograms and bus trace (see T6963::getStats, startTrace)
+#ifndef T6963_TRACE
+#define T6963_TRACE                       0
+#endif
+
+// Bus trace records kept, two bytes each; the oldest are overwritten
+#ifndef T6963_TRACE_SIZE
+#define T6963_TRACE_SIZE                128
+#endif
+
+// Trace record types.  The second byte of a record is the value.
+#define T6963_REC_DATA                    0     // data byte written
+#define T6963_REC_COMMAND                 1     // command byte written
+#define T6963_REC_READ                    2     // data byte read
+#define T6963_REC_POLLS                   3     // busy status reads in one wait (max 255)
+
+// Timed operations, one histogram each
+#define T6963_OP_SET_ADDRESS              0     // setAddress
+#define T6963_OP_WRITE_BLOCK              1     // writeBlock
+#define T6963_OP_READ_BLOCK               2     // readBlock
+#define T6963_OP_DATA_WRITE               3     // dataWrite, dataWriteIncrement/Decrement
+#define T6963_OP_DATA_READ                4     // dataRead, dataReadIncrement/Decrement
+#define T6963_OPS                         5
+
+// Histogram buckets in microseconds: <2, <4, <8 ... <128, 128 and over
+#define T6963_BUCKETS                     8
+
+
+#if T6963_TRACE
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963Stats
+/// @brief  Bus traffic and timing counted when T6963_TRACE is 1
+//////////////////////////////////////////////////////////////////////////////
+
+struct T6963Stats
+{
+  uint32_t statusPolls;       // status reads
+  uint32_t spins;             // status reads that found the controller busy
+  uint32_t dataBytes;         // data bytes written
+  uint32_t commandBytes;      // command bytes written
+  uint32_t dataReads;         // data bytes read
+  uint32_t autoBursts;        // auto write / auto read transfers started
+  uint32_t addressSets;       // address pointer sets sent
+  uint32_t redundantAddressSets;  // address sets skipped, pointer already there
+  uint16_t histogram[T6963_OPS][T6963_BUCKETS];
+};
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Bus
+/// @brief Byte level bus used by the T6963_BUS_EXTERNAL backend
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Bus
+{
+  public:
+    virtual ~T6963Bus() {}
+    virtual void write(uint8_t cd, uint8_t d) = 0;   // cd HIGH: command
+    virtual uint8_t read(uint8_t cd) = 0;            // cd HIGH: status
+};
+
 
 //////////////////////////////////////////////////////////////////////////////
 /// @class T6963
@@ -152,51 +273,158 @@ class T6963
 {
   public:
     T6963(int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7, 
-          int wr, int rd, int ce, int cd, int fs, int res);
-    void writeDataByte(uint8_t dat)
-    void writeCommandByte(uint8_t cmd)
-    int TsetCursor(int x, int y)
-    int setOffsetPointer(uint8_t offs)
-    void setAddress(uint16_t addr)
-    void setTextHomeAddress(uint16_t addr)
-    void setGraphicHomeAddress(uint16_t addr)
-    void setTextArea(uint8_t cols)
-    void setGraphicArea(uint8_t cols)
-    void setOrMode(uint8_t CG = 0)
-    void setXorMode(uint8_t CG = 0)
-    void setAndMode(uint8_t CG = 0)
-    void setTextAttributeMode(uint8_t CG = 0)
-    void setDisplayMode(uint8_t txt = 0, uint8_t grph = 0, uint8_t curs = 0, uint8_t blnk = 0)
-    void setCursorSize(uint8_t siz)
-    void setAutoWrite()
-    void setAutoRead()
-    void setAutoReset()
-    void dataWriteIncrement(uint8_t dat)
-    void dataWriteDecrement(uint8_t dat)
-    void dataWrite(uint8_t dat)
-    uint8_t dataReadIncrement()
-    uint8_t dataReadDecrement()
-    uint8_t dataRead()
-    uint8_t screenPeek()
-    void screenCopy()
-    void setBit(uint8_t b)
-    void resetBit(uint8_t b)
+          int wr, int rd, int ce, int cd, int res = 0, int fs = 0);
+#if T6963_BUS == T6963_BUS_EXTERNAL
+    T6963(T6963Bus& bus);
+#endif
+#if T6963_BUS == T6963_BUS_FAST
+    T6963();
+#endif
+    bool ports_init();
+    void writeDataByte(uint8_t dat);
+    void writeCommandByte(uint8_t cmd);
+    bool tryDataByte(uint8_t dat);
+    bool tryCommandByte(uint8_t cmd);
+    int setCursor(int x, int y);
+    int setOffsetPointer(uint8_t offs);
+    void setAddress(uint16_t addr);
+    void setTextHomeAddress(uint16_t addr);
+    void setGraphicHomeAddress(uint16_t addr);
+    void setTextArea(uint8_t cols);
+    void setGraphicArea(uint8_t cols);
+    void setOrMode(uint8_t CG = 0);
+    void setXorMode(uint8_t CG = 0);
+    void setAndMode(uint8_t CG = 0);
+    void setTextAttributeMode(uint8_t CG = 0);
+    void setDisplayMode(uint8_t txt = 0, uint8_t grph = 0, uint8_t curs = 0, uint8_t blnk = 0);
+    void setCursorSize(uint8_t siz);
+    void setAutoWrite();
+    void setAutoRead();
+    void setAutoReset();
+    void writeBlock(uint16_t addr, const uint8_t* buf, uint16_t len);
+    void readBlock(uint16_t addr, uint8_t* buf, uint16_t len);
+    void fill(uint16_t addr, uint8_t d, uint16_t len);
+    void fillPattern(uint16_t addr, const uint8_t* pattern, uint8_t n, uint16_t len);
+    void fillRect(uint16_t addr, uint8_t stride, uint8_t cols, uint8_t rows, uint8_t d);
+    void fillColumnBit(uint16_t addr, uint8_t stride, uint8_t rows, uint8_t bit, bool on);
+    void clearText(uint8_t c = 0);
+    void clearGraphic(uint8_t d = 0);
+    void clear();
+    void dataWriteIncrement(uint8_t dat);
+    void dataWriteDecrement(uint8_t dat);
+    void dataWrite(uint8_t dat);
+    uint8_t dataReadIncrement();
+    uint8_t dataReadDecrement();
+    uint8_t dataRead();
+    uint8_t screenPeek();
+    bool screenCopy();
+    bool getScreenError() { return screenError; }
+    void setBit(uint8_t b);
+    void resetBit(uint8_t b);
+
+    void setReadyStrategy(uint8_t strategy, uint16_t limit = T6963_SPIN_LIMIT);
+    void setReadyDelay(uint8_t cls, uint16_t us);
+    uint16_t getReadyDelay(uint8_t cls);
+    void calibrate();
+    uint16_t getTimeouts() { return timeouts; }
+    void clearTimeouts() { timeouts = 0; }
+
+    void invalidateCache();
+    void resetCacheCounters();
+    uint32_t getSkippedCommands() { return skippedCommands; }
+    uint32_t getSkippedAddressSets() { return skippedAddressSets; }
+
+    void setFontWidth(uint8_t width);
+    uint8_t getFontWidth() { return fontWidth; }
+    void setPanelSize(uint16_t width, uint8_t height);
+    uint16_t getPanelWidth() { return panelWidth; }
+    uint8_t getPanelHeight() { return panelHeight; }
+    uint16_t getTextHomeAddress() { return textHomeAddress; }
+    uint8_t getTextArea() { return textArea; }
+    uint16_t getGraphicHomeAddress() { return graphicHomeAddres; }
+    uint8_t getGraphicArea() { return graphicArea; }
+
+    void setDrawPage(uint16_t text, uint16_t graphic);
+    void clearDrawPage();
+    uint16_t getTextDrawAddress() { return drawPage ? textDrawAddress : textHomeAddress; }
+    uint16_t getGraphicDrawAddress() { return drawPage ? graphicDrawAddress : graphicHomeAddres; }
+
+#if T6963_TRACE
+    T6963Stats& getStats() { return stats; }
+    void resetStats();
+    void startTrace();
+    void stopTrace() { tracing = false; }
+    uint16_t getTraceLength() { return traceCount; }
+    uint32_t getTraceLost() { return traceLost; }
+    void dumpTrace(Print& out);
+#endif
 
   private:
     
-    bool ports_init()
-    void setDataDirection(int dir)
-    void setDataBits(uint8_t d)
-    static uint8_t getDataBits()
-    uint8_t getStatus()
-    uint8_t getData()
-    void wait()
-    void waitAuto()
-    void waitAutoRead()
-    void waitAutoWrite()
-
-    uint8_t pins[14];  // d0-d7,wr,rd,ce,cd,fs,res
+    void init_state();
+    bool isCached(uint16_t bit, uint16_t cur, uint16_t val);
+    void setMode(uint8_t cmd);
+    void setDataDirection(int dir);
+    void applyDataDirection(int dir);
+    void setDataBits(uint8_t d);
+    uint8_t getDataBits();
+    void setControl(uint8_t pin, uint8_t level);
+    void putData(uint8_t dat);
+    void putCommand(uint8_t cmd);
+    uint8_t getStatus();
+    uint8_t getData();
+    bool waitStatus(uint8_t mask);
+    void wait();
+    void waitAuto();
+    void waitAutoRead();
+    void waitAutoWrite();
+
+    uint8_t pins[14];  // d0-d7,wr,rd,ce,cd,res,fs
+    int busDirection;  // INPUT or OUTPUT as last set, -1 if unknown
+    uint8_t fontWidth; // 6 or 8 pixels per text column / graphic byte
+    uint16_t panelWidth;  // pixels, 0 if not set
+    uint8_t panelHeight;  // pixels, 0 if not set
+
+#if T6963_BUS == T6963_BUS_PORT
+    bool bus_init();
+
+    // A run of data bits that sit on consecutive bits of one port
+    struct PortRun
+    {
+      volatile T6963_PORT_REG_TYPE* out;
+      volatile T6963_PORT_REG_TYPE* in;
+      volatile T6963_PORT_REG_TYPE* mode;
+      T6963_PORT_REG_TYPE portMask;   // bits of the port used by this run
+      uint8_t dataMask;               // bits of the data byte in this run
+      int8_t shift;                   // port bit - data bit
+    };
+    PortRun runs[8];
+    uint8_t numRuns;
+
+    volatile T6963_PORT_REG_TYPE* ctrlOut[4];  // wr, rd, ce, cd
+    T6963_PORT_REG_TYPE ctrlMask[4];
+#endif
+#if T6963_BUS == T6963_BUS_EXTERNAL
+    T6963Bus* bus;
+#endif
 
+    // Ready strategy
+    uint8_t readyStrategy;
+    uint16_t spinLimit;
+    uint16_t readyDelay[T6963_READY_CLASSES];   // microseconds
+    uint8_t lastClass;        // class of the last bus operation
+    bool calibrating;
+    uint16_t timeouts;
+
+    // Register cache: values the controller is known to hold
+    uint16_t cacheValid;      // cachebits set for registers known to be valid
+    uint32_t skippedCommands;
+    uint32_t skippedAddressSets;
+    uint8_t mode;
+    uint8_t displayMode;
+    uint8_t cursorSize;
+
+    uint8_t autoMode;         // 0, T6963_AUTO_WRITE_SET or T6963_AUTO_READ_SET
     uint16_t cursorPointer;
     uint16_t offsetPointer;   
     uint16_t addressPointer;
@@ -206,6 +434,25 @@ class T6963
     uint16_t graphicHomeAddres;
     uint8_t graphicArea;
 
+    // Where drawing goes when it is not the displayed page
+    bool drawPage;
+    uint16_t textDrawAddress;
+    uint16_t graphicDrawAddress;
+
+    bool screenError;         // STA6 after the last screen peek / copy
+
+#if T6963_TRACE
+    void record(uint8_t type, uint8_t value);
+    void timeOp(uint8_t op, unsigned long us);
+
+    T6963Stats stats;
+    uint8_t trace[T6963_TRACE_SIZE][2];
+    uint16_t traceHead;       // next record written
+    uint16_t traceCount;      // records held
+    uint32_t traceLost;       // records overwritten
+    bool tracing;
+#endif
+
 };
 
 #endif
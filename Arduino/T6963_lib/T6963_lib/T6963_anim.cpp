@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_anim.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Paced player for span delta animations on the graphic plane
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_anim.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Anim
+///  @brief  Constructor
+///  @param[in] lcd  The display to draw on
+////////////////////////////////////////////////////////////////////////////////
+T6963Anim::T6963Anim(T6963& lcd)
+  : lcd(lcd), first(NULL), next(NULL), loop(NULL), pgm(false), playing(false),
+    frames(0), loopTo(T6963_ANIM_NO_LOOP), frame(0), cols(0), rows(0), base(0),
+    stride(0), period(0), due(0)
+{
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the frame, drop and byte counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963Anim::resetCounters()
+{
+  framesShown = 0;
+  dropped = 0;
+  bytesWritten = 0;
+  bytesRead = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn start
+///  @brief  Start an animation held in RAM.  Frame 0 is due at once.
+///  @param[in] anim         The animation, header first
+///  @param[in] col          Left graphic column (byte) of the box
+///  @param[in] y            Top pixel row of the box
+///  @param[in] frameMicros  Time from one frame to the next, 0 to draw a
+///                          frame on every update()
+///  @return  True if the animation fits the graphic area
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Anim::start(const uint8_t* anim, uint8_t col, uint8_t y, uint32_t frameMicros)
+{
+  return begin(anim, false, col, y, frameMicros);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn start_P
+///  @brief  As start, with the animation held in PROGMEM
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Anim::start_P(const uint8_t* anim, uint8_t col, uint8_t y, uint32_t frameMicros)
+{
+  return begin(anim, true, col, y, frameMicros);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Read the header and place the box on the graphic drawing page
+///  @return  True if the animation fits the graphic area
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Anim::begin(const uint8_t* anim, bool pgm, uint8_t col, uint8_t y, uint32_t frameMicros)
+{
+  uint8_t area = lcd.getGraphicArea();
+  uint8_t height = lcd.getPanelHeight();
+  playing = false;
+  if(anim != NULL)
+  {
+    next = anim;
+    this->pgm = pgm;
+    frames = fetch();
+    loopTo = fetch();
+    cols = fetch();
+    rows = fetch();
+    first = next;
+    loop = first;
+    frame = 0;
+    stride = area;
+    base = lcd.getGraphicDrawAddress() + (uint16_t)y * area + col;
+    period = frameMicros;
+    due = micros();
+    playing = (frames != 0 && cols != 0 && rows != 0 && col + cols <= area &&
+               (height == 0 || y + rows <= height) &&
+               (loopTo == T6963_ANIM_NO_LOOP || loopTo < frames));
+  }
+  return playing;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fetch
+///  @return  The next byte of the animation
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Anim::fetch()
+{
+  uint8_t rtn = pgm ? pgm_read_byte(next) : *next;
+  next++;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn update
+///  @brief  Draw the next frame if it is due.  Call from loop() at least
+///          once a frame.  If whole frame times passed since the frame was
+///          due they are counted as dropped and the schedule moves on, so
+///          the animation slows rather than bursting to catch up.
+///  @return  True if a frame was drawn
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Anim::update()
+{
+  bool rtn = false;
+  if(playing)
+  {
+    unsigned long late = micros() - due;
+    if( (long)late >= 0)
+    {
+      uint32_t missed = (period != 0) ? late / period : 0;
+      dropped += missed;
+      due += (missed + 1) * period;
+      rtn = step();
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn step
+///  @brief  Draw the next frame now, whether or not it is due.  After the
+///          last frame play continues at the loop frame, or stops.
+///  @return  True if a frame was drawn; false if stopped or the frame
+///           has a span outside the box, which also stops play
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Anim::step()
+{
+  bool rtn = playing;
+  if(playing)
+  {
+    uint8_t spans;
+    if(frame == loopTo)
+    {
+      loop = next;
+    }
+    spans = fetch();
+    for(uint8_t i = 0; i < spans && rtn; i++)
+    {
+      uint16_t off = fetch();
+      uint8_t len;
+      off |= (uint16_t)fetch() << 8;
+      len = fetch();
+      rtn = span(off, (len & T6963_ANIM_LENGTH) + 1, (len & T6963_ANIM_XOR) != 0);
+    }
+    framesShown++;
+    frame++;
+    if(frame == frames && loopTo != T6963_ANIM_NO_LOOP)
+    {
+      next = loop;
+      frame = loopTo;
+    }
+    playing = rtn && frame < frames;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn span
+///  @brief  Apply one span: one auto write for a write span, chunks of
+///          read, XOR and write back for an XOR span
+///  @param[in] off    Byte offset in the box
+///  @param[in] len    Number of bytes
+///  @param[in] isXor  True to XOR the data over RAM
+///  @return  True if the span lies within one row of the box
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Anim::span(uint16_t off, uint8_t len, bool isXor)
+{
+  bool rtn = (off / cols < rows && off % cols + len <= cols);
+  if(rtn)
+  {
+    uint16_t addr = base + (off / cols) * stride + off % cols;
+    if(isXor)
+    {
+      uint8_t n;
+      for(uint8_t done = 0; done < len; done += n)
+      {
+        n = (len - done > T6963_ANIM_CHUNK) ? T6963_ANIM_CHUNK : len - done;
+        lcd.readBlock(addr + done, chunk, n);
+        for(uint8_t i = 0; i < n; i++)
+        {
+          chunk[i] ^= fetch();
+        }
+        lcd.writeBlock(addr + done, chunk, n);
+      }
+      bytesRead += len;
+    }
+    else
+    {
+      lcd.setAddress(addr);
+      lcd.setAutoWrite();
+      for(uint8_t i = 0; i < len; i++)
+      {
+        lcd.writeDataByte(fetch());
+      }
+      lcd.setAutoReset();
+    }
+    bytesWritten += len;
+  }
+  return rtn;
+}
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_anim.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Paced player for span delta animations on the graphic plane
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_ANIM_H
+#define T6963_ANIM_H
+
+#include "T6963.h"
+
+// Animation header: frames, frame to continue at after the last (0xff to
+// stop), bytes per row, rows
+#define T6963_ANIM_HEADER                 4
+#define T6963_ANIM_NO_LOOP             0xff
+
+// Frame: span count, then per span the byte offset in the box (low, high),
+// a length byte and the data.  Spans do not cross a row of the box.
+#define T6963_ANIM_XOR                 0x80   // length byte: XOR over RAM
+#define T6963_ANIM_LENGTH              0x7f   // length byte: bytes - 1
+
+// Bytes read back per auto read burst for XOR spans
+#ifndef T6963_ANIM_CHUNK
+#define T6963_ANIM_CHUNK                 16
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Anim
+/// @brief Plays animations made by tools/t6963_image -a.  Each frame holds
+///        only the bytes that change from the frame before, as spans.
+///
+///        A write span replaces its bytes with one auto write.  An XOR
+///        span is read back, XORed and written, so the animation
+///        overlays whatever is drawn under it and the same data plays on
+///        any background.
+///
+///        update() draws the next frame when it is due.  Deltas have to
+///        be applied in order, so a late frame is still drawn and the
+///        frame slots that passed are counted as dropped.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Anim
+{
+  public:
+    T6963Anim(T6963& lcd);
+
+    bool start(const uint8_t* anim, uint8_t col, uint8_t y, uint32_t frameMicros);
+    bool start_P(const uint8_t* anim, uint8_t col, uint8_t y, uint32_t frameMicros);
+    void stop() { playing = false; }
+    bool isPlaying() { return playing; }
+    bool update();
+    bool step();
+
+    uint8_t getFrame() { return frame; }
+    uint8_t getFrameCount() { return frames; }
+    uint32_t getFramesShown() { return framesShown; }
+    uint32_t getDropped() { return dropped; }
+    uint32_t getBytesWritten() { return bytesWritten; }
+    uint32_t getBytesRead() { return bytesRead; }
+    void resetCounters();
+
+  private:
+    bool begin(const uint8_t* anim, bool pgm, uint8_t col, uint8_t y, uint32_t frameMicros);
+    bool span(uint16_t off, uint8_t len, bool isXor);
+    uint8_t fetch();
+
+    T6963& lcd;
+    const uint8_t* first;   // frame 0
+    const uint8_t* next;    // next frame to draw
+    const uint8_t* loop;    // frame loopTo, once reached
+    bool pgm;               // frames are in PROGMEM
+    bool playing;
+    uint8_t frames;
+    uint8_t loopTo;
+    uint8_t frame;          // index of the next frame
+    uint8_t cols;           // bytes per row of the box
+    uint8_t rows;
+    uint16_t base;          // RAM address of the top left byte of the box
+    uint8_t stride;
+    uint32_t period;        // micros per frame
+    unsigned long due;      // micros() when the next frame is due
+    uint8_t chunk[T6963_ANIM_CHUNK];
+    uint32_t framesShown;
+    uint32_t dropped;
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+};
+
+#endif
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_attr.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Text attribute plane kept as runs of equal attributes
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_attr.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Attributes
+///  @brief  Constructor.  Every cell starts normal; call clear() to write
+///          that to the display.
+///  @param[in] lcd   The display, in text attribute mode
+///  @param[in] cols  Text columns (up to T6963_ATTR_MAX_COLS)
+///  @param[in] rows  Text rows (up to T6963_ATTR_MAX_ROWS)
+////////////////////////////////////////////////////////////////////////////////
+T6963Attributes::T6963Attributes(T6963& lcd, uint8_t cols, uint8_t rows)
+  : lcd(lcd),
+    cols(cols > T6963_ATTR_MAX_COLS ? T6963_ATTR_MAX_COLS : cols),
+    rows(rows > T6963_ATTR_MAX_ROWS ? T6963_ATTR_MAX_ROWS : rows)
+{
+  for(uint8_t r = 0; r < T6963_ATTR_MAX_ROWS; r++)
+  {
+    runs[r][0].start = 0;
+    runs[r][0].attr = T6963_ATTR_NORMAL;
+    numRuns[r] = 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn address
+///  @return  Attribute byte address of a cell on the graphic drawing page
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Attributes::address(uint8_t col, uint8_t row)
+{
+  return lcd.getGraphicDrawAddress() + (uint16_t)row * lcd.getGraphicArea() + col;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn expand
+///  @brief  Unpack one row's runs into one attribute byte per column
+///  @param[in]  row   Text row
+///  @param[out] line  cols bytes
+///  @return  Number of columns written
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Attributes::expand(uint8_t row, uint8_t* line)
+{
+  uint8_t i = 0;
+  for(uint8_t c = 0; c < cols; c++)
+  {
+    if(i + 1 < numRuns[row] && runs[row][i + 1].start == c)
+    {
+      i++;
+    }
+    line[c] = runs[row][i].attr;
+  }
+  return cols;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn encode
+///  @brief  Pack a row of attribute bytes into runs
+///  @param[in]  line  cols bytes
+///  @param[out] out   Up to T6963_ATTR_RUNS runs
+///  @return  Runs needed; more than T6963_ATTR_RUNS means out is incomplete
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Attributes::encode(const uint8_t* line, T6963AttrRun* out)
+{
+  uint8_t n = 0;
+  for(uint8_t c = 0; c < cols; c++)
+  {
+    if(c == 0 || line[c] != line[c - 1])
+    {
+      if(n < T6963_ATTR_RUNS)
+      {
+        out[n].start = c;
+        out[n].attr = line[c];
+      }
+      n++;
+    }
+  }
+  return n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn set
+///  @brief  Give a span of cells one attribute and write it to the display
+///          as one auto write burst
+///  @param[in] col   First column
+///  @param[in] row   Text row
+///  @param[in] len   Number of cells, clipped at the end of the row
+///  @param[in] attr  T6963_ATTR_* value
+///  @return  True if set, false if out of range or the row would need more
+///           than T6963_ATTR_RUNS runs (nothing changed)
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Attributes::set(uint8_t col, uint8_t row, uint8_t len, uint8_t attr)
+{
+  bool rtn = false;
+  if(row < rows && col < cols && len > 0)
+  {
+    uint8_t line[T6963_ATTR_MAX_COLS];
+    T6963AttrRun packed[T6963_ATTR_RUNS];
+    uint8_t n;
+    if(len > cols - col)
+    {
+      len = cols - col;
+    }
+    expand(row, line);
+    memset(line + col, attr, len);
+    n = encode(line, packed);
+    if(n <= T6963_ATTR_RUNS)
+    {
+      memcpy(runs[row], packed, n * sizeof(T6963AttrRun));
+      numRuns[row] = n;
+      lcd.writeBlock(address(col, row), line + col, len);
+      rtn = true;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn get
+///  @return  The attribute of one cell, from the run state (no bus access)
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Attributes::get(uint8_t col, uint8_t row)
+{
+  uint8_t rtn = T6963_ATTR_NORMAL;
+  if(row < rows)
+  {
+    for(uint8_t i = 0; i < numRuns[row]; i++)
+    {
+      if(runs[row][i].start <= col)
+      {
+        rtn = runs[row][i].attr;
+      }
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clear
+///  @brief  Give every cell one attribute and write the whole plane
+///  @param[in] attr  T6963_ATTR_* value
+////////////////////////////////////////////////////////////////////////////////
+void T6963Attributes::clear(uint8_t attr)
+{
+  for(uint8_t r = 0; r < rows; r++)
+  {
+    runs[r][0].start = 0;
+    runs[r][0].attr = attr;
+    numRuns[r] = 1;
+  }
+  flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn flushRow
+///  @brief  Write one row from the run state, one burst
+///  @param[in] row  Text row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Attributes::flushRow(uint8_t row)
+{
+  if(row < rows)
+  {
+    uint8_t line[T6963_ATTR_MAX_COLS];
+    lcd.writeBlock(address(0, row), line, expand(row, line));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn flush
+///  @brief  Write the whole plane from the run state, e.g. after a page
+///          flip or after the plane was overwritten
+////////////////////////////////////////////////////////////////////////////////
+void T6963Attributes::flush()
+{
+  for(uint8_t r = 0; r < rows; r++)
+  {
+    flushRow(r);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn scrollUp
+///  @brief  Move the attribute state up one row to follow scrolled text.
+///          The new bottom row is normal.
+///  @param[in] homeMoved  True if the graphic home was moved down a row, so
+///                        the attribute bytes moved with the display and
+///                        only the new bottom row is written.  False if the
+///                        text was copied and the attributes stay in place,
+///                        so each row whose runs change is rewritten.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Attributes::scrollUp(bool homeMoved)
+{
+  if(rows != 0)       // built with no rows: runs[rows - 1] would be runs[255]
+  {
+    for(uint8_t r = 0; r + 1 < rows; r++)
+    {
+      bool changed = numRuns[r] != numRuns[r + 1] ||
+                     memcmp(runs[r], runs[r + 1], numRuns[r] * sizeof(T6963AttrRun)) != 0;
+      memcpy(runs[r], runs[r + 1], sizeof(runs[r]));
+      numRuns[r] = numRuns[r + 1];
+      if(changed && !homeMoved)
+      {
+        flushRow(r);
+      }
+    }
+    runs[rows - 1][0].start = 0;
+    runs[rows - 1][0].attr = T6963_ATTR_NORMAL;
+    numRuns[rows - 1] = 1;
+    flushRow(rows - 1);
+  }
+}
@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_attr.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Text attribute plane kept as runs of equal attributes
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_ATTR_H
+#define T6963_ATTR_H
+
+#include "T6963.h"
+
+// Widest text row handled
+#ifndef T6963_ATTR_MAX_COLS
+#define T6963_ATTR_MAX_COLS              64
+#endif
+
+// Most text rows handled
+#ifndef T6963_ATTR_MAX_ROWS
+#define T6963_ATTR_MAX_ROWS              16
+#endif
+
+// Runs of equal attributes kept per row
+#ifndef T6963_ATTR_RUNS
+#define T6963_ATTR_RUNS                   6
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963AttrRun
+/// @brief  Attribute from column start to the start of the next run
+//////////////////////////////////////////////////////////////////////////////
+
+struct T6963AttrRun
+{
+  uint8_t start;
+  uint8_t attr;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Attributes
+/// @brief Per-cell T6963_ATTR_* values for text attribute mode.  The
+///        attribute plane is the graphic drawing page; each row's state is
+///        held as a few runs, so highlighting a menu row is one auto write
+///        burst, and get() needs no read back.  A change that would need
+///        more than T6963_ATTR_RUNS runs in a row is refused.
+///
+///        Scrolling: call scrollUp(true) after moving the graphic home
+///        down one row (the attributes travel with it, only the new bottom
+///        row is written), or scrollUp(false) after copying the text up,
+///        which rewrites the rows whose attributes changed.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Attributes
+{
+  public:
+    T6963Attributes(T6963& lcd, uint8_t cols = 40, uint8_t rows = 8);
+
+    bool set(uint8_t col, uint8_t row, uint8_t len, uint8_t attr);
+    bool setRow(uint8_t row, uint8_t attr) { return set(0, row, cols, attr); }
+    uint8_t get(uint8_t col, uint8_t row);
+    void clear(uint8_t attr = T6963_ATTR_NORMAL);
+    void scrollUp(bool homeMoved);
+    void flush();
+    void flushRow(uint8_t row);
+
+    uint8_t runCount(uint8_t row) { return (row < rows) ? numRuns[row] : 0; }
+    uint8_t columns() { return cols; }
+
+  private:
+    uint8_t expand(uint8_t row, uint8_t* line);
+    uint8_t encode(const uint8_t* line, T6963AttrRun* out);
+    uint16_t address(uint8_t col, uint8_t row);
+
+    T6963& lcd;
+    uint8_t cols;
+    uint8_t rows;
+    T6963AttrRun runs[T6963_ATTR_MAX_ROWS][T6963_ATTR_RUNS];
+    uint8_t numRuns[T6963_ATTR_MAX_ROWS];
+};
+
+#endif
@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_blit.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Moves rectangles of display RAM within the controller
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_blit.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Blit
+///  @brief  Constructor
+///  @param[in] lcd  The display to work on
+////////////////////////////////////////////////////////////////////////////////
+T6963Blit::T6963Blit(T6963& lcd)
+  : lcd(lcd), bytesMoved(0), moveMicros(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn move
+///  @brief  Copy len bytes of display RAM from src to dst.  If dst lies
+///          inside the source the chunks are taken from the end backwards,
+///          so the source is never overwritten before it is read.
+///  @param[in] src  RAM address to copy from
+///  @param[in] dst  RAM address to copy to
+///  @param[in] len  Number of bytes
+////////////////////////////////////////////////////////////////////////////////
+void T6963Blit::move(uint16_t src, uint16_t dst, uint16_t len)
+{
+  unsigned long start = micros();
+  bool backwards = (dst > src && dst < src + len);
+  uint16_t done = 0;
+  while(done < len && src != dst)
+  {
+    uint16_t n = len - done;
+    uint16_t off;
+    if(n > T6963_BLIT_CHUNK)
+    {
+      n = T6963_BLIT_CHUNK;
+    }
+    off = backwards ? len - done - n : done;
+    lcd.readBlock(src + off, line, n);
+    lcd.writeBlock(dst + off, line, n);
+    done += n;
+  }
+  bytesMoved += done;
+  moveMicros += micros() - start;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn moveRect
+///  @brief  Copy a rectangle of bytes.  Rows are done bottom up when the
+///          destination is higher in RAM, so overlapping rectangles with
+///          the same stride copy correctly.
+///  @param[in] src        RAM address of the top left source byte
+///  @param[in] srcStride  Bytes from one source row to the next
+///  @param[in] dst        RAM address of the top left destination byte
+///  @param[in] dstStride  Bytes from one destination row to the next
+///  @param[in] cols       Bytes per row
+///  @param[in] rows       Number of rows
+////////////////////////////////////////////////////////////////////////////////
+void T6963Blit::moveRect(uint16_t src, uint8_t srcStride, uint16_t dst, uint8_t dstStride,
+                         uint8_t cols, uint8_t rows)
+{
+  bool up = (dst > src);
+  for(uint8_t i = 0; i < rows; i++)
+  {
+    uint8_t r = up ? rows - 1 - i : i;
+    move(src + (uint16_t)r * srcStride, dst + (uint16_t)r * dstStride, cols);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn moveText
+///  @brief  Move a block of character cells on the text drawing page
+///  @param[in] col, row      Top left cell of the source
+///  @param[in] cols, rows    Size in cells
+///  @param[in] toCol, toRow  Top left cell of the destination
+////////////////////////////////////////////////////////////////////////////////
+void T6963Blit::moveText(uint8_t col, uint8_t row, uint8_t cols, uint8_t rows,
+                         uint8_t toCol, uint8_t toRow)
+{
+  uint16_t home = lcd.getTextDrawAddress();
+  uint8_t area = lcd.getTextArea();
+  moveRect(home + (uint16_t)row * area + col, area,
+           home + (uint16_t)toRow * area + toCol, area, cols, rows);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn moveGraphic
+///  @brief  Move a block of the graphic drawing page, in whole bytes
+///  @param[in] col, y      Top left source byte column and pixel row
+///  @param[in] cols, rows  Width in bytes, height in pixel rows
+///  @param[in] toCol, toY  Top left destination byte column and pixel row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Blit::moveGraphic(uint8_t col, uint8_t y, uint8_t cols, uint8_t rows,
+                            uint8_t toCol, uint8_t toY)
+{
+  uint16_t home = lcd.getGraphicDrawAddress();
+  uint8_t area = lcd.getGraphicArea();
+  moveRect(home + (uint16_t)y * area + col, area,
+           home + (uint16_t)toY * area + toCol, area, cols, rows);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn capture
+///  @brief  Copy displayed pixel rows, text and graphics combined, into the
+///          displayed graphic area with the screen copy command.  One
+///          command per row; the MCU moves no data.  Text and graphic areas
+///          should be the same width.
+///  @param[in] y     First pixel row
+///  @param[in] rows  Number of pixel rows
+///  @return  True if every row was copied, false if the controller
+///           reported a screen copy error
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Blit::capture(uint8_t y, uint8_t rows)
+{
+  bool rtn = true;
+  uint16_t home = lcd.getGraphicHomeAddress();
+  uint8_t area = lcd.getGraphicArea();
+  for(uint8_t i = 0; i < rows && rtn; i++)
+  {
+    lcd.setAddress(home + (uint16_t)(y + i) * area);
+    rtn = lcd.screenCopy();
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn peek
+///  @brief  Read one displayed byte, text and graphics combined
+///  @param[in]  col  Byte column
+///  @param[in]  y    Pixel row
+///  @param[out] dat  The byte shown on the panel
+///  @return  True on success, false if the controller reported an error
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Blit::peek(uint8_t col, uint8_t y, uint8_t& dat)
+{
+  lcd.setAddress(lcd.getGraphicHomeAddress() + (uint16_t)y * lcd.getGraphicArea() + col);
+  dat = lcd.screenPeek();
+  return !lcd.getScreenError();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the byte and time counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963Blit::resetCounters()
+{
+  bytesMoved = 0;
+  moveMicros = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn bytesPerSecond
+///  @return  Bytes moved per second since the counters were reset
+////////////////////////////////////////////////////////////////////////////////
+uint32_t T6963Blit::bytesPerSecond()
+{
+  uint32_t rtn = 0;
+  if(moveMicros != 0)
+  {
+    rtn = (uint64_t)bytesMoved * 1000000UL / moveMicros;
+  }
+  return rtn;
+}
@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_blit.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Moves rectangles of display RAM within the controller
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_BLIT_H
+#define T6963_BLIT_H
+
+#include "T6963.h"
+
+// Line buffer size: bytes read back per auto read burst
+#ifndef T6963_BLIT_CHUNK
+#define T6963_BLIT_CHUNK                 40
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Blit
+/// @brief VRAM to VRAM moves for windows, scroll regions and sprite
+///        restores.  Each chunk is fetched with one auto read into a small
+///        line buffer and written back with one auto write, so nothing
+///        larger than T6963_BLIT_CHUNK is held in MCU RAM.  Overlapping
+///        moves are safe in either direction.
+///
+///        capture() and peek() use the controller's screen copy and peek
+///        commands to read back what the panel shows, text and graphics
+///        combined, e.g. to freeze text into the graphic plane.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Blit
+{
+  public:
+    T6963Blit(T6963& lcd);
+
+    void move(uint16_t src, uint16_t dst, uint16_t len);
+    void moveRect(uint16_t src, uint8_t srcStride, uint16_t dst, uint8_t dstStride,
+                  uint8_t cols, uint8_t rows);
+    void moveText(uint8_t col, uint8_t row, uint8_t cols, uint8_t rows,
+                  uint8_t toCol, uint8_t toRow);
+    void moveGraphic(uint8_t col, uint8_t y, uint8_t cols, uint8_t rows,
+                     uint8_t toCol, uint8_t toY);
+
+    bool capture(uint8_t y, uint8_t rows);
+    bool peek(uint8_t col, uint8_t y, uint8_t& dat);
+
+    void resetCounters();
+    uint32_t getBytesMoved() { return bytesMoved; }
+    uint32_t bytesPerSecond();
+
+  private:
+    T6963& lcd;
+    uint8_t line[T6963_BLIT_CHUNK];
+    uint32_t bytesMoved;
+    uint32_t moveMicros;  // time spent in move()
+};
+
+#endif
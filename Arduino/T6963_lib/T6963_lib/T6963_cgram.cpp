@@ -0,0 +1,251 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_cgram.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief RAM character generator: glyph upload and LRU slot cache
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_cgram.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963CgRam
+///  @brief  Constructor
+///  @param[in] lcd    The display
+///  @param[in] page   CG RAM page for setOffsetPointer (0 to 31); the page
+///                    must not overlap the text or graphic areas
+///  @param[in] first  First character code to manage (0x80 in CG ROM mode)
+///  @param[in] count  Number of codes to manage, up to T6963_CGRAM_SLOTS
+////////////////////////////////////////////////////////////////////////////////
+T6963CgRam::T6963CgRam(T6963& lcd, uint8_t page, uint8_t first, uint8_t count)
+  : lcd(lcd), page(page), first(first), count(count), glyphs(NULL), frame(1)
+{
+  if(this->count > T6963_CGRAM_SLOTS)
+  {
+    this->count = T6963_CGRAM_SLOTS;
+  }
+  if(first + this->count > 256)
+  {
+    this->count = 256 - first;
+  }
+  flushCache();
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Point the controller's offset register at the page
+///  @return  True if the page is valid, false otherwise
+////////////////////////////////////////////////////////////////////////////////
+bool T6963CgRam::begin()
+{
+  return count != 0 && lcd.setOffsetPointer(page) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the hit and miss counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::resetCounters()
+{
+  hits = 0;
+  misses = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn flushCache
+///  @brief  Forget which glyphs are loaded.  CG RAM is not changed.
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::flushCache()
+{
+  for(uint8_t s = 0; s < count; s++)
+  {
+    ids[s] = T6963_CGRAM_EMPTY;
+    used[s] = 0;        // frame never is 0
+    prev[s] = s - 1;
+    next[s] = s + 1;
+  }
+  mru = 0;
+  lru = count - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn glyphAddress
+///  @return  RAM address of the first row of a character's glyph
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963CgRam::glyphAddress(uint8_t code)
+{
+  return ( (uint16_t)page << 11) + (uint16_t)code * T6963_CGRAM_GLYPH;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn load
+///  @brief  Upload one glyph with a single auto write.  Rows top to bottom,
+///          MSB leftmost; a 6 pixel font uses the low 6 bits.
+///  @param[in] code  Character code to define
+///  @param[in] bits  8 bytes of glyph rows
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::load(uint8_t code, const uint8_t* bits)
+{
+  lcd.writeBlock(glyphAddress(code), bits, T6963_CGRAM_GLYPH);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn load_P
+///  @brief  As load, with the glyph held in PROGMEM
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::load_P(uint8_t code, const uint8_t* bits)
+{
+  uint8_t buf[T6963_CGRAM_GLYPH];
+  for(uint8_t i = 0; i < T6963_CGRAM_GLYPH; i++)
+  {
+    buf[i] = pgm_read_byte(&bits[i]);
+  }
+  load(code, buf);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn unlink
+///  @brief  Take a slot out of the recency list
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::unlink(uint8_t s)
+{
+  if(s == mru)
+  {
+    mru = next[s];
+  }
+  else
+  {
+    next[prev[s]] = next[s];
+  }
+  if(s == lru)
+  {
+    lru = prev[s];
+  }
+  else
+  {
+    prev[next[s]] = prev[s];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pushFront
+///  @brief  Make a slot the most recently used
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::pushFront(uint8_t s)
+{
+  if(s != mru)
+  {
+    unlink(s);
+    prev[mru] = s;
+    next[s] = mru;
+    mru = s;
+  }
+  used[s] = frame;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn lookup
+///  @return  Slot holding glyph id, or -1 if it is not loaded
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963CgRam::lookup(uint16_t id)
+{
+  int16_t rtn = -1;
+  for(uint8_t s = 0; s < count && rtn < 0; s++)
+  {
+    if(ids[s] == id)
+    {
+      rtn = s;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn claim
+///  @brief  Find or load a glyph
+///  @param[in] id    Caller's glyph number
+///  @param[in] bits  Glyph rows, used only on a miss
+///  @param[in] pgm   True if bits is in PROGMEM
+///  @return  Character code, -1 if every slot is in use this frame
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963CgRam::claim(uint16_t id, const uint8_t* bits, bool pgm)
+{
+  int16_t rtn = -1;
+  int16_t s = (count != 0) ? lookup(id) : -1;
+  if(s >= 0)
+  {
+    hits++;
+    pushFront(s);
+    rtn = first + s;
+  }
+  else if(count != 0 && used[lru] != frame && bits != NULL)
+  {
+    // Glyphs used this frame are all at the front, so the LRU slot is free
+    s = lru;
+    misses++;
+    ids[s] = id;
+    pushFront(s);
+    rtn = first + s;
+    if(pgm)
+    {
+      load_P(rtn, bits);
+    }
+    else
+    {
+      load(rtn, bits);
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn acquire
+///  @brief  Code for glyph id, from the table given to setGlyphs_P
+///  @return  Character code, -1 if every slot is in use this frame or no
+///           table is set
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963CgRam::acquire(uint16_t id)
+{
+  const uint8_t* bits = NULL;
+  if(glyphs != NULL)
+  {
+    bits = glyphs + (uint32_t)id * T6963_CGRAM_GLYPH;
+  }
+  return claim(id, bits, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn acquire
+///  @brief  Code for glyph id, uploading bits (in RAM) on a miss
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963CgRam::acquire(uint16_t id, const uint8_t* bits)
+{
+  return claim(id, bits, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn acquire_P
+///  @brief  Code for glyph id, uploading bits (in PROGMEM) on a miss
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963CgRam::acquire_P(uint16_t id, const uint8_t* bits)
+{
+  return claim(id, bits, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn newFrame
+///  @brief  Start a new screen: glyphs acquired so far may be evicted again
+////////////////////////////////////////////////////////////////////////////////
+void T6963CgRam::newFrame()
+{
+  frame++;
+  if(frame == 0)
+  {
+    // the counter wrapped, make every stamp older than the new frame
+    for(uint8_t s = 0; s < count; s++)
+    {
+      used[s] = 0;
+    }
+    frame = 1;
+  }
+}
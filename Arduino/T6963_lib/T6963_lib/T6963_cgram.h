@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_cgram.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief RAM character generator: glyph upload and LRU slot cache
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_CGRAM_H
+#define T6963_CGRAM_H
+
+#include "T6963.h"
+
+// Most character codes one manager hands out (RAM per slot: 4 bytes)
+#ifndef T6963_CGRAM_SLOTS
+#define T6963_CGRAM_SLOTS                32
+#endif
+
+// Bytes per glyph in CG RAM
+#define T6963_CGRAM_GLYPH                 8
+
+// Slot holding no glyph
+#define T6963_CGRAM_EMPTY            0xffff
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963CgRam
+/// @brief Loads custom glyphs into the 2K CG RAM page selected with
+///        setOffsetPointer and shares a range of character codes between
+///        more glyphs than fit.  In CG ROM mode codes 0x80-0xff come from
+///        the upper half of the page; in CG RAM mode all 256 do.
+///
+///        acquire(id) returns the code that shows glyph id, uploading it
+///        over the least recently used slot only on a miss.  Glyphs
+///        acquired since the last newFrame() are never evicted, so text
+///        on screen cannot change under the caller; acquire returns -1
+///        when every slot is in use this frame.  Any code it returns,
+///        0 included when first is 0, is a valid character code.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963CgRam
+{
+  public:
+    T6963CgRam(T6963& lcd, uint8_t page, uint8_t first = 0x80,
+               uint8_t count = T6963_CGRAM_SLOTS);
+    bool begin();
+    void setGlyphs_P(const uint8_t* table) { glyphs = table; }
+
+    void load(uint8_t code, const uint8_t* bits);
+    void load_P(uint8_t code, const uint8_t* bits);
+    uint16_t glyphAddress(uint8_t code);
+
+    int16_t acquire(uint16_t id);
+    int16_t acquire(uint16_t id, const uint8_t* bits);
+    int16_t acquire_P(uint16_t id, const uint8_t* bits);
+    int16_t lookup(uint16_t id);
+    void newFrame();
+    void flushCache();
+
+    uint32_t getHits() { return hits; }
+    uint32_t getMisses() { return misses; }
+    void resetCounters();
+
+  private:
+    int16_t claim(uint16_t id, const uint8_t* bits, bool pgm);
+    void unlink(uint8_t s);
+    void pushFront(uint8_t s);
+
+    T6963& lcd;
+    uint8_t page;                 // CG RAM at page << 11
+    uint8_t first;                // code of slot 0
+    uint8_t count;                // slots in use
+    const uint8_t* glyphs;        // PROGMEM table, 8 bytes per id
+    uint16_t ids[T6963_CGRAM_SLOTS];
+    uint8_t prev[T6963_CGRAM_SLOTS];
+    uint8_t next[T6963_CGRAM_SLOTS];
+    uint8_t used[T6963_CGRAM_SLOTS];  // frame the slot was last acquired in
+    uint8_t mru;                  // most recently used slot
+    uint8_t lru;                  // least recently used slot
+    uint8_t frame;
+    uint32_t hits;
+    uint32_t misses;
+};
+
+#endif
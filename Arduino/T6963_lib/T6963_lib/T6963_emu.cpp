@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_emu.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Software model of the T6963C controller for host testing
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_emu.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Emulator
+///  @brief  Constructor.
+///  @param[in] columns    Displayed columns (panel width / font width)
+///  @param[in] height     Displayed pixel rows
+///  @param[in] fontWidth  6 or 8, as selected by the FS pin
+////////////////////////////////////////////////////////////////////////////////
+T6963Emulator::T6963Emulator(uint8_t columns, uint8_t height, uint8_t fontWidth)
+  : romFont(NULL), columns(columns), height(height), fontWidth(fontWidth)
+{
+  memset(vram, 0, sizeof(vram));
+  reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn reset
+///  @brief  Hardware reset: registers cleared, VRAM kept, counters cleared
+////////////////////////////////////////////////////////////////////////////////
+void T6963Emulator::reset()
+{
+  numParams = 0;
+  dataLatch = 0;
+  error = 0;
+  busyUntil = 0;
+  addressPointer = 0;
+  textHome = 0;
+  textArea = 0;
+  graphicHome = 0;
+  graphicArea = 0;
+  offset = 0;
+  cursor = 0;
+  mode = 0;
+  displayMode = 0;
+  cursorSize = 0;
+  autoMode = 0;
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the traffic counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963Emulator::resetCounters()
+{
+  memset(&counters, 0, sizeof(counters));
+  busyUntil = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setRomFont
+///  @brief  Supply glyphs for the internal CG ROM (128 codes x 8 rows).
+///          Without one, ROM characters display blank.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Emulator::setRomFont(const uint8_t* font)
+{
+  romFont = font;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn busy
+///  @brief  Controller is busy for the given number of bus cycles
+////////////////////////////////////////////////////////////////////////////////
+void T6963Emulator::busy(uint8_t cycles)
+{
+  busyUntil = counters.busCycles + cycles;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn write
+///  @brief  Bus write strobe
+///  @param[in] cd  HIGH for a command, LOW for data
+///  @param[in] d   The byte on the bus
+////////////////////////////////////////////////////////////////////////////////
+void T6963Emulator::write(uint8_t cd, uint8_t d)
+{
+  counters.busCycles++;
+  if(cd != LOW)
+  {
+    counters.commands++;
+    command(d);
+  }
+  else
+  {
+    counters.dataWrites++;
+    if(autoMode == T6963_AUTO_WRITE_SET)
+    {
+      vram[addressPointer % T6963_EMU_RAM_SIZE] = d;
+      addressPointer++;
+      busy(T6963_EMU_AUTO_BUSY);
+    }
+    else
+    {
+      if(numParams == 2)
+      {
+        params[0] = params[1];   // only the last two bytes are kept
+        numParams = 1;
+      }
+      params[numParams++] = d;
+      busy(T6963_EMU_DATA_BUSY);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn read
+///  @brief  Bus read strobe
+///  @param[in] cd  HIGH for the status byte, LOW for data
+///  @return  Status byte or data byte
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Emulator::read(uint8_t cd)
+{
+  uint8_t rtn = 0;
+  bool ready = (counters.busCycles >= busyUntil);
+  counters.busCycles++;
+  if(cd != LOW)
+  {
+    counters.statusReads++;
+    rtn = T6963_STA5 | error;
+    if(ready)
+    {
+      if(autoMode == T6963_AUTO_WRITE_SET)
+      {
+        rtn |= T6963_STA3;
+      }
+      else if(autoMode == T6963_AUTO_READ_SET)
+      {
+        rtn |= T6963_STA2;
+      }
+      else
+      {
+        rtn |= T6963_STA0 | T6963_STA1;
+      }
+    }
+    else
+    {
+      counters.busyPolls++;
+    }
+  }
+  else
+  {
+    counters.dataReads++;
+    if(autoMode == T6963_AUTO_READ_SET)
+    {
+      rtn = vram[addressPointer % T6963_EMU_RAM_SIZE];
+      addressPointer++;
+      busy(T6963_EMU_AUTO_BUSY);
+    }
+    else
+    {
+      rtn = dataLatch;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn command
+///  @brief  Execute a command using the parameter bytes written before it
+///  @param[in] cmd The command byte
+////////////////////////////////////////////////////////////////////////////////
+void T6963Emulator::command(uint8_t cmd)
+{
+  uint8_t d1 = (numParams > 0) ? params[0] : 0;
+  uint8_t d2 = (numParams > 1) ? params[1] : 0;
+  uint16_t word = d1 | (d2 << 8);
+  uint16_t ap = addressPointer % T6963_EMU_RAM_SIZE;
+  numParams = 0;
+  busy(T6963_EMU_CMD_BUSY);
+
+  if(autoMode != 0 && (cmd & 0xfe) != T6963_AUTO_RESET)
+  {
+    counters.errors++;    // only auto reset is accepted in auto mode
+  }
+  else if(cmd == T6963_SET_CURSOR_POINTER)
+  {
+    cursor = word;
+  }
+  else if(cmd == T6963_SET_OFFSET_REGISTER)
+  {
+    offset = d1 & 0x1f;
+  }
+  else if(cmd == T6963_SET_ADDRESS_POINTER)
+  {
+    addressPointer = word;
+  }
+  else if(cmd == T6963_SET_TEXT_HOME_ADDRESS)
+  {
+    textHome = word;
+  }
+  else if(cmd == T6963_SET_TEXT_AREA)
+  {
+    textArea = d1;
+  }
+  else if(cmd == T6963_SET_GRAPHIC_HOME_ADDRESS)
+  {
+    graphicHome = word;
+  }
+  else if(cmd == T6963_SET_GRAPHIC_AREA)
+  {
+    graphicArea = d1;
+  }
+  else if( (cmd & 0xf0) == T6963_SET_MODE)
+  {
+    mode = cmd & 0x0f;
+  }
+  else if( (cmd & 0xf0) == T6963_DISPLAY_MODE)
+  {
+    displayMode = cmd & 0x0f;
+  }
+  else if( (cmd & 0xf8) == T6963_CURSOR_SIZE)
+  {
+    cursorSize = cmd & 0x07;
+  }
+  else if(cmd == T6963_AUTO_WRITE_SET || cmd == T6963_AUTO_READ_SET)
+  {
+    autoMode = cmd;
+  }
+  else if( (cmd & 0xfe) == T6963_AUTO_RESET)
+  {
+    autoMode = 0;
+  }
+  else if( (cmd & 0xf8) == T6963_DATA_WRITE_INC && (cmd & 0x06) != 0x06)
+  {
+    if(cmd & 0x01)
+    {
+      dataLatch = vram[ap];
+    }
+    else
+    {
+      vram[ap] = d1;
+    }
+    if( (cmd & 0x04) == 0)
+    {
+      addressPointer += (cmd & 0x02) ? -1 : 1;
+    }
+  }
+  else if(cmd == T6963_SCREEN_PEEK || cmd == T6963_SCREEN_COPY)
+  {
+    // Address pointer must lie inside the displayed graphic area
+    uint16_t off = ap - graphicHome;
+    error = 0;
+    if(graphicArea == 0 || ap < graphicHome || off / graphicArea >= height ||
+       off % graphicArea >= columns)
+    {
+      error = T6963_STA6;
+    }
+    else if(cmd == T6963_SCREEN_PEEK)
+    {
+      dataLatch = displayByte(off % graphicArea, off / graphicArea);
+    }
+    else
+    {
+      uint8_t y = off / graphicArea;
+      uint8_t line[256];
+      for(uint8_t c = 0; c < columns; c++)
+      {
+        line[c] = displayByte(c, y);
+      }
+      uint16_t dst = graphicHome + (uint16_t)y * graphicArea;
+      for(uint8_t c = 0; c < columns; c++)
+      {
+        vram[(dst + c) % T6963_EMU_RAM_SIZE] = line[c];
+      }
+    }
+  }
+  else if( (cmd & 0xf0) == T6963_SET_RESET)
+  {
+    if(cmd & 0x08)
+    {
+      vram[ap] |= (1 << (cmd & 0x07));
+    }
+    else
+    {
+      vram[ap] &= ~(1 << (cmd & 0x07));
+    }
+  }
+  else
+  {
+    counters.errors++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn glyphRow
+///  @brief  One pixel row of a character from CG ROM or CG RAM
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Emulator::glyphRow(uint8_t code, uint8_t row)
+{
+  uint8_t rtn = 0;
+  if(code < 0x80 && (mode & T6963_MODE_RAM_CG) == 0)
+  {
+    if(romFont != NULL)
+    {
+      rtn = romFont[code * 8 + row];
+    }
+  }
+  else
+  {
+    uint16_t addr = ((uint16_t)offset << 11) + code * 8 + row;
+    rtn = vram[addr % T6963_EMU_RAM_SIZE];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn displayByte
+///  @brief  The byte the panel shows at one column and pixel row, after
+///          combining text and graphics in the current mode.
+///  @param[in] col  Column (0 to columns - 1)
+///  @param[in] y    Pixel row (0 to height - 1)
+///  @return  Displayed pixels, MSB leftmost, fontWidth bits used
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Emulator::displayByte(uint8_t col, uint8_t y)
+{
+  uint8_t mask = (fontWidth == 6) ? 0x3f : 0xff;
+  uint8_t t = 0;
+  uint8_t g = 0;
+  uint8_t rtn = 0;
+
+  if(displayMode & T6963_DISPLAY_TEXT)
+  {
+    uint16_t cell = textHome + (uint16_t)(y / 8) * textArea + col;
+    t = glyphRow(vram[cell % T6963_EMU_RAM_SIZE], y % 8);
+  }
+  if( (mode & 0x07) == T6963_MODE_TEXT_ATTRIBUTE)
+  {
+    // Graphic area holds one attribute byte per text cell
+    uint16_t cell = graphicHome + (uint16_t)(y / 8) * graphicArea + col;
+    uint8_t a = vram[cell % T6963_EMU_RAM_SIZE] & 0x07;
+    if(a == 0x05)
+    {
+      t = ~t;            // reverse
+    }
+    else if(a == 0x03)
+    {
+      t = 0;             // inhibit
+    }
+    rtn = t;
+  }
+  else
+  {
+    if(displayMode & T6963_DISPLAY_GRAPHICS)
+    {
+      uint16_t addr = graphicHome + (uint16_t)y * graphicArea + col;
+      g = vram[addr % T6963_EMU_RAM_SIZE];
+    }
+    switch(mode & 0x07)
+    {
+      case T6963_MODE_EXOR:
+        rtn = t ^ g;
+        break;
+      case T6963_MODE_AND:
+        rtn = t & g;
+        break;
+      default:
+        rtn = t | g;
+        break;
+    }
+  }
+  return rtn & mask;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pixel
+///  @return  True if the displayed pixel at x, y is dark
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Emulator::pixel(uint8_t x, uint8_t y)
+{
+  uint8_t b = displayByte(x / fontWidth, y);
+  return (b >> (fontWidth - 1 - x % fontWidth)) & 0x01;
+}
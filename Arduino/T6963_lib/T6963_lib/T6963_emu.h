@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_emu.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Software model of the T6963C controller for host testing
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_EMU_H
+#define T6963_EMU_H
+
+#include "T6963.h"
+
+// Display RAM attached to the controller (DG-24064 has 8K)
+#ifndef T6963_EMU_RAM_SIZE
+#define T6963_EMU_RAM_SIZE             8192
+#endif
+
+// Busy times in bus cycles.  A status read during a busy period returns
+// STA0..STA3 clear and counts as a busy poll.
+#ifndef T6963_EMU_CMD_BUSY
+#define T6963_EMU_CMD_BUSY                2     // after a command
+#endif
+#ifndef T6963_EMU_DATA_BUSY
+#define T6963_EMU_DATA_BUSY               1     // after a data byte
+#endif
+#ifndef T6963_EMU_AUTO_BUSY
+#define T6963_EMU_AUTO_BUSY               1     // after an auto mode byte
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963EmuCounters
+/// @brief  Bus traffic seen by the emulator
+//////////////////////////////////////////////////////////////////////////////
+
+struct T6963EmuCounters
+{
+  uint32_t busCycles;      // every read or write strobe
+  uint32_t statusReads;
+  uint32_t busyPolls;      // status reads that found the controller busy
+  uint32_t dataWrites;
+  uint32_t dataReads;
+  uint32_t commands;
+  uint32_t errors;         // unknown commands, commands during auto mode
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Emulator
+/// @brief Models VRAM, the address pointer, home/area registers, logic and
+///        attribute modes, auto read/write and STA0-STA3/STA6.  Drive it
+///        with a T6963 built with T6963_BUS = T6963_BUS_EXTERNAL.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Emulator : public T6963Bus
+{
+  public:
+    T6963Emulator(uint8_t columns = 40, uint8_t height = 64, uint8_t fontWidth = 6);
+    void reset();
+    void write(uint8_t cd, uint8_t d);
+    uint8_t read(uint8_t cd);
+
+    void setRomFont(const uint8_t* font);
+    uint8_t displayByte(uint8_t col, uint8_t y);
+    bool pixel(uint8_t x, uint8_t y);
+
+    uint8_t ram(uint16_t addr) { return vram[addr % T6963_EMU_RAM_SIZE]; }
+    void ram(uint16_t addr, uint8_t d) { vram[addr % T6963_EMU_RAM_SIZE] = d; }
+    uint16_t getAddressPointer() { return addressPointer; }
+    uint16_t getTextHome() { return textHome; }
+    uint8_t getTextArea() { return textArea; }
+    uint16_t getGraphicHome() { return graphicHome; }
+    uint8_t getGraphicArea() { return graphicArea; }
+    uint8_t getOffset() { return offset; }
+    uint8_t getMode() { return mode; }
+    uint8_t getDisplayMode() { return displayMode; }
+    uint16_t getCursor() { return cursor; }
+    uint8_t getAutoMode() { return autoMode; }
+    uint32_t now() { return counters.busCycles; }
+
+    void resetCounters();
+    T6963EmuCounters counters;
+
+  private:
+    void command(uint8_t cmd);
+    uint8_t glyphRow(uint8_t code, uint8_t row);
+    void busy(uint8_t cycles);
+
+    uint8_t vram[T6963_EMU_RAM_SIZE];
+    const uint8_t* romFont;    // 128 glyphs x 8 rows, NULL = blank ROM
+
+    uint8_t columns;           // displayed columns
+    uint8_t height;            // displayed pixel rows
+    uint8_t fontWidth;         // 6 or 8, from FS
+
+    uint8_t params[2];
+    uint8_t numParams;
+    uint8_t dataLatch;         // result of data read / screen peek
+    uint8_t error;             // STA6
+    uint32_t busyUntil;
+
+    uint16_t addressPointer;
+    uint16_t textHome;
+    uint8_t textArea;
+    uint16_t graphicHome;
+    uint8_t graphicArea;
+    uint8_t offset;
+    uint16_t cursor;
+    uint8_t mode;
+    uint8_t displayMode;
+    uint8_t cursorSize;
+    uint8_t autoMode;          // 0, T6963_AUTO_WRITE_SET or T6963_AUTO_READ_SET
+};
+
+#endif
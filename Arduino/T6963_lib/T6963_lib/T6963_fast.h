@@ -0,0 +1,348 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_fast.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief T6963 bus with the pin assignment fixed at compile time
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_FAST_H
+#define T6963_FAST_H
+
+#include "T6963.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963Pin
+/// @brief  One pin known at compile time.  On the ATmega328P / 168 the port
+///         register and bit are worked out by the compiler, so set() and
+///         get() become single sbi / cbi / sbis instructions.  Where the
+///         core has the port register macros they are used with constant
+///         pins (an unguarded read-modify-write), otherwise set() and get()
+///         fall back to digitalWrite / digitalRead.  Pin 0 means not
+///         connected, as in the T6963 constructor.
+//////////////////////////////////////////////////////////////////////////////
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+
+// Uno / Nano: 0-7 PORTD, 8-13 PORTB, 14-19 (A0-A5) PORTC
+template<uint8_t PIN>
+struct T6963Pin
+{
+  static const uint8_t mask = 1 << ( (PIN < 8) ? PIN : (PIN < 14) ? PIN - 8 : PIN - 14);
+  static volatile uint8_t& port() { return (PIN < 8) ? PORTD : (PIN < 14) ? PORTB : PORTC; }
+  static volatile uint8_t& ddr() { return (PIN < 8) ? DDRD : (PIN < 14) ? DDRB : DDRC; }
+  static volatile uint8_t& pin() { return (PIN < 8) ? PIND : (PIN < 14) ? PINB : PINC; }
+
+  static void output() { ddr() |= mask; }
+  static void input() { ddr() &= ~mask; port() &= ~mask; }
+  static void set(uint8_t level)
+  {
+    if(level)
+    {
+      port() |= mask;
+    }
+    else
+    {
+      port() &= ~mask;
+    }
+  }
+  static uint8_t get() { return (pin() & mask) != 0; }
+};
+
+#elif defined(portOutputRegister) && defined(portInputRegister) && defined(portModeRegister)
+
+template<uint8_t PIN>
+struct T6963Pin
+{
+  static volatile T6963_PORT_REG_TYPE& port()
+  {
+    return *(volatile T6963_PORT_REG_TYPE*)portOutputRegister(digitalPinToPort(PIN));
+  }
+  static volatile T6963_PORT_REG_TYPE& ddr()
+  {
+    return *(volatile T6963_PORT_REG_TYPE*)portModeRegister(digitalPinToPort(PIN));
+  }
+  static volatile T6963_PORT_REG_TYPE& pin()
+  {
+    return *(volatile T6963_PORT_REG_TYPE*)portInputRegister(digitalPinToPort(PIN));
+  }
+
+  static void output() { ddr() |= digitalPinToBitMask(PIN); }
+  static void input() { ddr() &= ~digitalPinToBitMask(PIN); port() &= ~digitalPinToBitMask(PIN); }
+  static void set(uint8_t level)
+  {
+    if(level)
+    {
+      port() |= digitalPinToBitMask(PIN);
+    }
+    else
+    {
+      port() &= ~digitalPinToBitMask(PIN);
+    }
+  }
+  static uint8_t get() { return (pin() & digitalPinToBitMask(PIN)) != 0; }
+};
+
+#else
+
+template<uint8_t PIN>
+struct T6963Pin
+{
+  static void output() { pinMode(PIN, OUTPUT); }
+  static void input() { pinMode(PIN, INPUT); }
+  static void set(uint8_t level) { digitalWrite(PIN, level); }
+  static uint8_t get() { return digitalRead(PIN) != LOW; }
+};
+
+#endif
+
+// Wait between CE going low and sampling the data pins on a read: the
+// access time tACC is up to 150 nS.  Three cycles at 16 MHz is 187 nS,
+// the sbis / in that follows adds more.  Cores without cycle delays get
+// there through digitalRead / the port register call chain; define it
+// to something longer for fast non-AVR parts.
+#ifndef T6963_FAST_ACCESS_DELAY
+#if defined(__AVR__)
+#define T6963_FAST_ACCESS_DELAY()         __builtin_avr_delay_cycles(3)
+#else
+#define T6963_FAST_ACCESS_DELAY()
+#endif
+#endif
+
+template<>
+struct T6963Pin<0>
+{
+  static void output() {}
+  static void input() {}
+  static void set(uint8_t) {}
+  static uint8_t get() { return 0; }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963PinBus
+/// @brief  Data bus policy for T6963Fast: D0-D7 on any eight pins
+//////////////////////////////////////////////////////////////////////////////
+
+template<uint8_t D0, uint8_t D1, uint8_t D2, uint8_t D3,
+         uint8_t D4, uint8_t D5, uint8_t D6, uint8_t D7>
+struct T6963PinBus
+{
+  static void output()
+  {
+    T6963Pin<D0>::output(); T6963Pin<D1>::output();
+    T6963Pin<D2>::output(); T6963Pin<D3>::output();
+    T6963Pin<D4>::output(); T6963Pin<D5>::output();
+    T6963Pin<D6>::output(); T6963Pin<D7>::output();
+  }
+  static void input()
+  {
+    T6963Pin<D0>::input(); T6963Pin<D1>::input();
+    T6963Pin<D2>::input(); T6963Pin<D3>::input();
+    T6963Pin<D4>::input(); T6963Pin<D5>::input();
+    T6963Pin<D6>::input(); T6963Pin<D7>::input();
+  }
+  static void write(uint8_t d)
+  {
+    T6963Pin<D0>::set(d & 0x01); T6963Pin<D1>::set(d & 0x02);
+    T6963Pin<D2>::set(d & 0x04); T6963Pin<D3>::set(d & 0x08);
+    T6963Pin<D4>::set(d & 0x10); T6963Pin<D5>::set(d & 0x20);
+    T6963Pin<D6>::set(d & 0x40); T6963Pin<D7>::set(d & 0x80);
+  }
+  static uint8_t read()
+  {
+    return T6963Pin<D0>::get()        | (T6963Pin<D1>::get() << 1) |
+           (T6963Pin<D2>::get() << 2) | (T6963Pin<D3>::get() << 3) |
+           (T6963Pin<D4>::get() << 4) | (T6963Pin<D5>::get() << 5) |
+           (T6963Pin<D6>::get() << 6) | (T6963Pin<D7>::get() << 7);
+  }
+};
+
+// Data bus on the default pins from T6963.h
+typedef T6963PinBus<T6963_D0, T6963_D1, T6963_D2, T6963_D3,
+                    T6963_D4, T6963_D5, T6963_D6, T6963_D7> T6963DefaultBus;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Fast
+/// @brief Bus strobes, status checks and block transfers with every pin a
+///        template parameter, so there is no pin table to look up.  All
+///        members are static: use it directly for tight transfers, or build
+///        with T6963_BUS = T6963_BUS_FAST and T6963 calls T6963_FAST_BUS
+///        for every byte, inlined with no virtual call, under the full API.
+///
+///        typedef T6963Fast<T6963DefaultBus, T6963_WR, T6963_RD, T6963_CE,
+///                          T6963_CD, T6963_FONT, T6963_RES> Display;
+//////////////////////////////////////////////////////////////////////////////
+
+template<class Bus, uint8_t WR, uint8_t RD, uint8_t CE, uint8_t CD,
+         uint8_t FS = 0, uint8_t RES = 0>
+class T6963Fast
+{
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn ports_init
+    ///  @brief  Set up the control pins, select the font and reset the
+    ///          controller
+    ///  @param[in] fontWidth  6 or 8
+    ////////////////////////////////////////////////////////////////////////////
+    static void ports_init(uint8_t fontWidth = 6)
+    {
+      direction = 0xff;
+      T6963Pin<CE>::set(HIGH);
+      T6963Pin<CE>::output();
+      T6963Pin<WR>::set(HIGH);
+      T6963Pin<WR>::output();
+      T6963Pin<RD>::set(HIGH);
+      T6963Pin<RD>::output();
+      T6963Pin<CD>::set(HIGH);
+      T6963Pin<CD>::output();
+      setFontWidth(fontWidth);
+      T6963Pin<FS>::output();
+      T6963Pin<RES>::set(LOW);
+      T6963Pin<RES>::output();
+      setDataDirection(OUTPUT);
+      delay(5);  // Give RESET 5 milliseconds
+      T6963Pin<RES>::set(HIGH);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn setFontWidth
+    ///  @brief  Drive FS for the 6x8 or 8x8 font, if it is wired
+    ////////////////////////////////////////////////////////////////////////////
+    static void setFontWidth(uint8_t fontWidth)
+    {
+      T6963Pin<FS>::set(fontWidth == 8 ? LOW : HIGH);  // HIGH: 6x8, LOW: 8x8
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn write
+    ///  @brief  Strobe one byte onto the bus, no status check
+    ///  @param[in] cd  HIGH for a command, LOW for data
+    ////////////////////////////////////////////////////////////////////////////
+    static void write(uint8_t cd, uint8_t d)
+    {
+      setDataDirection(OUTPUT);
+      Bus::write(d);
+      T6963Pin<CD>::set(cd);
+      T6963Pin<WR>::set(LOW);
+      T6963Pin<CE>::set(LOW);
+      T6963Pin<CE>::set(HIGH);  // min pulse width 80 nS
+      T6963Pin<WR>::set(HIGH);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn read
+    ///  @brief  Strobe one byte off the bus
+    ///  @param[in] cd  HIGH for the status byte, LOW for data
+    ////////////////////////////////////////////////////////////////////////////
+    static uint8_t read(uint8_t cd)
+    {
+      uint8_t rtn;
+      setDataDirection(INPUT);
+      T6963Pin<CD>::set(cd);
+      T6963Pin<RD>::set(LOW);
+      T6963Pin<CE>::set(LOW);
+      T6963_FAST_ACCESS_DELAY();  // access time 150 nS
+      rtn = Bus::read();
+      T6963Pin<CE>::set(HIGH);
+      T6963Pin<RD>::set(HIGH);
+      return rtn;
+    }
+
+    static uint8_t getStatus() { return read(HIGH); }
+    static uint8_t getData() { return read(LOW); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn waitStatus
+    ///  @brief  Poll until all bits in mask are set in the status byte
+    ////////////////////////////////////////////////////////////////////////////
+    static void waitStatus(uint8_t mask)
+    {
+      while( (getStatus() & mask) != mask)
+      {
+      }
+    }
+
+    static void writeDataByte(uint8_t dat) { waitStatus(0x03); write(LOW, dat); }
+    static void writeCommandByte(uint8_t cmd) { waitStatus(0x03); write(HIGH, cmd); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn command
+    ///  @brief  Send a command with two parameter bytes
+    ////////////////////////////////////////////////////////////////////////////
+    static void command(uint8_t cmd, uint8_t d1, uint8_t d2)
+    {
+      writeDataByte(d1);
+      writeDataByte(d2);
+      writeCommandByte(cmd);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn writeBlock
+    ///  @brief  Write bytes to RAM with one auto write transfer
+    ////////////////////////////////////////////////////////////////////////////
+    static void writeBlock(uint16_t addr, const uint8_t* buf, uint16_t len)
+    {
+      command(T6963_SET_ADDRESS_POINTER, addr & 0xff, addr >> 8);
+      writeCommandByte(T6963_AUTO_WRITE_SET);
+      for(uint16_t i = 0; i < len; i++)
+      {
+        waitStatus(0x08);   // STA3
+        write(LOW, buf[i]);
+      }
+      waitStatus(0x08);
+      write(HIGH, T6963_AUTO_RESET);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn readBlock
+    ///  @brief  Read bytes from RAM with one auto read transfer
+    ////////////////////////////////////////////////////////////////////////////
+    static void readBlock(uint16_t addr, uint8_t* buf, uint16_t len)
+    {
+      command(T6963_SET_ADDRESS_POINTER, addr & 0xff, addr >> 8);
+      writeCommandByte(T6963_AUTO_READ_SET);
+      for(uint16_t i = 0; i < len; i++)
+      {
+        waitStatus(0x04);   // STA2
+        buf[i] = read(LOW);
+      }
+      waitStatus(0x04);
+      write(HIGH, T6963_AUTO_RESET);
+    }
+
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    ///  @fn setDataDirection
+    ///  @brief  Switch the data pins only when the direction changes
+    ////////////////////////////////////////////////////////////////////////////
+    static void setDataDirection(uint8_t dir)
+    {
+      if(dir != direction)
+      {
+        if(dir == OUTPUT)
+        {
+          Bus::output();
+        }
+        else
+        {
+          Bus::input();
+        }
+        direction = dir;
+      }
+    }
+
+    static uint8_t direction;    // OUTPUT, INPUT, 0xff unknown
+};
+
+template<class Bus, uint8_t WR, uint8_t RD, uint8_t CE, uint8_t CD, uint8_t FS, uint8_t RES>
+uint8_t T6963Fast<Bus, WR, RD, CE, CD, FS, RES>::direction = 0xff;
+
+// The bus T6963 drives when built with T6963_BUS = T6963_BUS_FAST.  Define
+// T6963_FAST_BUS before including T6963_fast.h to use other pins.
+#ifndef T6963_FAST_BUS
+typedef T6963Fast<T6963DefaultBus, T6963_WR, T6963_RD, T6963_CE,
+                  T6963_CD, T6963_FONT, T6963_RES> T6963DefaultFast;
+#define T6963_FAST_BUS                    T6963DefaultFast
+#endif
+
+#endif
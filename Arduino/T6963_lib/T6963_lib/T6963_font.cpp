@@ -0,0 +1,358 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_font.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Proportional bitmap fonts drawn into the graphic area
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_font.h"
+
+// Widest glyph slice merged in one pass (plus up to 7 bits of shift)
+#define FONT_STRIP                       24
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Text
+///  @brief  Constructor
+///  @param[in] lcd     The display
+///  @param[in] width   Panel width in pixels
+///  @param[in] height  Panel height in pixels
+////////////////////////////////////////////////////////////////////////////////
+T6963Text::T6963Text(T6963& lcd, uint8_t width, uint8_t height)
+  : lcd(lcd), fb(NULL), w(width), h(height), lineBuf(NULL), lineSize(0),
+    bitmap(NULL), glyphs(NULL), first(1), last(0), yAdvance(0), asc(0),
+    hits(0), misses(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setFont
+///  @brief  Select the font for following text
+///  @param[in] font  A T6963Font in PROGMEM
+////////////////////////////////////////////////////////////////////////////////
+void T6963Text::setFont(const T6963Font* font)
+{
+  if(font != NULL)
+  {
+    bitmap = (const uint8_t*)pgm_read_ptr(&font->bitmap);
+    glyphs = (const T6963Glyph*)pgm_read_ptr(&font->glyph);
+    first = pgm_read_word(&font->first);
+    last = pgm_read_word(&font->last);
+    yAdvance = pgm_read_byte(&font->yAdvance);
+    asc = 0;
+    for(uint16_t c = first; c <= last; c++)
+    {
+      int8_t rise = -(int8_t)pgm_read_byte(&glyphs[c - first].yOffset);
+      if(rise > (int8_t)asc)
+      {
+        asc = rise;
+      }
+    }
+  }
+#if T6963_FONT_CACHE > 0
+  for(uint8_t i = 0; i < T6963_FONT_CACHE; i++)
+  {
+    cache[i].code = 0xffff;
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setLineBuffer
+///  @brief  Give printLine a buffer of at least lineBufferSize() bytes
+////////////////////////////////////////////////////////////////////////////////
+void T6963Text::setLineBuffer(uint8_t* buf, uint16_t size)
+{
+  lineBuf = buf;
+  lineSize = size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn lineBufferSize
+///  @return  Bytes printLine needs for one line of the current font
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Text::lineBufferSize()
+{
+  return (uint16_t)lcd.getGraphicArea() * yAdvance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readGlyph
+///  @brief  Copy a glyph entry out of PROGMEM
+///  @return  False if the font has no glyph for c
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Text::readGlyph(uint8_t c, T6963Glyph& g)
+{
+  bool rtn = false;
+  if(glyphs != NULL && c >= first && c <= last)
+  {
+    const T6963Glyph* p = &glyphs[c - first];
+    g.bitmapOffset = pgm_read_word(&p->bitmapOffset);
+    g.width = pgm_read_byte(&p->width);
+    g.height = pgm_read_byte(&p->height);
+    g.xAdvance = pgm_read_byte(&p->xAdvance);
+    g.xOffset = pgm_read_byte(&p->xOffset);
+    g.yOffset = pgm_read_byte(&p->yOffset);
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readBits
+///  @brief  Unpack n (1 to FONT_STRIP) bits from the font bitmap
+///  @param[in] pos  Bit position, MSB of the first bitmap byte is 0
+///  @return  The bits left aligned in a 32 bit word
+////////////////////////////////////////////////////////////////////////////////
+uint32_t T6963Text::readBits(uint32_t pos, uint8_t n)
+{
+  uint32_t rtn = 0;
+  const uint8_t* p = bitmap + (pos >> 3);
+  uint8_t need = ( (pos & 7) + n + 7) >> 3;
+  for(uint8_t k = 0; k < need; k++)
+  {
+    rtn |= (uint32_t)pgm_read_byte(p + k) << (24 - 8 * k);
+  }
+  rtn <<= (pos & 7);
+  return rtn & ~(0xffffffffUL >> n);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn cachedRows
+///  @brief  Unpacked rows of a glyph, from the cache or unpacked into it
+///  @return  One left aligned word per row, NULL if the glyph is too large
+///           to cache
+////////////////////////////////////////////////////////////////////////////////
+const uint16_t* T6963Text::cachedRows(uint8_t c, const T6963Glyph& g)
+{
+  const uint16_t* rtn = NULL;
+#if T6963_FONT_CACHE > 0
+  if(g.width <= 16 && g.height <= T6963_FONT_CACHE_ROWS)
+  {
+    CacheEntry& e = cache[c % T6963_FONT_CACHE];
+    if(e.code == c)
+    {
+      hits++;
+    }
+    else
+    {
+      uint32_t pos = (uint32_t)g.bitmapOffset * 8;
+      for(uint8_t r = 0; r < g.height; r++)
+      {
+        e.rows[r] = (g.width != 0) ? readBits(pos, g.width) >> 16 : 0;
+        pos += g.width;
+      }
+      e.code = c;
+      misses++;
+    }
+    rtn = e.rows;
+  }
+#endif
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn putBits
+///  @brief  Merge a run of pixels into one row of graphic bytes
+///  @param[in] row    The row's graphic bytes
+///  @param[in] x      Pixel column of the first bit
+///  @param[in] bits   Pixels, left aligned
+///  @param[in] n      Number of pixels (up to FONT_STRIP)
+///  @param[in] color  Non-zero sets pixels, zero clears them
+///  @param[out] lo    First byte touched, 0xff if none
+///  @param[out] hi    Last byte touched
+////////////////////////////////////////////////////////////////////////////////
+void T6963Text::putBits(uint8_t* row, int16_t x, uint32_t bits, int8_t n,
+                        uint8_t color, uint8_t& lo, uint8_t& hi)
+{
+  lo = 0xff;
+  hi = 0;
+  if(x < 0)
+  {
+    bits = (-x < n) ? bits << -x : 0;
+    n += x;
+    x = 0;
+  }
+  if(x + n > w)
+  {
+    n = w - x;
+  }
+  if(n > 0)
+  {
+    uint8_t bw = lcd.getFontWidth();
+    uint8_t col = x / bw;
+    uint8_t sh = x % bw;
+    bits &= ~(0xffffffffUL >> n);
+    lo = col;
+    if(bw == 8 && sh == 0)
+    {
+      // byte aligned: glyph bytes go straight in
+      for(; n > 0; n -= 8, col++)
+      {
+        uint8_t b = bits >> 24;
+        row[col] = color ? (row[col] | b) : (row[col] & ~b);
+        bits <<= 8;
+      }
+    }
+    else
+    {
+      // shift the row once, then peel off one graphic byte at a time
+      uint32_t v = bits >> sh;
+      for(int8_t rem = n + sh; rem > 0; rem -= bw, col++)
+      {
+        uint8_t b = v >> (32 - bw);
+        row[col] = color ? (row[col] | b) : (row[col] & ~b);
+        v <<= bw;
+      }
+    }
+    hi = col - 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn drawGlyph
+///  @brief  Draw one glyph into rows top..top+rows-1 held in buf
+///  @param[in] buf    Graphic bytes of row top, one graphic area per row
+///  @param[in] x      Origin of the glyph
+///  @param[in] y      Baseline
+///  @param[in] mark   Mark the touched bytes dirty in the framebuffer
+////////////////////////////////////////////////////////////////////////////////
+void T6963Text::drawGlyph(uint8_t* buf, int16_t top, uint8_t rows, int16_t x,
+                          int16_t y, uint8_t c, uint8_t color, bool mark)
+{
+  T6963Glyph g;
+  if(readGlyph(c, g) && g.width != 0)
+  {
+    uint8_t stride = lcd.getGraphicArea();
+    const uint16_t* cached = cachedRows(c, g);
+    uint32_t pos = (uint32_t)g.bitmapOffset * 8;
+    int16_t px = x + g.xOffset;
+    for(uint8_t r = 0; r < g.height; r++, pos += g.width)
+    {
+      int16_t py = y + g.yOffset + r;
+      if(py >= top && py < top + rows && py < h)
+      {
+        uint8_t* row = buf + (uint16_t)(py - top) * stride;
+        for(uint8_t c0 = 0; c0 < g.width; c0 += FONT_STRIP)
+        {
+          uint8_t n = g.width - c0;
+          uint32_t bits;
+          uint8_t lo;
+          uint8_t hi;
+          if(n > FONT_STRIP)
+          {
+            n = FONT_STRIP;
+          }
+          if(cached != NULL)
+          {
+            bits = (uint32_t)cached[r] << 16;
+          }
+          else
+          {
+            bits = readBits(pos + c0, n);
+          }
+          putBits(row, px + c0, bits, n, color, lo, hi);
+          if(mark && lo <= hi)
+          {
+            fb->markGraphicDirty(py, lo, hi);
+          }
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn render
+///  @brief  Draw a string glyph by glyph
+///  @return  x of the origin after the last glyph
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963Text::render(uint8_t* buf, int16_t top, uint8_t rows, int16_t x,
+                          int16_t y, const char* str, uint8_t color, bool mark)
+{
+  T6963Glyph g;
+  while(*str != '\0' && x < w)
+  {
+    uint8_t c = *str++;
+    if(readGlyph(c, g))
+    {
+      drawGlyph(buf, top, rows, x, y, c, color, mark);
+      x += g.xAdvance;
+    }
+  }
+  return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn drawText
+///  @brief  Draw text into the framebuffer.  Only the glyph pixels change;
+///          call the framebuffer's flush() to show them.
+///  @param[in] x      Origin of the first glyph
+///  @param[in] y      Baseline
+///  @param[in] str    The text
+///  @param[in] color  Non-zero sets pixels, zero clears them
+///  @return  x after the last glyph, unchanged without a framebuffer
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963Text::drawText(int16_t x, int16_t y, const char* str, uint8_t color)
+{
+  int16_t rtn = x;
+  uint8_t* buf = (fb != NULL) ? fb->graphicRow(0) : NULL;
+  if(buf != NULL && str != NULL)
+  {
+    rtn = render(buf, 0, h, x, y, str, color, true);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn printLine
+///  @brief  Replace a full width band of lineHeight() pixel rows with the
+///          text on a plain background, sent as one auto write.  The
+///          framebuffer, if set, is updated to match.
+///  @param[in] top    First pixel row of the band
+///  @param[in] x      Origin of the first glyph
+///  @param[in] str    The text
+///  @param[in] color  Non-zero: set pixels on clear, zero: the reverse
+///  @return  x after the last glyph, unchanged if the buffer is too small
+////////////////////////////////////////////////////////////////////////////////
+int16_t T6963Text::printLine(int16_t top, int16_t x, const char* str, uint8_t color)
+{
+  int16_t rtn = x;
+  uint8_t area = lcd.getGraphicArea();
+  if(lineBuf != NULL && str != NULL && top >= 0 && top < h)
+  {
+    uint8_t rows = (top + yAdvance > h) ? h - top : yAdvance;
+    uint16_t len = (uint16_t)area * rows;
+    if(len != 0 && len <= lineSize)
+    {
+      memset(lineBuf, color ? 0x00 : 0xff, len);
+      rtn = render(lineBuf, top, rows, x, top + asc, str, color, false);
+      lcd.writeBlock(lcd.getGraphicDrawAddress() + (uint16_t)top * area, lineBuf, len);
+      if(fb != NULL && fb->graphicRow(top) != NULL)
+      {
+        memcpy(fb->graphicRow(top), lineBuf, len);
+      }
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn textWidth
+///  @return  Advance of a string in pixels
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Text::textWidth(const char* str)
+{
+  uint16_t rtn = 0;
+  T6963Glyph g;
+  if(str != NULL)
+  {
+    while(*str != '\0')
+    {
+      if(readGlyph(*str++, g))
+      {
+        rtn += g.xAdvance;
+      }
+    }
+  }
+  return rtn;
+}
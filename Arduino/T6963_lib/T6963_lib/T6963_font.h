@@ -0,0 +1,124 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_font.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Proportional bitmap fonts drawn into the graphic area
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_FONT_H
+#define T6963_FONT_H
+
+#include "T6963.h"
+#include "T6963_shadow.h"
+
+// Glyphs whose unpacked rows are cached, 0 to disable
+#ifndef T6963_FONT_CACHE
+#define T6963_FONT_CACHE                  4
+#endif
+
+// Largest glyph the cache holds (width is at most 16)
+#ifndef T6963_FONT_CACHE_ROWS
+#define T6963_FONT_CACHE_ROWS            16
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963Glyph
+/// @brief  One glyph.  Same layout as Adafruit GFX's GFXglyph, so tables
+///         from its fontconvert tool can be used by renaming the types.
+//////////////////////////////////////////////////////////////////////////////
+
+struct T6963Glyph
+{
+  uint16_t bitmapOffset;   // first byte of the glyph in the bitmap
+  uint8_t width;           // bitmap size in pixels
+  uint8_t height;
+  uint8_t xAdvance;        // distance to the next glyph's origin
+  int8_t xOffset;          // bitmap position from the origin on the
+  int8_t yOffset;          // baseline, negative is up
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963Font
+/// @brief  A font in PROGMEM.  Glyph bitmaps are bit packed, rows MSB first
+///         and not padded.
+//////////////////////////////////////////////////////////////////////////////
+
+struct T6963Font
+{
+  const uint8_t* bitmap;
+  const T6963Glyph* glyph; // one entry per code from first to last
+  uint16_t first;
+  uint16_t last;
+  uint8_t yAdvance;        // line spacing
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Text
+/// @brief Draws proportional text into the graphic area, honouring the
+///        6 or 8 pixel graphic byte width.  Glyph rows are pre-shifted to
+///        the pixel column once and merged a byte at a time; byte aligned
+///        glyphs on 8 pixel bytes skip the shift.
+///
+///        drawText() draws into a T6963Shadow framebuffer and leaves the
+///        flush to the caller.  printLine() renders a whole text line,
+///        background included, into a line buffer and sends it with one
+///        auto write.  A color of 0 draws clear pixels on a set background.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Text
+{
+  public:
+    T6963Text(T6963& lcd, uint8_t width = 240, uint8_t height = 64);
+    void setFont(const T6963Font* font);
+    void setFramebuffer(T6963Shadow* fb) { this->fb = fb; }
+    void setLineBuffer(uint8_t* buf, uint16_t size);
+    uint16_t lineBufferSize();
+
+    int16_t drawText(int16_t x, int16_t y, const char* str, uint8_t color = 1);
+    int16_t printLine(int16_t top, int16_t x, const char* str, uint8_t color = 1);
+    uint16_t textWidth(const char* str);
+    uint8_t lineHeight() { return yAdvance; }
+    uint8_t ascent() { return asc; }
+
+    uint32_t getCacheHits() { return hits; }
+    uint32_t getCacheMisses() { return misses; }
+
+  private:
+    bool readGlyph(uint8_t c, T6963Glyph& g);
+    uint32_t readBits(uint32_t pos, uint8_t n);
+    const uint16_t* cachedRows(uint8_t c, const T6963Glyph& g);
+    int16_t render(uint8_t* buf, int16_t top, uint8_t rows, int16_t x,
+                   int16_t y, const char* str, uint8_t color, bool mark);
+    void drawGlyph(uint8_t* buf, int16_t top, uint8_t rows, int16_t x,
+                   int16_t y, uint8_t c, uint8_t color, bool mark);
+    void putBits(uint8_t* row, int16_t x, uint32_t bits, int8_t n,
+                 uint8_t color, uint8_t& lo, uint8_t& hi);
+
+    T6963& lcd;
+    T6963Shadow* fb;
+    uint8_t w;
+    uint8_t h;
+    uint8_t* lineBuf;
+    uint16_t lineSize;
+
+    // font header copied out of PROGMEM
+    const uint8_t* bitmap;
+    const T6963Glyph* glyphs;
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+    uint8_t asc;             // tallest rise above the baseline
+
+#if T6963_FONT_CACHE > 0
+    struct CacheEntry
+    {
+      uint16_t code;         // 0xffff if empty
+      uint16_t rows[T6963_FONT_CACHE_ROWS];  // left aligned
+    };
+    CacheEntry cache[T6963_FONT_CACHE];
+#endif
+    uint32_t hits;
+    uint32_t misses;
+};
+
+#endif
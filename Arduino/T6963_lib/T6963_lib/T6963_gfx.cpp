@@ -0,0 +1,569 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_gfx.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Graphics primitives on the T6963 graphic area
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_gfx.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Graphics
+///  @brief  Constructor.  Draws on the controller until a framebuffer is set.
+///  @param[in] lcd     The display; its graphic home, area and font width
+///                     give the byte layout
+///  @param[in] width   Panel width in pixels
+///  @param[in] height  Panel height in pixels
+////////////////////////////////////////////////////////////////////////////////
+T6963Graphics::T6963Graphics(T6963& lcd, uint8_t width, uint8_t height)
+  : lcd(lcd), fb(NULL), w(width), h(height)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setFramebuffer
+///  @brief  Draw into a shadow instead of the controller.  Call fb->flush()
+///          to show the result.
+///  @param[in] fb  Shadow with a graphic buffer, NULL to draw directly
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::setFramebuffer(T6963Shadow* fb)
+{
+  this->fb = fb;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn address
+///  @return  VRAM address of a graphic byte
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Graphics::address(uint8_t col, uint8_t y)
+{
+  return lcd.getGraphicDrawAddress() + (uint16_t)y * lcd.getGraphicArea() + col;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pixelMask
+///  @brief  Bits of a graphic byte covering pixels px0..px1 (0 = leftmost)
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Graphics::pixelMask(uint8_t px0, uint8_t px1)
+{
+  uint8_t fw = lcd.getFontWidth();
+  uint8_t rtn = 0;
+  for(uint8_t p = px0; p <= px1; p++)
+  {
+    rtn |= 1 << (fw - 1 - p);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn putMasked
+///  @brief  Change only the masked bits of one graphic byte.  On the
+///          controller this is one address set plus a bit set/reset per
+///          pixel, so no read back is needed.
+///  @param[in] col   Byte column
+///  @param[in] y     Pixel row
+///  @param[in] mask  Bits to change
+///  @param[in] bits  New values for the masked bits
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::putMasked(uint8_t col, uint8_t y, uint8_t mask, uint8_t bits)
+{
+  if(fb != NULL)
+  {
+    uint8_t* row = fb->graphicRow(y);
+    if(row != NULL)
+    {
+      uint8_t d = (row[col] & ~mask) | (bits & mask);
+      if(d != row[col])
+      {
+        row[col] = d;
+        fb->markGraphicDirty(y, col, col);
+      }
+    }
+  }
+  else
+  {
+    lcd.setAddress(address(col, y));
+    for(uint8_t b = 0; b < 8; b++)
+    {
+      if(mask & (1 << b))
+      {
+        if(bits & (1 << b))
+        {
+          lcd.setBit(b);
+        }
+        else
+        {
+          lcd.resetBit(b);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn putRun
+///  @brief  Replace n whole graphic bytes of one row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::putRun(uint8_t col, uint8_t y, const uint8_t* d, uint8_t n)
+{
+  if(fb != NULL)
+  {
+    uint8_t* row = fb->graphicRow(y);
+    if(row != NULL && n > 0)
+    {
+      // only the bytes that change are flagged, so redrawing an unchanged
+      // area costs no bus traffic
+      uint8_t first = n;
+      uint8_t last = 0;
+      for(uint8_t i = 0; i < n; i++)
+      {
+        if(row[col + i] != d[i])
+        {
+          row[col + i] = d[i];
+          first = (first == n) ? i : first;
+          last = i;
+        }
+      }
+      if(first < n)
+      {
+        fb->markGraphicDirty(y, col + first, col + last);
+      }
+    }
+  }
+  else
+  {
+    lcd.writeBlock(address(col, y), d, n);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn span
+///  @brief  Draw pixels x0..x1 of row y, already clipped.  Whole bytes go
+///          out as one burst, partial edge bytes are masked.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::span(uint8_t y, uint8_t x0, uint8_t x1, uint8_t color)
+{
+  uint8_t fw = lcd.getFontWidth();
+  uint8_t full = (1 << fw) - 1;
+  uint8_t c0 = x0 / fw;
+  uint8_t c1 = x1 / fw;
+  uint8_t value = color ? full : 0;
+
+  if(c0 == c1)
+  {
+    putMasked(c0, y, pixelMask(x0 % fw, x1 % fw), value);
+  }
+  else
+  {
+    if(x0 % fw != 0)
+    {
+      putMasked(c0, y, pixelMask(x0 % fw, fw - 1), value);
+      c0++;
+    }
+    if(x1 % fw != fw - 1)
+    {
+      putMasked(c1, y, pixelMask(0, x1 % fw), value);
+      c1--;
+    }
+    if(c0 <= c1)
+    {
+      uint8_t run[T6963_GFX_MAX_COLS];
+      memset(run, value, sizeof(run));
+      for(uint16_t c = c0; c <= c1; c += T6963_GFX_MAX_COLS)
+      {
+        uint16_t n = c1 - c + 1;
+        if(n > T6963_GFX_MAX_COLS)
+        {
+          n = T6963_GFX_MAX_COLS;
+        }
+        putRun(c, y, run, n);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pixel
+///  @brief  Set or clear one pixel
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::pixel(int16_t x, int16_t y, uint8_t color)
+{
+  if(x >= 0 && x < w && y >= 0 && y < h)
+  {
+    span(y, x, x, color);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn hline
+///  @brief  Horizontal line of w pixels starting at x, y
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::hline(int16_t x, int16_t y, int16_t w, uint8_t color)
+{
+  int16_t x1 = x + w - 1;
+  if(x < 0)
+  {
+    x = 0;
+  }
+  if(x1 >= this->w)
+  {
+    x1 = this->w - 1;
+  }
+  if(w > 0 && y >= 0 && y < h && x <= x1)
+  {
+    span(y, x, x1, color);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn vline
+///  @brief  Vertical line of h pixels starting at x, y
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::vline(int16_t x, int16_t y, int16_t h, uint8_t color)
+{
+  int16_t y1 = y + h - 1;
+  if(y < 0)
+  {
+    y = 0;
+  }
+  if(y1 >= this->h)
+  {
+    y1 = this->h - 1;
+  }
+  if(h > 0 && x >= 0 && x < w)
+  {
+    for(int16_t r = y; r <= y1; r++)
+    {
+      span(r, x, x, color);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn line
+///  @brief  Bresenham line.  Shallow lines are drawn as horizontal runs so
+///          each run costs one span instead of one command per pixel.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
+{
+  if(y0 == y1)
+  {
+    hline(x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1, color);
+  }
+  else if(x0 == x1)
+  {
+    vline(x0, y0 < y1 ? y0 : y1, abs(y1 - y0) + 1, color);
+  }
+  else
+  {
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    int16_t t;
+    if(steep)
+    {
+      t = x0; x0 = y0; y0 = t;
+      t = x1; x1 = y1; y1 = t;
+    }
+    if(x0 > x1)
+    {
+      t = x0; x0 = x1; x1 = t;
+      t = y0; y0 = y1; y1 = t;
+    }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = (y0 < y1) ? 1 : -1;
+    int16_t runStart = x0;
+
+    for(int16_t x = x0; x <= x1; x++)
+    {
+      err -= dy;
+      if(err < 0 || x == x1)
+      {
+        // run of pixels on one major-axis line ends here
+        if(steep)
+        {
+          vline(y0, runStart, x - runStart + 1, color);
+        }
+        else
+        {
+          hline(runStart, y0, x - runStart + 1, color);
+        }
+        runStart = x + 1;
+      }
+      if(err < 0)
+      {
+        y0 += ystep;
+        err += dx;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn rect
+///  @brief  Rectangle outline
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color)
+{
+  if(w > 0 && h > 0)
+  {
+    hline(x, y, w, color);
+    if(h > 1)
+    {
+      hline(x, y + h - 1, w, color);
+    }
+    if(h > 2)
+    {
+      vline(x, y + 1, h - 2, color);
+      if(w > 1)
+      {
+        vline(x + w - 1, y + 1, h - 2, color);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillRect
+///  @brief  Filled rectangle, one span per row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color)
+{
+  for(int16_t r = 0; r < h; r++)
+  {
+    hline(x, y + r, w, color);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn circle
+///  @brief  Midpoint circle outline of radius r centred on x0, y0
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::circle(int16_t x0, int16_t y0, int16_t r, uint8_t color)
+{
+  int16_t x = r;
+  int16_t y = 0;
+  int16_t err = 1 - r;
+
+  while(x >= y)
+  {
+    pixel(x0 + x, y0 + y, color);
+    pixel(x0 - x, y0 + y, color);
+    pixel(x0 + x, y0 - y, color);
+    pixel(x0 - x, y0 - y, color);
+    pixel(x0 + y, y0 + x, color);
+    pixel(x0 - y, y0 + x, color);
+    pixel(x0 + y, y0 - x, color);
+    pixel(x0 - y, y0 - x, color);
+    y++;
+    if(err < 0)
+    {
+      err += 2 * y + 1;
+    }
+    else
+    {
+      x--;
+      err += 2 * (y - x) + 1;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn bitmap
+///  @brief  Opaque blit of a 1 bit per pixel bitmap held in RAM.  Rows are
+///          (w + 7) / 8 bytes, MSB leftmost.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::bitmap(int16_t x, int16_t y, const uint8_t* bits, int16_t w, int16_t h)
+{
+  blit(x, y, bits, w, h, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn bitmap_P
+///  @brief  As bitmap, with the bitmap held in PROGMEM
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::bitmap_P(int16_t x, int16_t y, const uint8_t* bits, int16_t w, int16_t h)
+{
+  blit(x, y, bits, w, h, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn blit
+///  @brief  Repack bitmap rows into graphic bytes.  Interior bytes of each
+///          row go out in runs of up to T6963_GFX_MAX_COLS, the two edge
+///          bytes are masked.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::blit(int16_t x, int16_t y, const uint8_t* bits, int16_t bw, int16_t bh, bool pgm)
+{
+  uint8_t fw = lcd.getFontWidth();
+  uint8_t full = (1 << fw) - 1;
+  int16_t stride = (bw + 7) / 8;
+  int16_t xs = (x < 0) ? 0 : x;
+  int16_t xe = (x + bw > w) ? w - 1 : x + bw - 1;
+
+  if(bits != NULL && xs <= xe)
+  {
+    uint8_t c0 = xs / fw;
+    uint8_t c1 = xe / fw;
+    for(int16_t r = 0; r < bh; r++)
+    {
+      int16_t dy = y + r;
+      if(dy < 0 || dy >= h)
+      {
+        continue;
+      }
+      const uint8_t* src = bits + r * stride;
+      for(uint16_t cs = c0; cs <= c1; cs += T6963_GFX_MAX_COLS)
+      {
+        uint8_t vals[T6963_GFX_MAX_COLS];
+        uint8_t masks[T6963_GFX_MAX_COLS];
+        uint8_t n = (c1 - cs + 1 > T6963_GFX_MAX_COLS) ? T6963_GFX_MAX_COLS : c1 - cs + 1;
+        for(uint8_t i = 0; i < n; i++)
+        {
+          vals[i] = 0;
+          masks[i] = 0;
+          for(uint8_t p = 0; p < fw; p++)
+          {
+            int16_t px = (int16_t)(cs + i) * fw + p;
+            if(px >= xs && px <= xe)
+            {
+              int16_t sx = px - x;
+              uint8_t sb = pgm ? pgm_read_byte(&src[sx >> 3]) : src[sx >> 3];
+              uint8_t bit = 1 << (fw - 1 - p);
+              masks[i] |= bit;
+              if(sb & (0x80 >> (sx & 7)))
+              {
+                vals[i] |= bit;
+              }
+            }
+          }
+        }
+
+        uint8_t first = 0;
+        uint8_t last = n - 1;
+        if(masks[first] != full)
+        {
+          putMasked(cs, dy, masks[first], vals[first]);
+          first++;
+        }
+        if(last >= first && masks[last] != full)
+        {
+          putMasked(cs + last, dy, masks[last], vals[last]);
+          last--;
+        }
+        if(first <= last && last < n)
+        {
+          putRun(cs + first, dy, &vals[first], last - first + 1);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn combine
+///  @brief  Apply a read-modify-write operation to n bytes of one row,
+///          starting at byte column col.  Columns c0 and c1 are the edges
+///          of the rectangle and only their m0 / m1 bits are touched.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::combine(uint8_t* d, uint8_t n, uint8_t col, uint8_t c0, uint8_t c1,
+                            uint8_t m0, uint8_t m1, uint8_t rop, uint8_t pattern)
+{
+  uint8_t full = (1 << lcd.getFontWidth()) - 1;
+  for(uint8_t i = 0; i < n; i++)
+  {
+    uint8_t c = col + i;
+    uint8_t mask = full;
+    if(c == c0)
+    {
+      mask &= m0;
+    }
+    if(c == c1)
+    {
+      mask &= m1;
+    }
+    if(rop == T6963_ROP_XOR)
+    {
+      d[i] ^= pattern & mask;
+    }
+    else if(rop == T6963_ROP_AND)
+    {
+      d[i] &= pattern | ~mask;
+    }
+    else
+    {
+      d[i] |= pattern & mask;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn rmwRect
+///  @brief  Combine a rectangle with what is already on the display.  On
+///          the controller each row is fetched with one auto read and
+///          written back with one auto write, so every byte is read once
+///          and written once and no shadow is needed.  With a framebuffer
+///          set the shadow is changed instead.
+///  @param[in] x, y     Top left pixel
+///  @param[in] w, h     Size in pixels, clipped to the panel
+///  @param[in] rop      T6963_ROP_OR, T6963_ROP_XOR or T6963_ROP_AND
+///  @param[in] pattern  Graphic byte combined with each byte, e.g. 0xff to
+///                      set or invert every pixel, 0x00 with AND to clear
+////////////////////////////////////////////////////////////////////////////////
+void T6963Graphics::rmwRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t rop,
+                            uint8_t pattern)
+{
+  int16_t x1 = x + w - 1;
+  int16_t y1 = y + h - 1;
+  if(x < 0)
+  {
+    x = 0;
+  }
+  if(y < 0)
+  {
+    y = 0;
+  }
+  if(x1 >= this->w)
+  {
+    x1 = this->w - 1;
+  }
+  if(y1 >= this->h)
+  {
+    y1 = this->h - 1;
+  }
+  if(w > 0 && h > 0 && x <= x1 && y <= y1)
+  {
+    uint8_t fw = lcd.getFontWidth();
+    uint8_t c0 = x / fw;
+    uint8_t c1 = x1 / fw;
+    uint8_t m0 = pixelMask(x % fw, fw - 1);
+    uint8_t m1 = pixelMask(0, x1 % fw);
+    for(int16_t r = y; r <= y1; r++)
+    {
+      if(fb != NULL)
+      {
+        uint8_t* row = fb->graphicRow(r);
+        if(row != NULL)
+        {
+          combine(&row[c0], c1 - c0 + 1, c0, c0, c1, m0, m1, rop, pattern);
+          fb->markGraphicDirty(r, c0, c1);
+        }
+      }
+      else
+      {
+        uint8_t line[T6963_GFX_MAX_COLS];
+        for(uint16_t c = c0; c <= c1; c += T6963_GFX_MAX_COLS)
+        {
+          uint16_t n = c1 - c + 1;
+          if(n > T6963_GFX_MAX_COLS)
+          {
+            n = T6963_GFX_MAX_COLS;
+          }
+          lcd.readBlock(address(c, r), line, n);
+          combine(line, n, c, c0, c1, m0, m1, rop, pattern);
+          lcd.writeBlock(address(c, r), line, n);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_gfx.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Graphics primitives on the T6963 graphic area
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_GFX_H
+#define T6963_GFX_H
+
+#include "T6963.h"
+#include "T6963_shadow.h"
+
+// Widest span, in graphic bytes, sent as one auto write burst
+#ifndef T6963_GFX_MAX_COLS
+#define T6963_GFX_MAX_COLS               64
+#endif
+
+// Read-modify-write operations for rmwRect
+#define T6963_ROP_OR                      0     // set pattern bits
+#define T6963_ROP_XOR                     1     // invert pattern bits
+#define T6963_ROP_AND                     2     // keep pattern bits, clear others
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Graphics
+/// @brief Pixels, lines, rectangles, circles and bitmaps.  Draws straight
+///        to the controller, or into a T6963Shadow framebuffer if one is
+///        set.  Horizontal spans are written as whole bytes in one burst;
+///        only the partial edge bytes are masked.  A color of 0 clears
+///        pixels, anything else sets them.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Graphics
+{
+  public:
+    T6963Graphics(T6963& lcd, uint8_t width = 240, uint8_t height = 64);
+    void setFramebuffer(T6963Shadow* fb);
+
+    void pixel(int16_t x, int16_t y, uint8_t color);
+    void hline(int16_t x, int16_t y, int16_t w, uint8_t color);
+    void vline(int16_t x, int16_t y, int16_t h, uint8_t color);
+    void line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color);
+    void rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+    void circle(int16_t x0, int16_t y0, int16_t r, uint8_t color);
+    void bitmap(int16_t x, int16_t y, const uint8_t* bits, int16_t w, int16_t h);
+    void bitmap_P(int16_t x, int16_t y, const uint8_t* bits, int16_t w, int16_t h);
+    void rmwRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t rop,
+                 uint8_t pattern = 0xff);
+
+    uint8_t width() { return w; }
+    uint8_t height() { return h; }
+
+  private:
+    void span(uint8_t y, uint8_t x0, uint8_t x1, uint8_t color);
+    void putMasked(uint8_t col, uint8_t y, uint8_t mask, uint8_t bits);
+    void putRun(uint8_t col, uint8_t y, const uint8_t* d, uint8_t n);
+    void combine(uint8_t* d, uint8_t n, uint8_t col, uint8_t c0, uint8_t c1,
+                 uint8_t m0, uint8_t m1, uint8_t rop, uint8_t pattern);
+    void blit(int16_t x, int16_t y, const uint8_t* bits, int16_t bw, int16_t bh, bool pgm);
+    uint16_t address(uint8_t col, uint8_t y);
+    uint8_t pixelMask(uint8_t px0, uint8_t px1);
+
+    T6963& lcd;
+    T6963Shadow* fb;
+    uint8_t w;
+    uint8_t h;
+};
+
+#endif
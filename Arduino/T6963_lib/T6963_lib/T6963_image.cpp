@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_image.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Streaming decoder for run length coded screen images
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_image.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Image
+///  @brief  Constructor
+///  @param[in] lcd  The display to draw on
+////////////////////////////////////////////////////////////////////////////////
+T6963Image::T6963Image(T6963& lcd)
+  : lcd(lcd), src(NULL), pgm(false), flags(0), cols(0), rows(0), length(0),
+    base(0), stride(0), out(0), open(false)
+{
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the byte and burst counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963Image::resetCounters()
+{
+  bytesWritten = 0;
+  bursts = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Decode an image held in RAM onto the graphic drawing page
+///  @param[in] image  The image, header first
+///  @param[in] col    Left graphic column (byte) of the image
+///  @param[in] y      Top pixel row of the image
+///  @return  True if the image fits and decoded cleanly
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::draw(const uint8_t* image, uint8_t col, uint8_t y)
+{
+  return place(image, false, col, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw_P
+///  @brief  As draw, with the image held in PROGMEM
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::draw_P(const uint8_t* image, uint8_t col, uint8_t y)
+{
+  return place(image, true, col, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn drawAt
+///  @brief  Decode an image held in RAM to any region of display RAM, e.g.
+///          the text or attribute area or a CG RAM page
+///  @param[in] image   The image, header first
+///  @param[in] addr    RAM address of the top left byte
+///  @param[in] stride  Bytes from one RAM row to the next
+///  @return  True if the image decoded cleanly
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::drawAt(const uint8_t* image, uint16_t addr, uint8_t stride)
+{
+  return decode(image, false, addr, stride);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn drawAt_P
+///  @brief  As drawAt, with the image held in PROGMEM
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::drawAt_P(const uint8_t* image, uint16_t addr, uint8_t stride)
+{
+  return decode(image, true, addr, stride);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn place
+///  @brief  Check an image fits the graphic area at col, y and decode it
+///  @return  True if the image fits and decoded cleanly
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::place(const uint8_t* image, bool pgm, uint8_t col, uint8_t y)
+{
+  bool rtn = false;
+  uint8_t area = lcd.getGraphicArea();
+  uint8_t height = lcd.getPanelHeight();
+  if(header(image, pgm) && col + cols <= area && (height == 0 || y + rows <= height))
+  {
+    rtn = decode(image, pgm, lcd.getGraphicDrawAddress() + (uint16_t)y * area + col, area);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn header
+///  @brief  Read an image header and leave src at the payload
+///  @return  True if the header describes a non-empty image
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::header(const uint8_t* image, bool pgm)
+{
+  bool rtn = false;
+  if(image != NULL)
+  {
+    src = image;
+    this->pgm = pgm;
+    flags = fetch();
+    cols = fetch();
+    rows = fetch();
+    length = fetch();
+    length |= (uint16_t)fetch() << 8;
+    rtn = (cols != 0 && rows != 0);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fetch
+///  @return  The next byte of the image
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Image::fetch()
+{
+  uint8_t rtn = pgm ? pgm_read_byte(src) : *src;
+  src++;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn put
+///  @brief  Write the next image byte, starting a burst at its RAM address
+///          if none is open and ending it at the end of a row when the
+///          image does not span the whole area
+////////////////////////////////////////////////////////////////////////////////
+void T6963Image::put(uint8_t d)
+{
+  if(!open)
+  {
+    lcd.setAddress(base + (out / cols) * stride + out % cols);
+    lcd.setAutoWrite();
+    open = true;
+    bursts++;
+  }
+  lcd.writeDataByte(d);
+  bytesWritten++;
+  out++;
+  if(cols != stride && out % cols == 0)
+  {
+    endBurst();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn endBurst
+///  @brief  Leave auto write if a burst is open
+////////////////////////////////////////////////////////////////////////////////
+void T6963Image::endBurst()
+{
+  if(open)
+  {
+    lcd.setAutoReset();
+    open = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn decode
+///  @brief  Decode an image a code at a time.  Runs are written from the
+///          one stored byte, literals straight from the image, and skips
+///          only end the burst.  A code that runs past the payload or the
+///          image is not written and fails the image, so nothing outside
+///          the image rectangle is ever touched.
+///  @param[in] image   The image, header first
+///  @param[in] pgm     True if the image is in PROGMEM
+///  @param[in] addr    RAM address of the top left byte
+///  @param[in] stride  Bytes from one RAM row to the next
+///  @return  True if the payload filled the image exactly
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Image::decode(const uint8_t* image, bool pgm, uint16_t addr, uint8_t stride)
+{
+  bool rtn = header(image, pgm) && cols <= stride;
+  if(rtn)
+  {
+    const uint8_t* end = src + length;
+    uint16_t total = (uint16_t)cols * rows;
+    base = addr;
+    this->stride = stride;
+    out = 0;
+    while(src < end && out < total)
+    {
+      uint8_t c = fetch();
+      if(c == T6963_IMAGE_SKIP)
+      {
+        uint16_t k = (src < end) ? fetch() + 1 : total + 1;
+        endBurst();
+        // a skip past the end leaves out beyond total, marking the image bad
+        out = (k <= total - out) ? out + k : total + 1;
+      }
+      else if(c < T6963_IMAGE_SKIP)
+      {
+        if(c + 1 > end - src || c + 1 > total - out)
+        {
+          out = total + 1;  // literal cut short or past the end
+        }
+        for(uint8_t n = c + 1; n > 0 && out < total; n--)
+        {
+          put(fetch());
+        }
+      }
+      else if(src == end || 257 - c > total - out)
+      {
+        out = total + 1;    // repeat without its byte or past the end
+      }
+      else
+      {
+        uint8_t d = fetch();
+        for(uint16_t n = 257 - c; n > 0; n--)
+        {
+          put(d);
+        }
+      }
+    }
+    endBurst();
+    rtn = (out == total && src == end);
+  }
+  return rtn;
+}
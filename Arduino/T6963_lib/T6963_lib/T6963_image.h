@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_image.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Streaming decoder for run length coded screen images
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_IMAGE_H
+#define T6963_IMAGE_H
+
+#include "T6963.h"
+
+// Image header: flags, bytes per row, rows, payload length (low, high)
+#define T6963_IMAGE_HEADER                5
+
+// Header flags
+#define T6963_IMAGE_DELTA              0x01   // only valid over the image before it
+
+// Payload codes (PackBits with a skip code)
+//   0x00-0x7f  n + 1 literal bytes follow
+//   0x80 k     leave the next k + 1 bytes of RAM as they are
+//   0x81-0xff  the next byte repeats 257 - n times
+#define T6963_IMAGE_SKIP               0x80
+
+// Bus bytes outside the data in each burst: address (2 data, 1 command),
+// auto write and auto reset
+#define T6963_IMAGE_BURST_COST            5
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Image
+/// @brief Draws images made by tools/t6963_image straight from flash.  The
+///        payload is decoded a code at a time into auto write bursts, so
+///        no frame buffer is needed; a burst is only broken by a skip or,
+///        when the image is narrower than the area, at the end of a row.
+///
+///        A delta image is coded against the image shown before it: bytes
+///        that did not change (zero in the XOR of the two) become skips
+///        and never cross the bus.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Image
+{
+  public:
+    T6963Image(T6963& lcd);
+
+    bool draw(const uint8_t* image, uint8_t col = 0, uint8_t y = 0);
+    bool draw_P(const uint8_t* image, uint8_t col = 0, uint8_t y = 0);
+    bool drawAt(const uint8_t* image, uint16_t addr, uint8_t stride);
+    bool drawAt_P(const uint8_t* image, uint16_t addr, uint8_t stride);
+
+    uint8_t getFlags() { return flags; }
+    uint8_t getColumns() { return cols; }
+    uint8_t getRows() { return rows; }
+
+    void resetCounters();
+    uint32_t getBytesWritten() { return bytesWritten; }
+    uint32_t getBursts() { return bursts; }
+    uint32_t getBusBytes() { return bytesWritten + bursts * T6963_IMAGE_BURST_COST; }
+
+  private:
+    bool header(const uint8_t* image, bool pgm);
+    bool place(const uint8_t* image, bool pgm, uint8_t col, uint8_t y);
+    bool decode(const uint8_t* image, bool pgm, uint16_t addr, uint8_t stride);
+    uint8_t fetch();
+    void put(uint8_t d);
+    void endBurst();
+
+    T6963& lcd;
+    const uint8_t* src;   // next payload byte
+    bool pgm;             // src is in PROGMEM
+    uint8_t flags;
+    uint8_t cols;         // bytes per row
+    uint8_t rows;
+    uint16_t length;      // payload bytes
+    uint16_t base;        // RAM address of the top left byte
+    uint8_t stride;       // bytes from one RAM row to the next
+    uint16_t out;         // bytes of the image decoded so far
+    bool open;            // an auto write burst is in progress
+    uint32_t bytesWritten;
+    uint32_t bursts;
+};
+
+#endif
@@ -6,7 +6,10 @@
 
 #include "T6963.h"
 
-T6963 myDisplay(1,2,3,4,5,6,7,8,a5,a4,a3,a2);
+T6963 myDisplay(T6963_D0, T6963_D1, T6963_D2, T6963_D3,
+                T6963_D4, T6963_D5, T6963_D6, T6963_D7,
+                T6963_WR, T6963_RD, T6963_CE, T6963_CD,
+                T6963_RES, T6963_FONT);
 
 ////////////////////////////////////////////////////////////////////////////////
 ///  @fn ports_init
@@ -18,64 +21,61 @@ void setup()
 {
   // put your setup code here, to run once:
   delay(100);
-  ports_init();
-  T6963_setAddress(0);
-  T6963_setCursor(0,0);
-  T6963_setTextHomeAddress(0);
-  T6963_setGraphicHomeAddress(2000);
-  T6963_setDisplayMode(1,1,1,1);  // text, graphics, cursor, blink
- // T6963_setAddress(0);
-  T6963_setTextArea(40);
-  T6963_setGraphicArea(40);
-  T6963_setOrMode(0);
+  myDisplay.ports_init();
+  myDisplay.setAddress(0);
+  myDisplay.setCursor(0,0);
+  myDisplay.setTextHomeAddress(0);
+  myDisplay.setGraphicHomeAddress(2000);
+  myDisplay.setDisplayMode(1,1,1,1);  // text, graphics, cursor, blink
+ // myDisplay.setAddress(0);
+  myDisplay.setTextArea(40);
+  myDisplay.setGraphicArea(40);
+  myDisplay.setOrMode(0);
+  myDisplay.setPanelSize(240, 64);
   delay(100);
-  for(int i = 0; i < 800; i++)
-  {
-    T6963_dataWriteIncrement(0);
-  }
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 2000; i < 4000; i++)
+
+  // Clear all 8K of RAM a byte at a time, then with one fill burst
+  Serial.begin(115200);
+  unsigned long start = micros();
+  myDisplay.setAddress(0);
+  for(uint16_t i = 0; i < 8192; i++)
   {
-    T6963_writeDataByte(0);
+    myDisplay.dataWriteIncrement(0);
   }
-  T6963_setAutoReset();
+  unsigned long loopTime = micros() - start;
+  start = micros();
+  myDisplay.fill(0, 0, 8192);
+  unsigned long fillTime = micros() - start;
+  Serial.print("8K clear, dataWriteIncrement loop (us): ");
+  Serial.println(loopTime);
+  Serial.print("8K clear, fill (us): ");
+  Serial.println(fillTime);
+
+  myDisplay.clear();
   
-  T6963_setAddress(0);
+  myDisplay.setAddress(0);
   for(uint8_t i = 0; i < 128; i++)
   {
-    T6963_dataWriteIncrement(i);
+    myDisplay.dataWriteIncrement(i);
   }
   for(uint8_t i = 0; i < 128; i++)
   {
-    T6963_dataWriteIncrement(128-i);
+    myDisplay.dataWriteIncrement(128-i);
   }
   delay(500);
 
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
-  for(int i = 0; i < 320; i++)
-  {
-    T6963_writeDataByte(0);  // space, clear screen
-  }
-  T6963_setAutoReset();
+  myDisplay.clearText();
   delay(500);
   
-  T6963_setAddress(0);
-  T6963_setAutoWrite();
+  myDisplay.setAddress(0);
+  myDisplay.setAutoWrite();
   for(int i = 0; i < 320; i++)
   {
-    T6963_writeDataByte( (uint8_t) (i & 0x7f) );
+    myDisplay.writeDataByte( (uint8_t) (i & 0x7f) );
   }
-  T6963_setAutoReset();
+  myDisplay.setAutoReset();
   delay(2000);
-  T6963_setAddress(2000);
-  T6963_setAutoWrite();
-  for(int i = 2000; i < 4000; i++)
-  {
-    T6963_writeDataByte( 0x55);
-  }
-  T6963_setAutoReset();
+  myDisplay.fill(2000, 0x55, 40 * 64);
   
  
 
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_page.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Page flipping between text and graphic pages in display RAM
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_page.h"
+
+// Bytes moved per block transfer by copyFront
+#define PAGE_CHUNK                       64
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Pages
+///  @brief  Constructor
+///  @param[in] lcd         The display
+///  @param[in] count       Pages per plane (2 to T6963_MAX_PAGES)
+///  @param[in] height      Panel height in pixels
+///  @param[in] fontHeight  Pixel rows per text row
+////////////////////////////////////////////////////////////////////////////////
+T6963Pages::T6963Pages(T6963& lcd, uint8_t count, uint8_t height, uint8_t fontHeight)
+  : lcd(lcd), count(count), height(height), fontHeight(fontHeight), planes(0),
+    front(0), back(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn textPageSize
+///  @return  Bytes in one text page
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Pages::textPageSize()
+{
+  return (uint16_t)lcd.getTextArea() * (height / fontHeight);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn graphicPageSize
+///  @return  Bytes in one graphic page
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Pages::graphicPageSize()
+{
+  return (uint16_t)lcd.getGraphicArea() * height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Allocate the pages, show page 0 and draw on page 1.  Call after
+///          setTextArea / setGraphicArea.
+///  @param[in] vram    Allocator for the pages
+///  @param[in] planes  T6963_PAGE_TEXT and/or T6963_PAGE_GRAPHIC
+///  @return  True if every page fits, false otherwise
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Pages::begin(T6963Vram& vram, uint8_t planes)
+{
+  bool rtn = (count >= 2 && count <= T6963_MAX_PAGES && fontHeight != 0);
+  for(uint8_t i = 0; i < count && rtn; i++)
+  {
+    if(planes & T6963_PAGE_TEXT)
+    {
+      rtn = vram.alloc(textPageSize(), textPages[i]);
+    }
+    if(rtn && (planes & T6963_PAGE_GRAPHIC))
+    {
+      rtn = vram.alloc(graphicPageSize(), graphicPages[i]);
+    }
+  }
+  if(rtn)
+  {
+    this->planes = planes;
+    front = 0;
+    back = 1;
+    show();
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Flip between pages a T6963Panel has laid out.  Every plane with
+///          at least count pages is flipped; attribute pages follow their
+///          text pages.
+///  @param[in] panel  A panel after a successful begin()
+///  @return  True if at least one plane has enough pages, false otherwise
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Pages::begin(T6963Panel& panel)
+{
+  bool rtn = (count >= 2 && count <= T6963_MAX_PAGES);
+  uint8_t p = 0;
+  if(rtn)
+  {
+    if(panel.textPageCount() >= count)
+    {
+      p |= T6963_PAGE_TEXT;
+    }
+    if(panel.graphicPageCount() >= count)
+    {
+      p |= T6963_PAGE_GRAPHIC;
+    }
+    for(uint8_t i = 0; i < count; i++)
+    {
+      textPages[i] = panel.textHome(i);
+      graphicPages[i] = panel.graphicHome(i);
+    }
+    rtn = (p != 0);
+  }
+  if(rtn)
+  {
+    planes = p;
+    front = 0;
+    back = 1;
+    show();
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn show
+///  @brief  Point the home addresses at the front page and drawing at the
+///          back page
+////////////////////////////////////////////////////////////////////////////////
+void T6963Pages::show()
+{
+  if(planes & T6963_PAGE_TEXT)
+  {
+    lcd.setTextHomeAddress(textPages[front]);
+  }
+  if(planes & T6963_PAGE_GRAPHIC)
+  {
+    lcd.setGraphicHomeAddress(graphicPages[front]);
+  }
+  lcd.setDrawPage( (planes & T6963_PAGE_TEXT) ? textPages[back] : lcd.getTextHomeAddress(),
+                   (planes & T6963_PAGE_GRAPHIC) ? graphicPages[back] : lcd.getGraphicHomeAddress());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn present
+///  @brief  Show the page just drawn and start drawing on the next one
+////////////////////////////////////////////////////////////////////////////////
+void T6963Pages::present()
+{
+  if(planes != 0)
+  {
+    front = back;
+    back = (back + 1) % count;
+    show();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn copy
+///  @brief  Copy display RAM through a small buffer
+////////////////////////////////////////////////////////////////////////////////
+void T6963Pages::copy(uint16_t from, uint16_t to, uint16_t len)
+{
+  uint8_t buf[PAGE_CHUNK];
+  for(uint16_t done = 0; done < len; done += sizeof(buf))
+  {
+    uint16_t n = len - done;
+    if(n > sizeof(buf))
+    {
+      n = sizeof(buf);
+    }
+    lcd.readBlock(from + done, buf, n);
+    lcd.writeBlock(to + done, buf, n);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn copyFront
+///  @brief  Copy the page on screen to the back page, for drawing only what
+///          changed since the last frame
+////////////////////////////////////////////////////////////////////////////////
+void T6963Pages::copyFront()
+{
+  if(planes & T6963_PAGE_TEXT)
+  {
+    copy(textPages[front], textPages[back], textPageSize());
+  }
+  if(planes & T6963_PAGE_GRAPHIC)
+  {
+    copy(graphicPages[front], graphicPages[back], graphicPageSize());
+  }
+}
@@ -0,0 +1,61 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_page.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Page flipping between text and graphic pages in display RAM
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_PAGE_H
+#define T6963_PAGE_H
+
+#include "T6963.h"
+#include "T6963_vram.h"
+#include "T6963_panel.h"
+
+// Planes to page flip
+#define T6963_PAGE_TEXT                0x01
+#define T6963_PAGE_GRAPHIC             0x02
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Pages
+/// @brief Two or more pages of text and/or graphics.  One page is shown
+///        while drawing goes to the back page through the T6963 draw page
+///        (T6963Graphics, T6963Shadow and T6963Text follow it).  present()
+///        shows the back page with one home address command per plane.
+///
+///        A new back page holds the frame before last.  Redraw it fully,
+///        or call copyFront() first when drawing only what changed.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Pages
+{
+  public:
+    T6963Pages(T6963& lcd, uint8_t count = 2, uint8_t height = 64, uint8_t fontHeight = 8);
+    bool begin(T6963Vram& vram, uint8_t planes = T6963_PAGE_TEXT | T6963_PAGE_GRAPHIC);
+    bool begin(T6963Panel& panel);
+    void present();
+    void copyFront();
+
+    uint8_t getFront() { return front; }
+    uint8_t getBack() { return back; }
+    uint16_t textPage(uint8_t i) { return textPages[i]; }
+    uint16_t graphicPage(uint8_t i) { return graphicPages[i]; }
+    uint16_t textPageSize();
+    uint16_t graphicPageSize();
+
+  private:
+    void copy(uint16_t from, uint16_t to, uint16_t len);
+    void show();
+
+    T6963& lcd;
+    uint8_t count;
+    uint8_t height;
+    uint8_t fontHeight;
+    uint8_t planes;
+    uint8_t front;        // page on screen
+    uint8_t back;         // page being drawn
+    uint16_t textPages[T6963_MAX_PAGES];
+    uint16_t graphicPages[T6963_MAX_PAGES];
+};
+
+#endif
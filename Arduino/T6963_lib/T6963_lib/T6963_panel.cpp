@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_panel.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Panel geometry and display RAM layout
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_panel.h"
+
+// CG RAM page layout
+#define PANEL_CG_PAGE                  2048     // offset register granularity
+#define PANEL_CG_ROM_BASE              1024     // codes 0x80-0xff in ROM mode
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Panel
+///  @brief  Constructor
+///  @param[in] lcd  The display to configure
+////////////////////////////////////////////////////////////////////////////////
+T6963Panel::T6963Panel(T6963& lcd)
+  : lcd(lcd), vram(0), cols(0), textRows(0), extra(0), cg(0)
+{
+  memset(&geo, 0, sizeof(geo));
+  memset(text, 0, sizeof(text));
+  memset(graphic, 0, sizeof(graphic));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn graphicPageSize
+///  @return  Bytes in one graphic page, or one attribute page
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Panel::graphicPageSize()
+{
+  return geo.attributes ? textPageSize() : (uint16_t)cols * geo.height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn plan
+///  @brief  Work out the RAM layout without touching the controller
+///  @param[in] g  The panel and the regions wanted
+///  @return  True if everything fits, false otherwise
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Panel::plan(const T6963Geometry& g)
+{
+  bool rtn = (g.fontWidth == 6 || g.fontWidth == 8) && g.width != 0 &&
+             g.height != 0 && g.textPages <= T6963_MAX_PAGES &&
+             g.graphicPages <= T6963_MAX_PAGES && g.glyphs <= 256 &&
+             !(g.attributes && (g.graphicPages != 0 || g.textPages == 0));
+  uint16_t limit = g.ramSize;
+
+  geo = g;
+  cols = (g.width + g.fontWidth - 1) / g.fontWidth;
+  textRows = g.height / 8;
+  cg = 0;
+  extra = 0;
+  memset(text, 0, sizeof(text));
+  memset(graphic, 0, sizeof(graphic));
+
+  if(rtn && g.glyphs != 0)
+  {
+    // highest page whose glyph region still ends inside RAM
+    uint16_t base = (g.glyphs > 128) ? 0 : PANEL_CG_ROM_BASE;
+    uint16_t need = base + g.glyphs * 8;
+    rtn = (need <= g.ramSize);
+    if(rtn)
+    {
+      cg = (g.ramSize - need) / PANEL_CG_PAGE;
+      rtn = (cg <= 31);
+      limit = (uint16_t)cg * PANEL_CG_PAGE + base;
+    }
+  }
+
+  vram = T6963Vram(limit);
+  for(uint8_t i = 0; i < g.textPages && rtn; i++)
+  {
+    rtn = vram.alloc(textPageSize(), text[i]);
+  }
+  for(uint8_t i = 0; i < graphicPageCount() && rtn; i++)
+  {
+    rtn = vram.alloc(graphicPageSize(), graphic[i]);
+  }
+  if(rtn && g.extra != 0)
+  {
+    rtn = vram.alloc(g.extra, extra);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Plan the layout, then program font width, home and area
+///          registers, CG RAM offset, mode and display mode.  Page 0 of
+///          each plane is displayed.  RAM is not cleared, see clear().
+///  @param[in] g  The panel and the regions wanted
+///  @return  True if everything fits, false otherwise (nothing sent)
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Panel::begin(const T6963Geometry& g)
+{
+  bool rtn = plan(g);
+  if(rtn)
+  {
+    bool cgRam = (g.glyphs > 128);
+    bool graphics = (g.graphicPages != 0 || g.attributes);
+    lcd.setFontWidth(g.fontWidth);
+    lcd.setPanelSize(g.width, g.height);
+    lcd.clearDrawPage();
+    lcd.setTextHomeAddress(text[0]);
+    lcd.setTextArea(cols);
+    lcd.setGraphicHomeAddress(graphic[0]);
+    lcd.setGraphicArea(cols);
+    if(g.glyphs != 0)
+    {
+      lcd.setOffsetPointer(cg);
+    }
+    if(g.attributes)
+    {
+      lcd.setTextAttributeMode(cgRam);
+    }
+    else
+    {
+      lcd.setOrMode(cgRam);
+    }
+    lcd.setDisplayMode(g.textPages != 0, graphics, 0, 0);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clear
+///  @brief  Blank every text, attribute and graphic page
+////////////////////////////////////////////////////////////////////////////////
+void T6963Panel::clear()
+{
+  for(uint8_t i = 0; i < geo.textPages; i++)
+  {
+    lcd.fill(text[i], 0, textPageSize());
+  }
+  for(uint8_t i = 0; i < graphicPageCount(); i++)
+  {
+    lcd.fill(graphic[i], 0, graphicPageSize());
+  }
+}
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_panel.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Panel geometry and display RAM layout
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_PANEL_H
+#define T6963_PANEL_H
+
+#include "T6963.h"
+#include "T6963_vram.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct T6963Geometry
+/// @brief  What the panel is and which regions of display RAM it needs
+//////////////////////////////////////////////////////////////////////////////
+
+struct T6963Geometry
+{
+  uint16_t width;          // panel width in pixels
+  uint8_t height;          // panel height in pixels
+  uint8_t fontWidth;       // 6 or 8, as FS selects
+  uint16_t ramSize;        // bytes of display RAM
+  uint8_t textPages;       // 0 for no text
+  uint8_t graphicPages;    // 0 for no graphics
+  bool attributes;         // attribute page per text page (no graphics)
+  uint16_t glyphs;         // CG RAM codes: 0, up to 128 from 0x80 in CG ROM
+                           // mode, or up to 256 in CG RAM mode
+  uint16_t extra;          // bytes for the application, e.g. a scroll ring
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Panel
+/// @brief Packs the requested regions into display RAM and programs every
+///        home, area, offset and mode register in one sequence.
+///
+///        CG RAM goes in the highest 2K page it fits in.  In CG ROM mode
+///        only the upper half of that page holds glyphs, and the lower half
+///        is used for the other regions.  Text, attribute or graphic pages
+///        and the extra region follow from address 0.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Panel
+{
+  public:
+    T6963Panel(T6963& lcd);
+    bool plan(const T6963Geometry& g);
+    bool begin(const T6963Geometry& g);
+    void clear();
+
+    uint8_t columns() { return cols; }
+    uint8_t rows() { return textRows; }
+    uint8_t textPageCount() { return geo.textPages; }
+    uint8_t graphicPageCount() { return geo.attributes ? geo.textPages : geo.graphicPages; }
+    uint16_t textHome(uint8_t page) { return text[page]; }
+    uint16_t graphicHome(uint8_t page) { return graphic[page]; }
+    uint16_t attributeHome(uint8_t page) { return graphic[page]; }
+    uint16_t textPageSize() { return (uint16_t)cols * textRows; }
+    uint16_t graphicPageSize();
+    bool hasCgRam() { return geo.glyphs != 0; }
+    uint8_t cgPage() { return cg; }
+    uint16_t extraAddress() { return extra; }
+    uint16_t used() { return vram.used(); }
+    uint16_t remaining() { return vram.remaining(); }
+
+  private:
+    T6963& lcd;
+    T6963Geometry geo;
+    T6963Vram vram;
+    uint8_t cols;
+    uint8_t textRows;
+    uint16_t text[T6963_MAX_PAGES];
+    uint16_t graphic[T6963_MAX_PAGES];  // graphic or attribute pages
+    uint16_t extra;
+    uint8_t cg;
+};
+
+#endif
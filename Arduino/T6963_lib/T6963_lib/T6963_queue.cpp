@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_queue.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Non-blocking command/data queue drained by a timer or yield()
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_queue.h"
+
+// Queue entries.  The first byte is the op, then:
+//   QUEUE_COMMAND  n, n parameter bytes, command
+//   QUEUE_WRITE    address low, address high, len, len data bytes
+//   QUEUE_FILL     address low, address high, len, data byte
+//   QUEUE_FENCE    id
+enum queueop
+{
+  QUEUE_COMMAND = 1,
+  QUEUE_WRITE,
+  QUEUE_FILL,
+  QUEUE_FENCE,
+};
+
+// Bus bytes of a write or fill before the data: address (3) + auto write
+#define QUEUE_SETUP                       4
+
+// Hold off interrupts around head / tail accesses.  On AVR the previous
+// state is restored, so it is also safe inside pump() run from a timer
+// interrupt; other cores fall back to noInterrupts / interrupts.
+#if defined(SREG)
+#define QUEUE_LOCK()                      uint8_t oldSREG = SREG; cli()
+#define QUEUE_UNLOCK()                    SREG = oldSREG
+#else
+#define QUEUE_LOCK()                      noInterrupts()
+#define QUEUE_UNLOCK()                    interrupts()
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Queue
+///  @brief  Constructor
+///  @param[in] lcd  The display the queue drains to
+////////////////////////////////////////////////////////////////////////////////
+T6963Queue::T6963Queue(T6963& lcd)
+  : lcd(lcd), head(0), tail(0), phase(0), lastWrite(0), haveLastWrite(false),
+    pumping(false), nextFence(0), doneFence(0), callback(NULL)
+{
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the statistics
+////////////////////////////////////////////////////////////////////////////////
+void T6963Queue::resetCounters()
+{
+  bytesSent = 0;
+  busyReturns = 0;
+  mergedBytes = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn used
+///  @return  Bytes queued and not yet finished, from one snapshot of head
+///           and tail
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Queue::used()
+{
+  uint16_t rtn;
+  QUEUE_LOCK();
+  rtn = head - tail;
+  QUEUE_UNLOCK();
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn publish
+///  @brief  Store head or tail so the other side never sees half of it
+////////////////////////////////////////////////////////////////////////////////
+void T6963Queue::publish(volatile uint16_t& index, uint16_t value)
+{
+  QUEUE_LOCK();
+  index = value;
+  QUEUE_UNLOCK();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn commandN
+///  @brief  Queue a command with n (0 to 2) parameter bytes
+///  @return  True if queued, false if the queue is full
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Queue::commandN(uint8_t cmd, uint8_t n, uint8_t d1, uint8_t d2)
+{
+  bool rtn = false;
+  if(space() >= 3 + n)
+  {
+    uint16_t h = head;
+    ring[h++ & (T6963_QUEUE_SIZE - 1)] = QUEUE_COMMAND;
+    ring[h++ & (T6963_QUEUE_SIZE - 1)] = n;
+    if(n > 0)
+    {
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = d1;
+    }
+    if(n > 1)
+    {
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = d2;
+    }
+    ring[h++ & (T6963_QUEUE_SIZE - 1)] = cmd;
+    publish(head, h);      // the pump sees all of the entry or none
+    haveLastWrite = false;
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn command
+///  @brief  Queue a command without, with one or with two parameter bytes
+///  @return  True if queued, false if the queue is full
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Queue::command(uint8_t cmd)
+{
+  return commandN(cmd, 0, 0, 0);
+}
+
+bool T6963Queue::command(uint8_t cmd, uint8_t d1)
+{
+  return commandN(cmd, 1, d1, 0);
+}
+
+bool T6963Queue::command(uint8_t cmd, uint8_t d1, uint8_t d2)
+{
+  return commandN(cmd, 2, d1, d2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn merge
+///  @brief  Append to the newest write entry if it is still queued and ends
+///          at addr.  Interrupts are held off so the pump cannot finish the
+///          entry while its length grows.
+///  @return  Number of bytes merged
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Queue::merge(uint16_t addr, const uint8_t* buf, uint16_t len)
+{
+  uint16_t rtn = 0;
+  if(haveLastWrite)
+  {
+    uint16_t h = head;
+    uint8_t n = at(lastWrite + 3);
+    uint16_t end = (at(lastWrite + 1) | (at(lastWrite + 2) << 8)) + n;
+    if(end == addr)
+    {
+      rtn = 255 - n;
+      if(rtn > len)
+      {
+        rtn = len;
+      }
+      if(rtn > space())
+      {
+        rtn = space();
+      }
+      for(uint16_t i = 0; i < rtn; i++)
+      {
+        ring[h++ & (T6963_QUEUE_SIZE - 1)] = buf[i];
+      }
+      QUEUE_LOCK();
+      if( (uint16_t)(lastWrite - tail) < (uint16_t)(head - tail))
+      {
+        ring[(lastWrite + 3) & (T6963_QUEUE_SIZE - 1)] = n + rtn;
+        head = h;
+        mergedBytes += rtn;
+      }
+      else
+      {
+        rtn = 0;     // already sent, start a new entry
+      }
+      QUEUE_UNLOCK();
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn write
+///  @brief  Queue bytes to write to RAM with auto write.  Nothing is queued
+///          unless all of it fits.
+///  @param[in] addr  RAM address of the first byte
+///  @param[in] buf   Bytes to write, copied into the queue
+///  @param[in] len   Number of bytes
+///  @return  True if queued, false if the queue is full
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Queue::write(uint16_t addr, const uint8_t* buf, uint16_t len)
+{
+  bool rtn = false;
+  // worst case: no merge, one entry header per 255 bytes
+  if(buf != NULL && space() >= len + QUEUE_SETUP * ( (len + 254) / 255))
+  {
+    uint16_t done = merge(addr, buf, len);
+    while(done < len)
+    {
+      uint8_t n = (len - done > 255) ? 255 : len - done;
+      uint16_t h = head;
+      uint16_t a = addr + done;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = QUEUE_WRITE;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = a & 0xff;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = a >> 8;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = n;
+      for(uint8_t i = 0; i < n; i++)
+      {
+        ring[h++ & (T6963_QUEUE_SIZE - 1)] = buf[done + i];
+      }
+      lastWrite = head;
+      haveLastWrite = true;
+      publish(head, h);
+      done += n;
+    }
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fill
+///  @brief  Queue len copies of one byte to write to RAM
+///  @return  True if queued, false if the queue is full
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Queue::fill(uint16_t addr, uint8_t d, uint16_t len)
+{
+  bool rtn = false;
+  uint16_t entries = (len + 254) / 255;
+  if(space() >= (QUEUE_SETUP + 1) * entries)
+  {
+    uint16_t done = 0;
+    while(done < len)
+    {
+      uint8_t n = (len - done > 255) ? 255 : len - done;
+      uint16_t h = head;
+      uint16_t a = addr + done;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = QUEUE_FILL;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = a & 0xff;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = a >> 8;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = n;
+      ring[h++ & (T6963_QUEUE_SIZE - 1)] = d;
+      publish(head, h);
+      done += n;
+    }
+    haveLastWrite = false;
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fence
+///  @brief  Mark the current end of the queue
+///  @return  Id to pass to reached(), or the previous id if the queue is full
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Queue::fence()
+{
+  if(space() >= 2)
+  {
+    uint16_t h = head;
+    nextFence++;
+    ring[h++ & (T6963_QUEUE_SIZE - 1)] = QUEUE_FENCE;
+    ring[h++ & (T6963_QUEUE_SIZE - 1)] = nextFence;
+    publish(head, h);
+    haveLastWrite = false;
+  }
+  return nextFence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn reached
+///  @return  True once everything queued before fence id has been sent
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Queue::reached(uint8_t id)
+{
+  return (int8_t)(doneFence - id) >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn step
+///  @brief  Send the next bus byte of the entry at tail, if the controller
+///          is ready for it
+///  @return  False if the controller was busy
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Queue::step()
+{
+  bool rtn = true;
+  bool done = false;
+  uint8_t op = at(tail);
+
+  if(op == QUEUE_COMMAND)
+  {
+    uint8_t n = at(tail + 1);
+    if(phase < n)
+    {
+      rtn = lcd.tryDataByte(at(tail + 2 + phase));
+    }
+    else
+    {
+      rtn = lcd.tryCommandByte(at(tail + 2 + n));
+      done = rtn;
+    }
+  }
+  else if(op == QUEUE_WRITE || op == QUEUE_FILL)
+  {
+    uint8_t n = at(tail + 3);
+    if(phase < 2)
+    {
+      rtn = lcd.tryDataByte(at(tail + 1 + phase));
+    }
+    else if(phase == 2)
+    {
+      rtn = lcd.tryCommandByte(T6963_SET_ADDRESS_POINTER);
+    }
+    else if(phase == 3)
+    {
+      rtn = lcd.tryCommandByte(T6963_AUTO_WRITE_SET);
+    }
+    else if(phase < QUEUE_SETUP + n)
+    {
+      uint16_t i = (op == QUEUE_WRITE) ? tail + phase : tail + QUEUE_SETUP;
+      rtn = lcd.tryDataByte(at(i));
+    }
+    else
+    {
+      rtn = lcd.tryCommandByte(T6963_AUTO_RESET);
+      done = rtn;
+    }
+  }
+  else
+  {
+    doneFence = at(tail + 1);
+    if(callback != NULL)
+    {
+      callback(doneFence);
+    }
+    done = true;
+  }
+
+  if(rtn && op != QUEUE_FENCE)
+  {
+    bytesSent++;
+  }
+  if(done)
+  {
+    uint16_t size = 2;
+    if(op == QUEUE_COMMAND)
+    {
+      size = 3 + at(tail + 1);
+    }
+    else if(op == QUEUE_WRITE)
+    {
+      size = QUEUE_SETUP + at(tail + 3);
+    }
+    else if(op == QUEUE_FILL)
+    {
+      size = QUEUE_SETUP + 1;
+    }
+    phase = 0;
+    publish(tail, tail + size);
+  }
+  else if(rtn)
+  {
+    phase++;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pump
+///  @brief  Send queued bytes until the queue is empty, the controller
+///          stays busy for T6963_QUEUE_POLLS status re-reads, or maxBytes
+///          have been sent.  Waits no longer than those re-reads; safe to
+///          call from a timer interrupt or yield().
+///  @param[in] maxBytes  Most bus bytes to send in this call
+///  @return  Number of bus bytes sent
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Queue::pump(uint16_t maxBytes)
+{
+  uint16_t rtn = 0;
+  if(!pumping)
+  {
+    uint32_t start = bytesSent;
+    bool ready = true;
+    pumping = true;
+    while(ready && used() != 0 && (uint32_t)(bytesSent - start) < maxBytes)
+    {
+      ready = step();
+      for(uint8_t p = 0; !ready && p < T6963_QUEUE_POLLS; p++)
+      {
+        ready = step();     // a short busy spell is cheaper to wait out
+      }
+      if(!ready)
+      {
+        busyReturns++;
+      }
+    }
+    rtn = bytesSent - start;
+    pumping = false;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn flush
+///  @brief  Block until the queue is empty
+////////////////////////////////////////////////////////////////////////////////
+void T6963Queue::flush()
+{
+  while(!isEmpty())
+  {
+    pump();
+  }
+}
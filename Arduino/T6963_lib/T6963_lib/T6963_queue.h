@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_queue.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Non-blocking command/data queue drained by a timer or yield()
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_QUEUE_H
+#define T6963_QUEUE_H
+
+#include "T6963.h"
+
+// Ring size in bytes, must be a power of two.  Size it to hold everything
+// queued between two drains: 512 takes a 320 byte graphic strip (8 rows
+// of 40) with its entry headers; text updates need far less.
+#ifndef T6963_QUEUE_SIZE
+#define T6963_QUEUE_SIZE                512
+#endif
+
+// Status re-reads pump() makes after finding the controller busy before it
+// returns.  8 reads cover about 4 uS of busy at 500 nS a read; a longer
+// spell is left to the next call.
+#ifndef T6963_QUEUE_POLLS
+#define T6963_QUEUE_POLLS                 8
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Queue
+/// @brief The application queues commands and RAM writes without waiting;
+///        pump() sends as many bytes as the controller will take right now
+///        and returns once it has reported busy T6963_QUEUE_POLLS + 1
+///        times in a row.  Call pump() from a timer interrupt or from
+///        yield(), but not from both, and do not use the T6963 object
+///        directly while the queue is not empty.  head and tail are 16
+///        bits, which an AVR loads and stores a byte at a time, so the side
+///        that does not own an index reads it, and the owner publishes it,
+///        with interrupts held off.
+///
+///        A write that continues where the previous queued write ended is
+///        merged into the same auto write burst.  fence() returns an id
+///        that reached() reports once everything queued before it is sent;
+///        an optional callback is run from pump() at the same point.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Queue
+{
+  public:
+    T6963Queue(T6963& lcd);
+
+    bool command(uint8_t cmd);
+    bool command(uint8_t cmd, uint8_t d1);
+    bool command(uint8_t cmd, uint8_t d1, uint8_t d2);
+    bool write(uint16_t addr, const uint8_t* buf, uint16_t len);
+    bool fill(uint16_t addr, uint8_t d, uint16_t len);
+    uint8_t fence();
+    bool reached(uint8_t id);
+    void setCallback(void (*fn)(uint8_t id)) { callback = fn; }
+
+    uint16_t pump(uint16_t maxBytes = 0xffff);
+    void flush();
+    bool isEmpty() { return used() == 0; }
+    uint16_t space() { return T6963_QUEUE_SIZE - used(); }
+
+    uint32_t getBytesSent() { return bytesSent; }
+    uint32_t getBusyReturns() { return busyReturns; }
+    uint32_t getMergedBytes() { return mergedBytes; }
+    void resetCounters();
+
+  private:
+    uint8_t at(uint16_t i) { return ring[i & (T6963_QUEUE_SIZE - 1)]; }
+    uint16_t used();
+    void publish(volatile uint16_t& index, uint16_t value);
+    bool commandN(uint8_t cmd, uint8_t n, uint8_t d1, uint8_t d2);
+    uint16_t merge(uint16_t addr, const uint8_t* buf, uint16_t len);
+    bool step();
+
+    T6963& lcd;
+    uint8_t ring[T6963_QUEUE_SIZE];
+    volatile uint16_t head;       // next byte the application writes
+    volatile uint16_t tail;       // first byte of the entry being sent
+    uint16_t phase;               // bus bytes of that entry already sent
+    uint16_t lastWrite;           // start of the newest write entry
+    bool haveLastWrite;
+    volatile bool pumping;
+    uint8_t nextFence;
+    volatile uint8_t doneFence;
+    void (*callback)(uint8_t id);
+
+    uint32_t bytesSent;           // bus bytes sent by pump()
+    uint32_t busyReturns;         // pump() found the controller busy
+    uint32_t mergedBytes;         // bytes appended to an earlier write
+};
+
+#endif
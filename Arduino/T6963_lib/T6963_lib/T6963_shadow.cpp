@@ -0,0 +1,360 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_shadow.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief RAM shadow of the T6963 text and graphic areas with dirty tracking
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_shadow.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Shadow
+///  @brief  Constructor.  Geometry is read from lcd when begin() is called;
+///          until then both planes are empty and clean.
+///  @param[in] lcd         The display the shadow flushes to
+///  @param[in] height      Panel height in pixels
+///  @param[in] fontHeight  Pixel rows per text row
+////////////////////////////////////////////////////////////////////////////////
+T6963Shadow::T6963Shadow(T6963& lcd, uint8_t height, uint8_t fontHeight)
+  : lcd(lcd), height(height), fontHeight(fontHeight)
+{
+  text.buf = NULL;
+  text.home = 0;
+  text.cols = 0;
+  text.rows = 0;
+  text.lo = textLo;
+  text.hi = textHi;
+  graphic.buf = NULL;
+  graphic.home = 0;
+  graphic.cols = 0;
+  graphic.rows = 0;
+  graphic.lo = graphicLo;
+  graphic.hi = graphicHi;
+  memset(textLo, 0xff, sizeof(textLo));
+  memset(graphicLo, 0xff, sizeof(graphicLo));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Attach buffers, sized from the display's text and graphic areas.
+///          Call after setTextHomeAddress / setTextArea etc.  The shadow
+///          starts clean: it assumes buffer and VRAM already match.
+///  @param[in] textBuf     textSize() bytes, or NULL to not shadow text
+///  @param[in] graphicBuf  graphicSize() bytes, or NULL to not shadow graphics
+///  @return  True if the geometry fits, false otherwise: more than
+///           T6963_SHADOW_MAX_ROWS pixel rows, or more than a text row
+///           per 8 of them (a fontHeight under 8 on a tall panel)
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Shadow::begin(uint8_t* textBuf, uint8_t* graphicBuf)
+{
+  bool rtn = false;
+  if(height <= T6963_SHADOW_MAX_ROWS && fontHeight != 0 &&
+     height / fontHeight <= T6963_SHADOW_MAX_ROWS / 8)
+  {
+    text.buf = textBuf;
+    text.home = lcd.getTextDrawAddress();
+    text.cols = lcd.getTextArea();
+    text.rows = height / fontHeight;
+    graphic.buf = graphicBuf;
+    graphic.home = lcd.getGraphicDrawAddress();
+    graphic.cols = lcd.getGraphicArea();
+    graphic.rows = height;
+    memset(textLo, 0xff, sizeof(textLo));
+    memset(graphicLo, 0xff, sizeof(graphicLo));
+    rtn = true;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn textSize
+///  @return  Bytes needed for the text buffer
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Shadow::textSize()
+{
+  return (uint16_t)lcd.getTextArea() * (height / fontHeight);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn graphicSize
+///  @return  Bytes needed for the graphic buffer
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Shadow::graphicSize()
+{
+  return (uint16_t)lcd.getGraphicArea() * height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn markDirty
+///  @brief  Widen the dirty span of one row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::markDirty(Plane& p, uint8_t row, uint8_t first, uint8_t last)
+{
+  if(p.lo[row] == 0xff)
+  {
+    p.lo[row] = first;
+    p.hi[row] = last;
+  }
+  else
+  {
+    if(first < p.lo[row])
+    {
+      p.lo[row] = first;
+    }
+    if(last > p.hi[row])
+    {
+      p.hi[row] = last;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeText
+///  @brief  Store a character code (ROM code, not ASCII) in the text shadow
+///  @param[in] col  Text column
+///  @param[in] row  Text row
+///  @param[in] c    Character code
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::writeText(uint8_t col, uint8_t row, uint8_t c)
+{
+  if(text.buf != NULL && col < text.cols && row < text.rows)
+  {
+    uint8_t* b = &text.buf[(uint16_t)row * text.cols + col];
+    if(*b != c)
+    {
+      *b = c;
+      markDirty(text, row, col, col);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn printText
+///  @brief  Store an ASCII string in the text shadow, clipped at row end
+///  @param[in] col  Starting text column
+///  @param[in] row  Text row
+///  @param[in] str  Null terminated string
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::printText(uint8_t col, uint8_t row, const char* str)
+{
+  if(str != NULL)
+  {
+    while(*str != 0 && col < text.cols)
+    {
+      writeText(col++, row, (uint8_t)(*str++ - 32));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readText
+///  @return  Character code held in the text shadow, 0 if not shadowed
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Shadow::readText(uint8_t col, uint8_t row)
+{
+  uint8_t rtn = 0;
+  if(text.buf != NULL && col < text.cols && row < text.rows)
+  {
+    rtn = text.buf[(uint16_t)row * text.cols + col];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeGraphic
+///  @brief  Store one graphic byte in the shadow
+///  @param[in] col  Byte column within the graphic area
+///  @param[in] row  Pixel row
+///  @param[in] d    Pixel byte
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::writeGraphic(uint8_t col, uint8_t row, uint8_t d)
+{
+  if(graphic.buf != NULL && col < graphic.cols && row < graphic.rows)
+  {
+    uint8_t* b = &graphic.buf[(uint16_t)row * graphic.cols + col];
+    if(*b != d)
+    {
+      *b = d;
+      markDirty(graphic, row, col, col);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readGraphic
+///  @return  Graphic byte held in the shadow, 0 if not shadowed
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Shadow::readGraphic(uint8_t col, uint8_t row)
+{
+  uint8_t rtn = 0;
+  if(graphic.buf != NULL && col < graphic.cols && row < graphic.rows)
+  {
+    rtn = graphic.buf[(uint16_t)row * graphic.cols + col];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn graphicRow
+///  @brief  Direct access to one row of the graphic shadow.  Callers writing
+///          through this pointer must call markGraphicDirty themselves.
+///  @return  Pointer to the row, NULL if not shadowed
+////////////////////////////////////////////////////////////////////////////////
+uint8_t* T6963Shadow::graphicRow(uint8_t row)
+{
+  uint8_t* rtn = NULL;
+  if(graphic.buf != NULL && row < graphic.rows)
+  {
+    rtn = &graphic.buf[(uint16_t)row * graphic.cols];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn markGraphicDirty
+///  @brief  Flag bytes first..last of a graphic row for the next flush
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::markGraphicDirty(uint8_t row, uint8_t first, uint8_t last)
+{
+  if(row < graphic.rows && first <= last && last < graphic.cols)
+  {
+    markDirty(graphic, row, first, last);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillText
+///  @brief  Fill the whole text shadow with one character code
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::fillText(uint8_t c)
+{
+  for(uint8_t r = 0; r < text.rows; r++)
+  {
+    for(uint8_t col = 0; col < text.cols; col++)
+    {
+      writeText(col, r, c);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillGraphic
+///  @brief  Fill the whole graphic shadow with one byte
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::fillGraphic(uint8_t d)
+{
+  for(uint8_t r = 0; r < graphic.rows; r++)
+  {
+    for(uint8_t col = 0; col < graphic.cols; col++)
+    {
+      writeGraphic(col, r, d);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn markAllDirty
+///  @brief  Force the next flush to resend both shadowed planes entirely
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::markAllDirty()
+{
+  for(uint8_t r = 0; text.buf != NULL && text.cols != 0 && r < text.rows; r++)
+  {
+    markDirty(text, r, 0, text.cols - 1);
+  }
+  for(uint8_t r = 0; graphic.buf != NULL && graphic.cols != 0 && r < graphic.rows; r++)
+  {
+    markDirty(graphic, r, 0, graphic.cols - 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn isDirty
+///  @return  True if anything is waiting to be flushed
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Shadow::isDirty()
+{
+  bool rtn = false;
+  for(uint8_t r = 0; r < text.rows && !rtn; r++)
+  {
+    rtn = (text.lo[r] != 0xff);
+  }
+  for(uint8_t r = 0; r < graphic.rows && !rtn; r++)
+  {
+    rtn = (graphic.lo[r] != 0xff);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn sendRange
+///  @brief  Send plane bytes [start, end) to VRAM in one auto write burst
+////////////////////////////////////////////////////////////////////////////////
+void T6963Shadow::sendRange(Plane& p, uint16_t start, uint16_t end)
+{
+  lcd.writeBlock(p.home + start, &p.buf[start], end - start);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn flushPlane
+///  @brief  Send the dirty spans of one plane.  Spans separated by no more
+///          than T6963_SHADOW_GAP clean bytes are merged into one burst.
+///  @return  Number of data bytes sent
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Shadow::flushPlane(Plane& p)
+{
+  uint16_t rtn = 0;
+  bool open = false;
+  uint16_t start = 0;
+  uint16_t end = 0;
+
+  if(p.buf != NULL)
+  {
+    for(uint8_t r = 0; r < p.rows; r++)
+    {
+      if(p.lo[r] != 0xff)
+      {
+        uint16_t lo = (uint16_t)r * p.cols + p.lo[r];
+        uint16_t hi = (uint16_t)r * p.cols + p.hi[r] + 1;
+        if(open && lo - end <= T6963_SHADOW_GAP)
+        {
+          end = hi;
+        }
+        else
+        {
+          if(open)
+          {
+            sendRange(p, start, end);
+            rtn += end - start;
+          }
+          open = true;
+          start = lo;
+          end = hi;
+        }
+        p.lo[r] = 0xff;
+      }
+    }
+    if(open)
+    {
+      sendRange(p, start, end);
+      rtn += end - start;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn flush
+///  @brief  Push every changed span of the shadow to the controller, at
+///          the current draw page
+///  @return  Number of data bytes sent
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Shadow::flush()
+{
+  uint16_t rtn = 0;
+  text.home = lcd.getTextDrawAddress();
+  graphic.home = lcd.getGraphicDrawAddress();
+  rtn += flushPlane(text);
+  rtn += flushPlane(graphic);
+  return rtn;
+}
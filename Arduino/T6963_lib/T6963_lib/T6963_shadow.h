@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_shadow.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief RAM shadow of the T6963 text and graphic areas with dirty tracking
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_SHADOW_H
+#define T6963_SHADOW_H
+
+#include "T6963.h"
+
+// Most pixel rows a shadowed graphic area may have (240x128 panels)
+#ifndef T6963_SHADOW_MAX_ROWS
+#define T6963_SHADOW_MAX_ROWS           128
+#endif
+
+// Clean gaps up to this many bytes are rewritten rather than re-addressed.
+// Re-addressing costs auto reset + 2 address bytes + command + auto write.
+#ifndef T6963_SHADOW_GAP
+#define T6963_SHADOW_GAP                  4
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Shadow
+/// @brief Drawing goes to RAM only, flush() sends the changed row spans.
+///        Either plane may be left unshadowed by passing a NULL buffer.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Shadow
+{
+  public:
+    T6963Shadow(T6963& lcd, uint8_t height = 64, uint8_t fontHeight = 8);
+    bool begin(uint8_t* textBuf, uint8_t* graphicBuf);
+    uint16_t textSize();
+    uint16_t graphicSize();
+
+    void writeText(uint8_t col, uint8_t row, uint8_t c);
+    void printText(uint8_t col, uint8_t row, const char* str);
+    uint8_t readText(uint8_t col, uint8_t row);
+    void writeGraphic(uint8_t col, uint8_t row, uint8_t d);
+    uint8_t readGraphic(uint8_t col, uint8_t row);
+    void fillText(uint8_t c);
+    void fillGraphic(uint8_t d);
+    uint8_t* graphicRow(uint8_t row);
+    void markGraphicDirty(uint8_t row, uint8_t first, uint8_t last);
+    void markAllDirty();
+    bool isDirty();
+    uint16_t flush();
+
+  private:
+    struct Plane
+    {
+      uint8_t* buf;
+      uint16_t home;
+      uint8_t cols;
+      uint8_t rows;
+      uint8_t* lo;      // first dirty byte per row, 0xff if clean
+      uint8_t* hi;      // last dirty byte per row
+    };
+
+    void markDirty(Plane& p, uint8_t row, uint8_t first, uint8_t last);
+    uint16_t flushPlane(Plane& p);
+    void sendRange(Plane& p, uint16_t start, uint16_t end);
+
+    T6963& lcd;
+    uint8_t height;
+    uint8_t fontHeight;
+    Plane text;
+    Plane graphic;
+    uint8_t textLo[T6963_SHADOW_MAX_ROWS / 8];
+    uint8_t textHi[T6963_SHADOW_MAX_ROWS / 8];
+    uint8_t graphicLo[T6963_SHADOW_MAX_ROWS];
+    uint8_t graphicHi[T6963_SHADOW_MAX_ROWS];
+};
+
+#endif
@@ -0,0 +1,329 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_sprite.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Graphic plane sprites with background save and restore
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_sprite.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Sprite
+///  @brief  Constructor.  The sprite starts hidden with no image.
+///  @param[in] lcd  The display to draw on
+////////////////////////////////////////////////////////////////////////////////
+T6963Sprite::T6963Sprite(T6963& lcd)
+  : lcd(lcd), bits(NULL), mask(NULL), w(0), h(0), rop(T6963_ROP_OR), visible(false), cur(0)
+{
+  place(box[0], 0, 0);
+  place(box[1], 0, 0);
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the byte and burst counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sprite::resetCounters()
+{
+  bytesRead = 0;
+  bytesWritten = 0;
+  bursts = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setImage_P
+///  @brief  Change the bitmap.  A visible sprite is redrawn in place.
+///  @param[in] bits  PROGMEM bitmap, rows (w + 7) / 8 bytes, MSB leftmost
+///  @param[in] w, h  Size in pixels, up to T6963_SPRITE_MAX_W / _H
+///  @param[in] mask  PROGMEM mask of the same shape: only its set pixels
+///                   are combined with the background.  NULL for all.
+///  @return  True if the size is supported
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Sprite::setImage_P(const uint8_t* bits, uint8_t w, uint8_t h, const uint8_t* mask)
+{
+  bool rtn = (bits != NULL && w > 0 && h > 0 &&
+              w <= T6963_SPRITE_MAX_W && h <= T6963_SPRITE_MAX_H);
+  if(rtn)
+  {
+    bool was = visible;
+    int16_t x = box[cur].x;
+    int16_t y = box[cur].y;
+    hide();
+    this->bits = bits;
+    this->mask = mask;
+    this->w = w;
+    this->h = h;
+    if(was)
+    {
+      moveTo(x, y);
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setRop
+///  @brief  How sprite pixels combine with the background: T6963_ROP_OR,
+///          T6963_ROP_XOR, T6963_ROP_AND or T6963_ROP_COPY.  A visible
+///          sprite is redrawn in place.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sprite::setRop(uint8_t rop)
+{
+  if(rop != this->rop)
+  {
+    bool was = visible;
+    hide();
+    this->rop = rop;
+    if(was)
+    {
+      moveTo(box[cur].x, box[cur].y);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn place
+///  @brief  Work out the byte columns a sprite at x, y covers
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sprite::place(Box& b, int16_t x, int16_t y)
+{
+  uint8_t fw = lcd.getFontWidth();
+  int16_t right = x + (w > 0 ? w : 1) - 1;
+  b.x = x;
+  b.y = y;
+  b.col = (x >= 0) ? x / fw : -( (fw - 1 - x) / fw);
+  b.cols = ( (right >= 0) ? right / fw : -( (fw - 1 - right) / fw)) - b.col + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn inBox
+///  @return  True if a graphic byte is covered by a box
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Sprite::inBox(const Box& b, int16_t col, int16_t row)
+{
+  return col >= b.col && col < b.col + b.cols && row >= b.y && row < b.y + h;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn onScreen
+///  @return  True if a graphic byte is inside the graphic area
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Sprite::onScreen(int16_t col, int16_t row)
+{
+  uint8_t height = (lcd.getPanelHeight() != 0) ? lcd.getPanelHeight() : 64;
+  return col >= 0 && col < lcd.getGraphicArea() && row >= 0 && row < height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn uncovered
+///  @return  True if byte r, k of box a is on screen and not covered by
+///           box other (NULL for no box)
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Sprite::uncovered(const Box& a, uint8_t r, uint8_t k, const Box* other)
+{
+  int16_t col = a.col + k;
+  int16_t row = a.y + r;
+  return onScreen(col, row) && (other == NULL || !inBox(*other, col, row));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn address
+///  @return  RAM address of a graphic byte on the drawing page
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Sprite::address(int16_t col, int16_t row)
+{
+  return lcd.getGraphicDrawAddress() + (uint16_t)row * lcd.getGraphicArea() + col;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn compose
+///  @brief  The graphic byte shown at byte k of row r of a box
+///  @param[in] b   The box
+///  @param[in] r   Row within the sprite
+///  @param[in] k   Byte column within the box
+///  @param[in] bg  The background byte under it
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Sprite::compose(const Box& b, uint8_t r, uint8_t k, uint8_t bg)
+{
+  uint8_t fw = lcd.getFontWidth();
+  uint8_t stride = (w + 7) / 8;
+  uint8_t img = 0;
+  uint8_t m = 0;
+  uint8_t d;
+  for(uint8_t p = 0; p < fw; p++)
+  {
+    int16_t sx = (b.col + k) * fw + p - b.x;
+    if(sx >= 0 && sx < w)
+    {
+      uint16_t i = (uint16_t)r * stride + (sx >> 3);
+      uint8_t sbit = 0x80 >> (sx & 7);
+      uint8_t bit = 1 << (fw - 1 - p);
+      if(pgm_read_byte(&bits[i]) & sbit)
+      {
+        img |= bit;
+      }
+      if(mask == NULL || (pgm_read_byte(&mask[i]) & sbit))
+      {
+        m |= bit;
+      }
+    }
+  }
+  if(rop == T6963_ROP_XOR)
+  {
+    d = bg ^ img;
+  }
+  else if(rop == T6963_ROP_AND)
+  {
+    d = bg & img;
+  }
+  else if(rop == T6963_ROP_COPY)
+  {
+    d = img;
+  }
+  else
+  {
+    d = bg | img;
+  }
+  return (bg & ~m) | (d & m);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn restore
+///  @brief  Write back the saved background of a box, one burst per run of
+///          bytes on screen and outside box keep
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sprite::restore(const Box& b, uint8_t set, const Box* keep)
+{
+  for(uint8_t r = 0; r < h; r++)
+  {
+    uint8_t k = 0;
+    while(k < b.cols)
+    {
+      if(uncovered(b, r, k, keep))
+      {
+        uint8_t s = k;
+        while(k < b.cols && uncovered(b, r, k, keep))
+        {
+          k++;
+        }
+        lcd.writeBlock(address(b.col + s, b.y + r), &saved[set][r][s], k - s);
+        bytesWritten += k - s;
+        bursts++;
+      }
+      else
+      {
+        k++;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn hide
+///  @brief  Take the sprite off the screen, restoring what was under it
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sprite::hide()
+{
+  if(visible)
+  {
+    restore(box[cur], cur, NULL);
+    visible = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn moveTo
+///  @brief  Show the sprite with its top left pixel at x, y (it may hang
+///          off any edge), moving it if it is already shown
+///  @return  False if no image is set
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Sprite::moveTo(int16_t x, int16_t y)
+{
+  bool rtn = (bits != NULL);
+  if(rtn)
+  {
+    uint8_t nxt = cur ^ 1;
+    Box& o = box[cur];
+    Box& n = box[nxt];
+    const Box* old = visible ? &o : NULL;
+    uint8_t line[T6963_SPRITE_MAX_COLS];
+    place(n, x, y);
+
+    // Background under the new box: saved where the old box covered it,
+    // read back elsewhere
+    for(uint8_t r = 0; r < h; r++)
+    {
+      int16_t row = n.y + r;
+      uint8_t k = 0;
+      while(k < n.cols)
+      {
+        if(uncovered(n, r, k, old))
+        {
+          uint8_t s = k;
+          while(k < n.cols && uncovered(n, r, k, old))
+          {
+            k++;
+          }
+          lcd.readBlock(address(n.col + s, row), &line[s], k - s);
+          bytesRead += k - s;
+          bursts++;
+        }
+        else
+        {
+          k++;
+        }
+      }
+      for(k = 0; k < n.cols; k++)
+      {
+        int16_t col = n.col + k;
+        if(old != NULL && inBox(o, col, row))
+        {
+          saved[nxt][r][k] = saved[cur][row - o.y][col - o.col];
+        }
+        else
+        {
+          saved[nxt][r][k] = onScreen(col, row) ? line[k] : 0;
+        }
+      }
+    }
+
+    if(old != NULL)
+    {
+      restore(o, cur, &n);
+    }
+
+    // Write each row's changed bytes: the screen shows the old sprite
+    // where the boxes overlap and the background elsewhere
+    for(uint8_t r = 0; r < h; r++)
+    {
+      int16_t row = n.y + r;
+      int8_t lo = -1;
+      int8_t hi = -1;
+      for(uint8_t k = 0; k < n.cols; k++)
+      {
+        int16_t col = n.col + k;
+        uint8_t shown = saved[nxt][r][k];
+        if(old != NULL && inBox(o, col, row))
+        {
+          shown = compose(o, row - o.y, col - o.col, shown);
+        }
+        line[k] = compose(n, r, k, saved[nxt][r][k]);
+        if(onScreen(col, row) && line[k] != shown)
+        {
+          lo = (lo < 0) ? k : lo;
+          hi = k;
+        }
+      }
+      if(lo >= 0)
+      {
+        lcd.writeBlock(address(n.col + lo, row), &line[lo], hi - lo + 1);
+        bytesWritten += hi - lo + 1;
+        bursts++;
+      }
+    }
+    cur = nxt;
+    visible = true;
+  }
+  return rtn;
+}
@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_sprite.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Graphic plane sprites with background save and restore
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_SPRITE_H
+#define T6963_SPRITE_H
+
+#include "T6963.h"
+#include "T6963_gfx.h"
+
+// Largest sprite in pixels
+#ifndef T6963_SPRITE_MAX_W
+#define T6963_SPRITE_MAX_W               16
+#endif
+#ifndef T6963_SPRITE_MAX_H
+#define T6963_SPRITE_MAX_H               16
+#endif
+
+// Graphic bytes a row of the largest sprite can touch (6 pixel font)
+#define T6963_SPRITE_MAX_COLS             ( (T6963_SPRITE_MAX_W + 4) / 6 + 1)
+
+// Sprite pixels replace the background (with T6963_ROP_OR/XOR/AND)
+#define T6963_ROP_COPY                    3
+
+// Bus bytes outside the data in each burst: address (2 data, 1 command),
+// auto mode and auto reset
+#define T6963_SPRITE_BURST_COST           5
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Sprite
+/// @brief A PROGMEM bitmap drawn over the graphic plane and taken off
+///        again without a redraw.  The graphic bytes under the sprite are
+///        saved with auto reads before it is drawn and written back when
+///        it moves or hides.
+///
+///        A move only reads the bytes the sprite newly covers (the rest
+///        of the background is already saved), only restores the bytes
+///        it leaves, and only writes the bytes whose pixels change.
+///        The text plane is never touched, so the display mode
+///        (setOrMode, setXorMode, setAndMode) decides how the sprite
+///        combines with text, e.g. a solid marker inverts text in XOR.
+///
+///        Hide the sprite before drawing under it and show it again
+///        afterwards, or the restore will undo the drawing.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Sprite
+{
+  public:
+    T6963Sprite(T6963& lcd);
+
+    bool setImage_P(const uint8_t* bits, uint8_t w, uint8_t h, const uint8_t* mask = NULL);
+    void setRop(uint8_t rop);
+    bool moveTo(int16_t x, int16_t y);
+    void hide();
+    bool isVisible() { return visible; }
+    int16_t getX() { return box[cur].x; }
+    int16_t getY() { return box[cur].y; }
+
+    void resetCounters();
+    uint32_t getBytesRead() { return bytesRead; }
+    uint32_t getBytesWritten() { return bytesWritten; }
+    uint32_t getBursts() { return bursts; }
+    uint32_t getBusBytes() { return bytesRead + bytesWritten + bursts * T6963_SPRITE_BURST_COST; }
+
+  private:
+    // Graphic bytes covered by the sprite at one position
+    struct Box
+    {
+      int16_t x;          // pixel position
+      int16_t y;
+      int16_t col;        // first byte column
+      uint8_t cols;       // byte columns
+    };
+
+    void place(Box& b, int16_t x, int16_t y);
+    bool inBox(const Box& b, int16_t col, int16_t row);
+    bool onScreen(int16_t col, int16_t row);
+    bool uncovered(const Box& a, uint8_t r, uint8_t k, const Box* other);
+    uint8_t compose(const Box& b, uint8_t r, uint8_t k, uint8_t bg);
+    uint16_t address(int16_t col, int16_t row);
+    void restore(const Box& b, uint8_t set, const Box* keep);
+
+    T6963& lcd;
+    const uint8_t* bits;      // PROGMEM, rows (w + 7) / 8 bytes, MSB leftmost
+    const uint8_t* mask;      // PROGMEM, as bits, NULL for the whole box
+    uint8_t w;
+    uint8_t h;
+    uint8_t rop;
+    bool visible;
+    uint8_t cur;              // box and saved set on screen
+    Box box[2];
+    uint8_t saved[2][T6963_SPRITE_MAX_H][T6963_SPRITE_MAX_COLS];
+    uint32_t bytesRead;
+    uint32_t bytesWritten;
+    uint32_t bursts;
+};
+
+#endif
@@ -0,0 +1,570 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_term.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief VT100 subset text terminal with hardware scrolling
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_term.h"
+
+// Escape parser states
+enum termstate
+{
+  TERM_TEXT = 0,      // plain characters
+  TERM_ESCAPE,        // ESC seen
+  TERM_CSI,           // ESC [ seen, collecting parameters
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Terminal
+///  @brief  Constructor.  The text area width is read from lcd in begin().
+///  @param[in] lcd       The display to write to
+///  @param[in] base      RAM address of the scroll ring
+///  @param[in] ringSize  Bytes of RAM the ring may use.  Must hold at least
+///                       one screen; every extra row is one more scroll
+///                       before VRAM has to be copied.
+///  @param[in] rows      Visible text rows
+////////////////////////////////////////////////////////////////////////////////
+T6963Terminal::T6963Terminal(T6963& lcd, uint16_t base, uint16_t ringSize, uint8_t rows)
+  : lcd(lcd), base(base), attrBase(0), attrs(false), ringSize(ringSize), cols(0),
+    rows(rows), ringRows(0), top(0), col(0), row(0), attribute(T6963_ATTR_NORMAL),
+    state(TERM_TEXT), numParams(0), scrolls(0), wraps(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setAttributeBase
+///  @brief  Keep character attributes in a second ring of ringSize bytes,
+///          scrolled with the text by moving the graphic home address.
+///          The display must be in text attribute mode with the graphic
+///          area equal to the text area.  Call before begin().
+///  @param[in] addr  RAM address of the attribute ring
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::setAttributeBase(uint16_t addr)
+{
+  attrBase = addr;
+  attrs = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn begin
+///  @brief  Size the ring from the text area, clear the screen and home the
+///          cursor.  Call after setTextArea (and setGraphicArea).
+///  @return  True if the ring holds at least one screen, false otherwise
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Terminal::begin()
+{
+  bool rtn = false;
+  cols = lcd.getTextArea();
+  if(cols != 0 && rows != 0 && (!attrs || lcd.getGraphicArea() == cols))
+  {
+    uint16_t n = ringSize / cols;
+    ringRows = (n > 255) ? 255 : n;
+    if(ringRows >= rows)
+    {
+      state = TERM_TEXT;
+      attribute = T6963_ATTR_NORMAL;
+      clear();
+      rtn = true;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn cellAddress
+///  @return  RAM address of a character cell on screen
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Terminal::cellAddress(uint8_t c, uint8_t r)
+{
+  return base + (uint16_t)(top + r) * cols + c;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clearCells
+///  @brief  Blank n cells of one row, and reset their attributes
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::clearCells(uint8_t r, uint8_t c, uint8_t n)
+{
+  uint16_t offs = cellAddress(c, r) - base;
+  lcd.fill(base + offs, 0, n);
+  if(attrs)
+  {
+    lcd.fill(attrBase + offs, T6963_ATTR_NORMAL, n);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn putRun
+///  @brief  Write character codes at the cursor.  One code is written with
+///          a single data write, longer runs with one auto write.
+///  @param[in] codes  Character generator codes
+///  @param[in] n      Number of codes, must fit on the current row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::putRun(const uint8_t* codes, uint8_t n)
+{
+  uint16_t offs = cellAddress(col, row) - base;
+  if(n == 1)
+  {
+    lcd.setAddress(base + offs);
+    lcd.dataWriteIncrement(codes[0]);
+    if(attrs)
+    {
+      lcd.setAddress(attrBase + offs);
+      lcd.dataWriteIncrement(attribute);
+    }
+  }
+  else
+  {
+    lcd.writeBlock(base + offs, codes, n);
+    if(attrs)
+    {
+      lcd.fill(attrBase + offs, attribute, n);
+    }
+  }
+  col += n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clear
+///  @brief  Blank the screen, move the window back to the start of the ring
+///          and home the cursor
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::clear()
+{
+  uint16_t screen = (uint16_t)rows * cols;
+  top = 0;
+  lcd.fill(base, 0, screen);
+  lcd.setTextHomeAddress(base);
+  if(attrs)
+  {
+    lcd.fill(attrBase, T6963_ATTR_NORMAL, screen);
+    lcd.setGraphicHomeAddress(attrBase);
+  }
+  gotoXY(0, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clearToEol
+///  @brief  Blank from the cursor to the end of the row
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::clearToEol()
+{
+  if(col < cols)
+  {
+    clearCells(row, col, cols - col);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn gotoXY
+///  @brief  Move the cursor.  Out of range values are clamped.
+///  @param[in] c  Column
+///  @param[in] r  Row on screen
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::gotoXY(uint8_t c, uint8_t r)
+{
+  col = (c < cols) ? c : cols - 1;
+  row = (r < rows) ? r : rows - 1;
+  syncCursor();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn syncCursor
+///  @brief  Move the hardware cursor to the cursor cell.  Done once per
+///          write() call rather than per character.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::syncCursor()
+{
+  lcd.setCursor(getColumn(), row);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn copyRows
+///  @brief  Copy visible rows 1 to rows - 1 of one ring to its start
+///  @param[in] ring  RAM address of the ring
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::copyRows(uint16_t ring)
+{
+  uint8_t buf[T6963_TERM_CHUNK];
+  uint16_t src = ring + (uint16_t)(top + 1) * cols;
+  uint16_t len = (uint16_t)(rows - 1) * cols;
+  uint16_t done = 0;
+  while(done < len)
+  {
+    uint16_t n = len - done;
+    if(n > sizeof(buf))
+    {
+      n = sizeof(buf);
+    }
+    lcd.readBlock(src + done, buf, n);
+    lcd.writeBlock(ring + done, buf, n);
+    done += n;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn wrapRing
+///  @brief  The window has reached the end of the ring.  Copy the rows that
+///          stay visible back to the start of the ring and move the window
+///          there.  This is the only time text is copied.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::wrapRing()
+{
+  copyRows(base);
+  if(attrs)
+  {
+    copyRows(attrBase);
+  }
+  top = 0;
+  wraps++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn scrollUp
+///  @brief  Scroll the text up one row.  Normally just the home address
+///          and the newly exposed row are written.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::scrollUp()
+{
+  if(top + rows >= ringRows)
+  {
+    wrapRing();
+  }
+  else
+  {
+    top++;
+  }
+  clearCells(rows - 1, 0, cols);
+  lcd.setTextHomeAddress(getHome());
+  if(attrs)
+  {
+    lcd.setGraphicHomeAddress(attrBase + (uint16_t)top * cols);
+  }
+  scrolls++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn newline
+///  @brief  Move to the start of the next row, scrolling at the bottom
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::newline()
+{
+  col = 0;
+  if(row + 1 >= rows)
+  {
+    scrollUp();
+  }
+  else
+  {
+    row++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn control
+///  @brief  Act on a control character
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::control(uint8_t c)
+{
+  switch(c)
+  {
+    case 8:     // bs
+      col = getColumn();
+      if(col > 0)
+      {
+        col--;
+      }
+      break;
+    case 9:     // tab
+      col = (col | 7) + 1;
+      if(col >= cols)
+      {
+        col = cols - 1;
+      }
+      break;
+    case 10:    // lf
+      newline();
+      break;
+    case 12:    // ff
+      clear();
+      break;
+    case 13:    // cr
+      col = 0;
+      break;
+    case 27:    // esc
+      state = TERM_ESCAPE;
+      break;
+    default:
+      break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn escape
+///  @brief  Character following ESC
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::escape(uint8_t c)
+{
+  state = TERM_TEXT;
+  if(c == '[')
+  {
+    state = TERM_CSI;
+    memset(params, 0, sizeof(params));
+    numParams = 0;
+  }
+  else if(c == 'c')
+  {
+    attribute = T6963_ATTR_NORMAL;
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn param
+///  @return  Parameter i of the sequence, or dflt if missing or zero
+////////////////////////////////////////////////////////////////////////////////
+uint8_t T6963Terminal::param(uint8_t i, uint8_t dflt)
+{
+  uint8_t rtn = dflt;
+  if(i < numParams && params[i] != 0)
+  {
+    rtn = params[i];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn rendition
+///  @brief  Apply one SGR parameter to the current attribute
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::rendition(uint8_t n)
+{
+  uint8_t blink = attribute & T6963_ATTR_BLINK;
+  switch(n)
+  {
+    case 0:
+      attribute = T6963_ATTR_NORMAL;
+      break;
+    case 5:
+      attribute |= T6963_ATTR_BLINK;
+      break;
+    case 7:
+      attribute = blink | T6963_ATTR_REVERSE;
+      break;
+    case 8:
+      attribute = blink | T6963_ATTR_INHIBIT;
+      break;
+    case 25:
+      attribute &= ~T6963_ATTR_BLINK;
+      break;
+    case 27:
+    case 28:
+      attribute = blink;
+      break;
+    default:
+      break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn sequence
+///  @brief  Character of an ESC [ sequence: a parameter digit, a separator
+///          or the final character
+////////////////////////////////////////////////////////////////////////////////
+void T6963Terminal::sequence(uint8_t c)
+{
+  if(c >= '0' && c <= '9')
+  {
+    if(numParams == 0)
+    {
+      numParams = 1;
+    }
+    if(numParams <= T6963_TERM_PARAMS)
+    {
+      uint16_t v = params[numParams - 1] * 10 + (c - '0');
+      params[numParams - 1] = (v > 255) ? 255 : v;
+    }
+  }
+  else if(c == ';')
+  {
+    if(numParams == 0)
+    {
+      numParams = 1;
+    }
+    if(numParams < T6963_TERM_PARAMS)
+    {
+      params[numParams] = 0;
+    }
+    if(numParams <= T6963_TERM_PARAMS)
+    {
+      numParams++;
+    }
+  }
+  else if(c == '?')
+  {
+    // private sequence marker, treated like a plain one
+  }
+  else
+  {
+    uint8_t n = param(0, 1);
+    uint8_t c0 = getColumn();
+    state = TERM_TEXT;
+    if(numParams > T6963_TERM_PARAMS)
+    {
+      numParams = T6963_TERM_PARAMS;
+    }
+    switch(c)
+    {
+      case 'A':
+        gotoXY(c0, (row > n) ? row - n : 0);
+        break;
+      case 'B':
+        gotoXY(c0, (row + n < rows) ? row + n : rows - 1);
+        break;
+      case 'C':
+        gotoXY( (c0 + n < cols) ? c0 + n : cols - 1, row);
+        break;
+      case 'D':
+        gotoXY( (c0 > n) ? c0 - n : 0, row);
+        break;
+      case 'H':
+      case 'f':
+        gotoXY(param(1, 1) - 1, n - 1);
+        break;
+      case 'J':
+        if(param(0, 0) == 2)
+        {
+          clear();
+        }
+        else if(param(0, 0) == 1)
+        {
+          for(uint8_t r = 0; r < row; r++)
+          {
+            clearCells(r, 0, cols);
+          }
+          clearCells(row, 0, c0 + 1);
+        }
+        else
+        {
+          clearToEol();
+          for(uint8_t r = row + 1; r < rows; r++)
+          {
+            clearCells(r, 0, cols);
+          }
+        }
+        break;
+      case 'K':
+        if(param(0, 0) == 2)
+        {
+          clearCells(row, 0, cols);
+        }
+        else if(param(0, 0) == 1)
+        {
+          clearCells(row, 0, c0 + 1);
+        }
+        else
+        {
+          clearToEol();
+        }
+        break;
+      case 'm':
+        rendition(param(0, 0));
+        for(uint8_t i = 1; i < numParams; i++)
+        {
+          rendition(param(i, 0));
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn write
+///  @brief  Write a block of characters.  Each run of printable characters
+///          up to the end of a row is sent as one transfer, and the
+///          hardware cursor is moved once at the end.
+///  @param[in] buf   Characters
+///  @param[in] size  Number of characters
+///  @return  size
+////////////////////////////////////////////////////////////////////////////////
+size_t T6963Terminal::write(const uint8_t* buf, size_t size)
+{
+  size_t i = 0;
+  if(cols != 0)
+  {
+    while(i < size)
+    {
+      uint8_t c = buf[i];
+      if(state == TERM_TEXT && c >= ' ' && c < 0x80)
+      {
+        uint8_t codes[T6963_TERM_CHUNK];
+        uint8_t n = 0;
+        if(col >= cols)
+        {
+          newline();
+        }
+        while(i < size && n < sizeof(codes) && col + n < cols &&
+              buf[i] >= ' ' && buf[i] < 0x80)
+        {
+          codes[n++] = buf[i++] - ' ';   // CG ROM starts at space
+        }
+        putRun(codes, n);
+      }
+      else
+      {
+        if(state == TERM_ESCAPE)
+        {
+          escape(c);
+        }
+        else if(state == TERM_CSI)
+        {
+          sequence(c);
+        }
+        else
+        {
+          control(c);
+        }
+        i++;
+      }
+    }
+    syncCursor();
+  }
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn write
+///  @brief  Write one character
+///  @return  1 if written, 0 before begin()
+////////////////////////////////////////////////////////////////////////////////
+size_t T6963Terminal::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pump
+///  @brief  Copy whatever a stream has available to the screen, a chunk at
+///          a time so printable runs are batched
+///  @param[in] in  The stream, e.g. Serial
+///  @return  Number of characters written
+////////////////////////////////////////////////////////////////////////////////
+size_t T6963Terminal::pump(Stream& in)
+{
+  uint8_t buf[T6963_TERM_CHUNK];
+  size_t rtn = 0;
+  int avail;
+  while( (avail = in.available()) > 0)
+  {
+    uint8_t n = 0;
+    while(n < sizeof(buf) && avail-- > 0)
+    {
+      buf[n++] = in.read();
+    }
+    rtn += write(buf, n);
+  }
+  return rtn;
+}
@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_term.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief VT100 subset text terminal with hardware scrolling
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_TERM_H
+#define T6963_TERM_H
+
+#include "T6963.h"
+
+// Bytes moved per block transfer, and longest printable run batched
+#ifndef T6963_TERM_CHUNK
+#define T6963_TERM_CHUNK                 40
+#endif
+
+// Numeric parameters kept from one escape sequence.  Further ones are
+// parsed and dropped.
+#ifndef T6963_TERM_PARAMS
+#define T6963_TERM_PARAMS                 8
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Terminal
+/// @brief Streaming text output with hardware scrolling.  The visible rows
+///        are a window into a ring of text rows in VRAM; scrolling moves the
+///        text home address down one row and clears only the newly exposed
+///        row.  VRAM is copied only when the window reaches the end of the
+///        ring.  Runs of printable characters go out as one auto write.
+///
+///        Understands BS, TAB, LF, FF, CR and these escape sequences:
+///          ESC c                 reset
+///          ESC [ n A/B/C/D       cursor up/down/right/left
+///          ESC [ r ; c H  (or f) cursor position, 1 based
+///          ESC [ n J             clear to end (0), to start (1), screen (2)
+///          ESC [ n K             clear to end (0), to start (1), line (2)
+///          ESC [ n ; ... m       0 normal, 5 blink, 7 reverse, 8 hidden,
+///                                25/27/28 turn them off, applied in order
+///        Blink, reverse and hidden need an attribute ring, see
+///        setAttributeBase(); without one they are ignored.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Terminal : public Print
+{
+  public:
+    T6963Terminal(T6963& lcd, uint16_t base, uint16_t ringSize, uint8_t rows = 8);
+    void setAttributeBase(uint16_t addr);
+    bool begin();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buf, size_t size);
+    using Print::write;
+    size_t pump(Stream& in);
+
+    void newline();
+    void scrollUp();
+    void clear();
+    void clearToEol();
+    void gotoXY(uint8_t col, uint8_t row);
+    void setAttribute(uint8_t attr) { attribute = attr; }
+
+    uint16_t cellAddress(uint8_t col, uint8_t row);
+    uint16_t getHome() { return base + (uint16_t)top * cols; }
+    uint8_t getAttribute() { return attribute; }
+    uint8_t getColumn() { return (col < cols) ? col : cols - 1; }
+    uint8_t getRow() { return row; }
+    uint32_t getScrolls() { return scrolls; }
+    uint32_t getWraps() { return wraps; }
+
+  private:
+    void control(uint8_t c);
+    void escape(uint8_t c);
+    void sequence(uint8_t c);
+    void rendition(uint8_t n);
+    void putRun(const uint8_t* codes, uint8_t n);
+    void clearCells(uint8_t r, uint8_t c, uint8_t n);
+    void copyRows(uint16_t ring);
+    void wrapRing();
+    void syncCursor();
+    uint8_t param(uint8_t i, uint8_t dflt);
+
+    T6963& lcd;
+    uint16_t base;        // first byte of the text ring
+    uint16_t attrBase;    // first byte of the attribute ring
+    bool attrs;           // attribute ring in use
+    uint16_t ringSize;    // bytes available for each ring
+    uint8_t cols;         // text area width
+    uint8_t rows;         // visible rows
+    uint8_t ringRows;     // rows the ring holds
+    uint8_t top;          // ring row shown at the top of the screen
+    uint8_t col;          // cursor column, cols = wrap before next char
+    uint8_t row;          // cursor row on screen
+    uint8_t attribute;    // T6963_ATTR_* written with each character
+    uint8_t state;        // escape parser state
+    uint8_t params[T6963_TERM_PARAMS];
+    uint8_t numParams;
+    uint32_t scrolls;
+    uint32_t wraps;
+};
+
+#endif
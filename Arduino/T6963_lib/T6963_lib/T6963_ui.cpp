@@ -0,0 +1,440 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_ui.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Retained widgets redrawn only when invalidated
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_ui.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn add
+///  @brief  Append a child widget.  A widget belongs to one group only.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Group::add(T6963Widget& w)
+{
+  T6963Widget** p = &first;
+  while(*p != NULL)
+  {
+    p = &(*p)->next;
+  }
+  w.next = NULL;
+  *p = &w;
+  invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Write the text and pad the rest of the field with spaces
+////////////////////////////////////////////////////////////////////////////////
+void T6963Label::draw(T6963Ui& ui)
+{
+  const char* s = text;
+  for(uint8_t i = 0; i < width; i++)
+  {
+    uint8_t c = 0;
+    if(s != NULL && *s != 0)
+    {
+      c = (uint8_t)(*s++ - 32);
+    }
+    ui.getShadow().writeText(col + i, row, c);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Number
+///  @brief  Constructor
+///  @param[in] col, row  Text cell of the left end of the field
+///  @param[in] width     Field width in characters
+///  @param[in] decimals  Digits after the point, 0 for an integer
+////////////////////////////////////////////////////////////////////////////////
+T6963Number::T6963Number(uint8_t col, uint8_t row, uint8_t width, uint8_t decimals)
+  : col(col), row(row), width(width), decimals(decimals), value(0)
+{
+  if(this->width > T6963_UI_NUMBER_MAX)
+  {
+    this->width = T6963_UI_NUMBER_MAX;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setValue
+///  @brief  Set the value, in units of the last decimal shown
+////////////////////////////////////////////////////////////////////////////////
+void T6963Number::setValue(int32_t v)
+{
+  if(v != value)
+  {
+    value = v;
+    invalidate();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Format the value right to left into the field
+////////////////////////////////////////////////////////////////////////////////
+void T6963Number::draw(T6963Ui& ui)
+{
+  char buf[T6963_UI_NUMBER_MAX];
+  uint32_t m = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+  uint8_t digits = 0;
+  int8_t pos = width;
+  memset(buf, ' ', sizeof(buf));
+  do
+  {
+    if(decimals != 0 && digits == decimals && pos > 0)
+    {
+      buf[--pos] = '.';
+    }
+    if(pos > 0)
+    {
+      buf[--pos] = '0' + m % 10;
+    }
+    else
+    {
+      pos = -1;
+    }
+    m /= 10;
+    digits++;
+  } while(pos >= 0 && (m != 0 || digits <= decimals));
+  if(value < 0 && pos > 0)
+  {
+    buf[--pos] = '-';
+  }
+  else if(value < 0)
+  {
+    pos = -1;
+  }
+  for(uint8_t i = 0; i < width; i++)
+  {
+    char c = (pos < 0) ? '*' : buf[i];
+    ui.getShadow().writeText(col + i, row, (uint8_t)(c - 32));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Bar
+///  @brief  Constructor
+///  @param[in] x, y      Top left pixel of the frame
+///  @param[in] w, h      Size of the frame in pixels (at least 3 by 3)
+///  @param[in] min, max  Values for an empty and a full bar
+////////////////////////////////////////////////////////////////////////////////
+T6963Bar::T6963Bar(uint8_t x, uint8_t y, uint8_t w, uint8_t h, int16_t min, int16_t max)
+  : x(x), y(y), w(w < 3 ? 3 : w), h(h < 3 ? 3 : h), min(min), max(max > min ? max : min + 1),
+    fill(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setValue
+///  @brief  Set the value, clamped to min..max.  The bar is invalidated
+///          only if its length in pixels changes.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Bar::setValue(int16_t v)
+{
+  uint8_t f;
+  if(v < min)
+  {
+    v = min;
+  }
+  if(v > max)
+  {
+    v = max;
+  }
+  f = (int32_t)(v - min) * (w - 2) / (max - min);
+  if(f != fill)
+  {
+    fill = f;
+    invalidate();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Frame, filled part and empty part
+////////////////////////////////////////////////////////////////////////////////
+void T6963Bar::draw(T6963Ui& ui)
+{
+  T6963Graphics& gfx = ui.getGraphics();
+  gfx.rect(x, y, w, h, 1);
+  gfx.fillRect(x + 1, y + 1, fill, h - 2, 1);
+  gfx.fillRect(x + 1 + fill, y + 1, w - 2 - fill, h - 2, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Sparkline
+///  @brief  Constructor
+///  @param[in] x, y      Top left pixel
+///  @param[in] w, h      Size in pixels; one sample per pixel column, up to
+///                       T6963_UI_SPARK_MAX
+///  @param[in] min, max  Values at the bottom and top
+////////////////////////////////////////////////////////////////////////////////
+T6963Sparkline::T6963Sparkline(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                               int16_t min, int16_t max)
+  : x(x), y(y), w(w > T6963_UI_SPARK_MAX ? T6963_UI_SPARK_MAX : w), h(h == 0 ? 1 : h),
+    min(min), max(max > min ? max : min + 1), count(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn push
+///  @brief  Add the newest sample, dropping the oldest once full
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sparkline::push(int16_t v)
+{
+  if(v < min)
+  {
+    v = min;
+  }
+  if(v > max)
+  {
+    v = max;
+  }
+  if(count == w && count != 0)
+  {
+    memmove(samples, samples + 1, count - 1);
+    count--;
+  }
+  samples[count++] = (h - 1) - (int32_t)(v - min) * (h - 1) / (max - min);
+  invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Clear the box and join the samples, right aligned
+////////////////////////////////////////////////////////////////////////////////
+void T6963Sparkline::draw(T6963Ui& ui)
+{
+  T6963Graphics& gfx = ui.getGraphics();
+  uint8_t left = x + w - count;
+  gfx.fillRect(x, y, w, h, 0);
+  for(uint8_t i = 0; i < count; i++)
+  {
+    if(i == 0)
+    {
+      gfx.pixel(left, y + samples[0], 1);
+    }
+    else
+    {
+      gfx.line(left + i - 1, y + samples[i - 1], left + i, y + samples[i], 1);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setBitmap_P
+///  @brief  Show another bitmap of the same size, NULL for none
+////////////////////////////////////////////////////////////////////////////////
+void T6963Icon::setBitmap_P(const uint8_t* bits)
+{
+  if(bits != this->bits)
+  {
+    this->bits = bits;
+    invalidate();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Blit the bitmap, or clear its box if there is none
+////////////////////////////////////////////////////////////////////////////////
+void T6963Icon::draw(T6963Ui& ui)
+{
+  if(bits != NULL)
+  {
+    ui.getGraphics().bitmap_P(x, y, bits, w, h);
+  }
+  else
+  {
+    ui.getGraphics().fillRect(x, y, w, h, 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Menu
+///  @brief  Constructor
+///  @param[in] col, row  Text cell of the top left of the menu
+///  @param[in] width     Width in characters
+///  @param[in] rows      Items shown at once
+////////////////////////////////////////////////////////////////////////////////
+T6963Menu::T6963Menu(uint8_t col, uint8_t row, uint8_t width, uint8_t rows)
+  : col(col), row(row), width(width), rows(rows), items(NULL), count(0), selected(0),
+    top(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setItems
+///  @brief  Show a list of strings and select the first
+////////////////////////////////////////////////////////////////////////////////
+void T6963Menu::setItems(const char* const* items, uint8_t count)
+{
+  this->items = items;
+  this->count = (items != NULL) ? count : 0;
+  selected = 0;
+  top = 0;
+  invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn select
+///  @brief  Select item i, scrolling it into view
+////////////////////////////////////////////////////////////////////////////////
+void T6963Menu::select(uint8_t i)
+{
+  if(i < count && i != selected)
+  {
+    selected = i;
+    if(selected < top)
+    {
+      top = selected;
+    }
+    else if(selected >= top + rows)
+    {
+      top = selected - rows + 1;
+    }
+    invalidate();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn draw
+///  @brief  Write the visible items and mark the selection
+////////////////////////////////////////////////////////////////////////////////
+void T6963Menu::draw(T6963Ui& ui)
+{
+  bool reverse = ui.hasAttributes();
+  for(uint8_t r = 0; r < rows; r++)
+  {
+    uint8_t i = top + r;
+    const char* s = (i < count) ? items[i] : NULL;
+    for(uint8_t k = 0; k < width; k++)
+    {
+      uint8_t c = 0;
+      if(k == 0 && !reverse)
+      {
+        c = (i == selected && s != NULL) ? '>' - 32 : 0;
+      }
+      else if(s != NULL && *s != 0)
+      {
+        c = (uint8_t)(*s++ - 32);
+      }
+      ui.getShadow().writeText(col + k, row + r, c);
+    }
+    if(reverse)
+    {
+      ui.setAttribute(col, row + r, width,
+                      (i == selected && s != NULL) ? T6963_ATTR_REVERSE : T6963_ATTR_NORMAL);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Ui
+///  @brief  Constructor
+///  @param[in] shadow  Shadow the widgets draw into; at least the text
+///                     plane must be shadowed
+///  @param[in] gfx     Graphics for the graphic widgets, normally with
+///                     setFramebuffer(&shadow) so they are counted and
+///                     merged too
+///  @param[in] attrs   Attribute plane for menus in text attribute mode,
+///                     or NULL
+////////////////////////////////////////////////////////////////////////////////
+T6963Ui::T6963Ui(T6963Shadow& shadow, T6963Graphics& gfx, T6963Attributes* attrs)
+  : shadow(shadow), gfx(gfx), attrs(attrs), root(NULL), attrBytes(0)
+{
+  resetCounters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetCounters
+///  @brief  Zero the byte and render counters
+////////////////////////////////////////////////////////////////////////////////
+void T6963Ui::resetCounters()
+{
+  lastBytes = 0;
+  lastDrawn = 0;
+  totalBytes = 0;
+  renders = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setScreen
+///  @brief  Show another widget tree.  The shadow is blanked and the whole
+///          tree drawn on the next render, so only the cells the two
+///          screens do not share are sent.
+///  @param[in] root  Usually a T6963Group
+////////////////////////////////////////////////////////////////////////////////
+void T6963Ui::setScreen(T6963Widget* root)
+{
+  this->root = root;
+  shadow.fillText(0);
+  shadow.fillGraphic(0);
+  if(attrs != NULL)
+  {
+    attrs->clear();
+  }
+  if(root != NULL)
+  {
+    root->invalidate();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setAttribute
+///  @brief  Set the attribute of a run of text cells, writing only if one
+///          of them differs.  The bytes are counted by the next render,
+///          whether this is called from a widget or between renders.
+////////////////////////////////////////////////////////////////////////////////
+void T6963Ui::setAttribute(uint8_t col, uint8_t row, uint8_t len, uint8_t attr)
+{
+  bool same = true;
+  for(uint8_t i = 0; i < len && same && attrs != NULL; i++)
+  {
+    same = (attrs->get(col + i, row) == attr);
+  }
+  if(!same && attrs->set(col, row, len, attr))
+  {
+    attrBytes += len;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn renderList
+///  @brief  Draw the invalid widgets of a sibling list and their children
+///  @param[in] w      First sibling
+///  @param[in] force  Draw every widget (the parent was invalid)
+////////////////////////////////////////////////////////////////////////////////
+void T6963Ui::renderList(T6963Widget* w, bool force)
+{
+  while(w != NULL)
+  {
+    bool redraw = force || w->dirty;
+    if(redraw)
+    {
+      w->draw(*this);
+      w->dirty = false;
+      lastDrawn++;
+    }
+    renderList(w->children(), redraw);
+    w = w->next;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn render
+///  @brief  Draw every invalid widget into the shadow, then flush it.  Call
+///          once per UI tick after updating widget values.
+///  @return  Data bytes sent to the display for this tick
+////////////////////////////////////////////////////////////////////////////////
+uint16_t T6963Ui::render()
+{
+  lastDrawn = 0;
+  renderList(root, false);
+  lastBytes = shadow.flush() + attrBytes;
+  attrBytes = 0;
+  totalBytes += lastBytes;
+  renders++;
+  return lastBytes;
+}
@@ -0,0 +1,260 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_ui.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Retained widgets redrawn only when invalidated
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_UI_H
+#define T6963_UI_H
+
+#include "T6963.h"
+#include "T6963_shadow.h"
+#include "T6963_gfx.h"
+#include "T6963_attr.h"
+
+// Widest numeric field, in characters
+#ifndef T6963_UI_NUMBER_MAX
+#define T6963_UI_NUMBER_MAX              12
+#endif
+
+// Most samples a sparkline keeps (one per pixel column)
+#ifndef T6963_UI_SPARK_MAX
+#define T6963_UI_SPARK_MAX               64
+#endif
+
+class T6963Ui;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Widget
+/// @brief Base of everything T6963Ui draws.  Setters call invalidate()
+///        only when what the widget shows changes; the next render()
+///        calls draw() for invalid widgets and nothing else.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Widget
+{
+  public:
+    T6963Widget() : next(NULL), dirty(true) {}
+    virtual ~T6963Widget() {}
+    virtual void draw(T6963Ui& ui) = 0;
+    virtual T6963Widget* children() { return NULL; }
+    void invalidate() { dirty = true; }
+    bool isDirty() { return dirty; }
+
+  private:
+    friend class T6963Ui;
+    friend class T6963Group;
+    T6963Widget* next;    // next sibling
+    bool dirty;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Group
+/// @brief Holds child widgets, e.g. one screen.  Invalidating the group
+///        redraws every child.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Group : public T6963Widget
+{
+  public:
+    T6963Group() : first(NULL) {}
+    void add(T6963Widget& w);
+    void draw(T6963Ui&) {}
+    T6963Widget* children() { return first; }
+
+  private:
+    T6963Widget* first;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Label
+/// @brief A string in a fixed run of text cells, padded with spaces.  The
+///        string is not copied: call setText again after changing it.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Label : public T6963Widget
+{
+  public:
+    T6963Label(uint8_t col, uint8_t row, uint8_t width, const char* text = NULL)
+      : col(col), row(row), width(width), text(text) {}
+    void setText(const char* text) { this->text = text; invalidate(); }
+    void draw(T6963Ui& ui);
+
+  private:
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;
+    const char* text;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Number
+/// @brief A right aligned fixed point number in text cells.  A value too
+///        wide for the field shows as stars.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Number : public T6963Widget
+{
+  public:
+    T6963Number(uint8_t col, uint8_t row, uint8_t width, uint8_t decimals = 0);
+    void setValue(int32_t v);
+    int32_t getValue() { return value; }
+    void draw(T6963Ui& ui);
+
+  private:
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;
+    uint8_t decimals;     // digits after the point
+    int32_t value;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Bar
+/// @brief A horizontal bar graph in pixels with a one pixel frame.  Only
+///        the bytes where the bar grew or shrank differ in the shadow,
+///        so only they are sent.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Bar : public T6963Widget
+{
+  public:
+    T6963Bar(uint8_t x, uint8_t y, uint8_t w, uint8_t h, int16_t min, int16_t max);
+    void setValue(int16_t v);
+    void draw(T6963Ui& ui);
+
+  private:
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+    int16_t min;
+    int16_t max;
+    uint8_t fill;         // pixels of bar inside the frame
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Sparkline
+/// @brief A scrolling trend line, newest sample at the right
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Sparkline : public T6963Widget
+{
+  public:
+    T6963Sparkline(uint8_t x, uint8_t y, uint8_t w, uint8_t h, int16_t min, int16_t max);
+    void push(int16_t v);
+    void draw(T6963Ui& ui);
+
+  private:
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+    int16_t min;
+    int16_t max;
+    uint8_t samples[T6963_UI_SPARK_MAX];   // pixel rows from the top, oldest first
+    uint8_t count;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Icon
+/// @brief A PROGMEM bitmap, rows (w + 7) / 8 bytes, MSB leftmost
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Icon : public T6963Widget
+{
+  public:
+    T6963Icon(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint8_t* bits = NULL)
+      : x(x), y(y), w(w), h(h), bits(bits) {}
+    void setBitmap_P(const uint8_t* bits);
+    void draw(T6963Ui& ui);
+
+  private:
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+    const uint8_t* bits;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Menu
+/// @brief A list of items in text rows that scrolls to keep the selection
+///        in view.  The selection is shown reversed when the renderer has
+///        attributes, otherwise with a '>' in the first column.
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Menu : public T6963Widget
+{
+  public:
+    T6963Menu(uint8_t col, uint8_t row, uint8_t width, uint8_t rows);
+    void setItems(const char* const* items, uint8_t count);
+    void select(uint8_t i);
+    void next() { select(selected + 1 < count ? selected + 1 : 0); }
+    void prev() { select(selected > 0 ? selected - 1 : count - 1); }
+    uint8_t getSelected() { return selected; }
+    void draw(T6963Ui& ui);
+
+  private:
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;
+    uint8_t rows;         // visible rows
+    const char* const* items;
+    uint8_t count;
+    uint8_t selected;
+    uint8_t top;          // first item shown
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Ui
+/// @brief Renders a widget tree.  Widgets draw into a T6963Shadow (text
+///        directly, graphics through a T6963Graphics attached to the same
+///        shadow) and render() flushes the shadow, so the changes of all
+///        widgets drawn in one tick go out as merged row bursts and bytes
+///        that did not change are not sent.  Attribute changes are made
+///        through setAttribute and counted with the rest.
+///
+///        Graphic widgets and attrs are mutually exclusive.  In text
+///        attribute mode the graphic area is the attribute plane, so a
+///        T6963Bar, T6963Sparkline or T6963Icon would draw over the
+///        attributes; with attrs, use text widgets and menus only.
+///
+///        Runs anywhere the T6963 class does, including on a PC against
+///        T6963Emulator (see tools/t6963_ui).
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Ui
+{
+  public:
+    T6963Ui(T6963Shadow& shadow, T6963Graphics& gfx, T6963Attributes* attrs = NULL);
+    void setScreen(T6963Widget* root);
+    uint16_t render();
+
+    T6963Shadow& getShadow() { return shadow; }
+    T6963Graphics& getGraphics() { return gfx; }
+    bool hasAttributes() { return attrs != NULL; }
+    void setAttribute(uint8_t col, uint8_t row, uint8_t len, uint8_t attr);
+
+    uint16_t getLastBytes() { return lastBytes; }
+    uint8_t getLastDrawn() { return lastDrawn; }
+    uint32_t getTotalBytes() { return totalBytes; }
+    uint32_t getRenders() { return renders; }
+    void resetCounters();
+
+  private:
+    void renderList(T6963Widget* w, bool force);
+
+    T6963Shadow& shadow;
+    T6963Graphics& gfx;
+    T6963Attributes* attrs;
+    T6963Widget* root;
+    uint16_t attrBytes;   // attribute bytes written since the last render
+    uint16_t lastBytes;   // data bytes sent by the last render
+    uint8_t lastDrawn;    // widgets drawn by the last render
+    uint32_t totalBytes;
+    uint32_t renders;
+};
+
+#endif
@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file T6963_vram.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Display RAM allocator
+//////////////////////////////////////////////////////////////////////////////
+
+#include "T6963_vram.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn T6963Vram
+///  @brief  Constructor
+///  @param[in] size  Bytes of display RAM on the panel
+////////////////////////////////////////////////////////////////////////////////
+T6963Vram::T6963Vram(uint16_t size)
+  : ramSize(size), next(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn alloc
+///  @brief  Reserve the next len bytes, starting on a multiple of align
+///  @param[in]  len    Bytes wanted
+///  @param[out] addr   RAM address of the region
+///  @param[in]  align  Start address granularity, e.g. 2048 for CG RAM
+///  @return  True if the region fits, false otherwise (nothing reserved)
+////////////////////////////////////////////////////////////////////////////////
+bool T6963Vram::alloc(uint16_t len, uint16_t& addr, uint16_t align)
+{
+  bool rtn = false;
+  uint32_t start = next;
+  if(align > 1)
+  {
+    start = (start + align - 1) / align * align;
+  }
+  if(start + len <= ramSize)
+  {
+    addr = start;
+    next = start + len;
+    rtn = true;
+  }
+  return rtn;
+}
@@ -0,0 +1,44 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file T6963_vram.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Display RAM allocator
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_VRAM_H
+#define T6963_VRAM_H
+
+#include "T6963.h"
+
+// Display RAM on the panel (DG-24064 has 8K)
+#ifndef T6963_RAM_SIZE
+#define T6963_RAM_SIZE                 8192
+#endif
+
+// Most pages per plane for page flipping
+#ifndef T6963_MAX_PAGES
+#define T6963_MAX_PAGES                   4
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class T6963Vram
+/// @brief Hands out regions of display RAM from the bottom up and refuses
+///        any region that would run past the end of the RAM
+//////////////////////////////////////////////////////////////////////////////
+
+class T6963Vram
+{
+  public:
+    T6963Vram(uint16_t size = T6963_RAM_SIZE);
+    bool alloc(uint16_t len, uint16_t& addr, uint16_t align = 1);
+    void reset() { next = 0; }
+    uint16_t size() { return ramSize; }
+    uint16_t used() { return next; }
+    uint16_t remaining() { return ramSize - next; }
+
+  private:
+    uint16_t ramSize;
+    uint16_t next;        // first free byte
+};
+
+#endif
@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_block.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Count the bus cycles of writeBlock / readBlock against the
+///        dataWriteIncrement / dataReadIncrement loops they replace, on the
+///        emulator, and check both paths move the same bytes.  Build from
+///        the top of the repository with
+///
+///   g++ -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_block/t6963_block.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp -o t6963_block
+///
+///        Bus cycles are every status read, data byte and command the
+///        controller sees.  Exits non-zero if RAM or a read differs.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "T6963_emu.h"
+
+#define BASE                         0x0400
+
+static const uint16_t sizes[] = { 1, 8, 40, 320, 2560, 7168 };
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main()
+{
+  int rtn = 0;
+  static uint8_t data[8192];
+  static uint8_t back[8192];
+  for(size_t i = 0; i < sizeof(data); i++)
+  {
+    data[i] = (i * 37) ^ (i >> 8);
+  }
+
+  T6963Emulator emu;
+  T6963 lcd(emu);
+  lcd.ports_init();
+
+  printf("%6s  %21s  %21s  %21s  %21s\n", "",
+         "dataWriteIncrement", "writeBlock", "dataReadIncrement", "readBlock");
+  printf("%6s  %10s %10s  %10s %10s  %10s %10s  %10s %10s\n", "bytes",
+         "cycles", "per byte", "cycles", "per byte", "cycles", "per byte", "cycles", "per byte");
+  for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    uint16_t n = sizes[s];
+    unsigned long cycles[4];
+    unsigned long bad = 0;
+
+    // One address set, then one data byte and one command per byte
+    lcd.invalidateCache();
+    emu.resetCounters();
+    lcd.setAddress(BASE);
+    for(uint16_t i = 0; i < n; i++)
+    {
+      lcd.dataWriteIncrement(data[i]);
+    }
+    cycles[0] = emu.counters.busCycles;
+    for(uint16_t i = 0; i < n; i++)
+    {
+      bad += (emu.ram(BASE + i) != data[i]);
+      emu.ram(BASE + i, 0);
+    }
+
+    lcd.invalidateCache();
+    emu.resetCounters();
+    lcd.writeBlock(BASE, data, n);
+    cycles[1] = emu.counters.busCycles;
+    for(uint16_t i = 0; i < n; i++)
+    {
+      bad += (emu.ram(BASE + i) != data[i]);
+    }
+
+    lcd.invalidateCache();
+    emu.resetCounters();
+    lcd.setAddress(BASE);
+    for(uint16_t i = 0; i < n; i++)
+    {
+      back[i] = lcd.dataReadIncrement();
+    }
+    cycles[2] = emu.counters.busCycles;
+    for(uint16_t i = 0; i < n; i++)
+    {
+      bad += (back[i] != data[i]);
+      back[i] = 0;
+    }
+
+    lcd.invalidateCache();
+    emu.resetCounters();
+    lcd.readBlock(BASE, back, n);
+    cycles[3] = emu.counters.busCycles;
+    for(uint16_t i = 0; i < n; i++)
+    {
+      bad += (back[i] != data[i]);
+    }
+
+    printf("%6u", n);
+    for(int k = 0; k < 4; k++)
+    {
+      printf("  %10lu %10.2f", cycles[k], (double)cycles[k] / n);
+    }
+    printf("%s\n", bad == 0 ? "" : "  FAIL");
+    if(bad != 0 || emu.counters.errors != 0)
+    {
+      rtn = 1;
+    }
+  }
+  printf("%s\n", rtn == 0 ? "PASS" : "FAIL");
+  return rtn;
+}
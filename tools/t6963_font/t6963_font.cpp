@@ -0,0 +1,282 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_font.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Text against a reference rasteriser on the emulator
+///        and measure glyphs per second.  A random proportional font
+///        (glyphs up to 20x14, some wider than the row cache) is drawn
+///        with drawText through a T6963Shadow and with printLine, at
+///        random positions and in both colours, with 6 and 8 pixel bytes.
+///        Build from the top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_font/t6963_font.cpp Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_font.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_shadow.cpp -o t6963_font
+///
+///        Usage: t6963_font [-n lines] [-u us]
+///          -n  lines of 30 glyphs to time per path (default 2000)
+///          -u  microseconds per bus cycle on the target (default 2)
+///        Prints bus cycles per glyph, host glyphs per second and the
+///        glyphs per second the bus allows at -u microseconds per cycle.
+///        Exits non-zero if any pixel differs from the reference.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "T6963_emu.h"
+#include "T6963_font.h"
+
+#define WIDTH                           240
+#define HEIGHT                           64
+#define FIRST                            32
+#define LAST                            126
+#define GLYPHS                  (LAST - FIRST + 1)
+#define MAX_W                            20
+#define MAX_H                            14
+#define Y_ADVANCE                        16
+
+static uint8_t bitmap[GLYPHS * MAX_W * MAX_H / 8 + GLYPHS];
+static T6963Glyph glyphs[GLYPHS];
+static const T6963Font font = { bitmap, glyphs, FIRST, LAST, Y_ADVANCE };
+static uint8_t pixels[GLYPHS][MAX_H][MAX_W];   // the glyphs, unpacked
+static uint8_t model[HEIGHT][WIDTH];
+static int ascent;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn makeFont
+///  @brief  Random glyph sizes, offsets and pixels, bit packed as
+///          Adafruit GFX packs them
+////////////////////////////////////////////////////////////////////////////////
+static void makeFont()
+{
+  uint32_t bit = 0;
+  srand(5);
+  memset(bitmap, 0, sizeof(bitmap));
+  ascent = 0;
+  for(int i = 0; i < GLYPHS; i++)
+  {
+    T6963Glyph& g = glyphs[i];
+    g.width = 1 + rand() % MAX_W;
+    g.height = 1 + rand() % MAX_H;
+    g.xAdvance = g.width + 1;
+    g.xOffset = rand() % 3 - 1;
+    g.yOffset = -(rand() % 13);
+    bit = (bit + 7) & ~7;
+    g.bitmapOffset = bit / 8;
+    ascent = (-g.yOffset > ascent) ? -g.yOffset : ascent;
+    for(int r = 0; r < g.height; r++)
+    {
+      for(int c = 0; c < g.width; c++)
+      {
+        pixels[i][r][c] = rand() % 2;
+        if(pixels[i][r][c])
+        {
+          bitmap[bit / 8] |= 0x80 >> (bit % 8);
+        }
+        bit++;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn modelText
+///  @brief  Rasterise a string into the model, clipped to rows top to
+///          bottom - 1.  Like T6963Text, stop at the first glyph whose
+///          origin is off the right edge.
+///  @return  x after the last glyph drawn
+////////////////////////////////////////////////////////////////////////////////
+static int modelText(int x, int y, const char* str, uint8_t color, int top, int bottom)
+{
+  for(const char* p = str; *p != '\0' && x < WIDTH; p++)
+  {
+    if(*p >= FIRST && *p <= LAST)
+    {
+      int i = *p - FIRST;
+      const T6963Glyph& g = glyphs[i];
+      for(int r = 0; r < g.height; r++)
+      {
+        for(int c = 0; c < g.width; c++)
+        {
+          int px = x + g.xOffset + c;
+          int py = y + g.yOffset + r;
+          if(pixels[i][r][c] && px >= 0 && px < WIDTH && py >= top && py < bottom)
+          {
+            model[py][px] = (color != 0);
+          }
+        }
+      }
+      x += g.xAdvance;
+    }
+  }
+  return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn randomText
+///  @brief  A random printable string of up to n - 1 characters
+////////////////////////////////////////////////////////////////////////////////
+static void randomText(char* str, int n)
+{
+  int len = rand() % n;
+  for(int i = 0; i < len; i++)
+  {
+    str[i] = FIRST + rand() % GLYPHS;
+  }
+  str[len] = '\0';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn compare
+///  @return  Pixels of graphic RAM that differ from the model
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long compare(T6963Emulator& emu, uint8_t fw)
+{
+  unsigned long rtn = 0;
+  for(int y = 0; y < HEIGHT; y++)
+  {
+    for(int x = 0; x < WIDTH; x++)
+    {
+      uint8_t d = emu.ram(y * (WIDTH / fw) + x / fw);
+      rtn += ( (d >> (fw - 1 - x % fw)) & 1) != model[y][x];
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn seconds
+///  @return  Monotonic time in seconds
+////////////////////////////////////////////////////////////////////////////////
+static double seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  static const char line[] = "The quick brown fox jumps over";
+  int rtn = 0;
+  int count = 2000;
+  double usPerCycle = 2;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      count = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-u") == 0 && i + 1 < argc)
+    {
+      usPerCycle = atof(argv[++i]);
+    }
+  }
+  makeFont();
+
+  printf("%4s %-10s %10s %10s %12s %12s %8s\n", "font", "path", "glyphs",
+         "cycles/gl", "host gl/s", "bus gl/s", "pixels");
+  for(uint8_t fw = 6; fw <= 8; fw += 2)
+  {
+    static uint8_t graphicBuf[(WIDTH / 6) * HEIGHT];
+    static uint8_t lineBuf[(WIDTH / 6) * Y_ADVANCE];
+    T6963Emulator emu(WIDTH / fw, HEIGHT, fw);
+    T6963 lcd(emu);
+    lcd.ports_init();
+    lcd.setFontWidth(fw);
+    lcd.setGraphicHomeAddress(0);
+    lcd.setGraphicArea(WIDTH / fw);
+    lcd.setDisplayMode(0, 1);
+    lcd.clearGraphic();
+    T6963Shadow shadow(lcd, HEIGHT);
+    memset(graphicBuf, 0, sizeof(graphicBuf));
+    shadow.begin(NULL, graphicBuf);
+    T6963Text text(lcd, WIDTH, HEIGHT);
+    text.setFont(&font);
+    text.setFramebuffer(&shadow);
+    text.setLineBuffer(lineBuf, sizeof(lineBuf));
+    memset(model, 0, sizeof(model));
+    if(text.ascent() != ascent || text.lineHeight() != Y_ADVANCE)
+    {
+      printf("ascent %u, expected %d\n", text.ascent(), ascent);
+      rtn = 1;
+    }
+
+    // Random strings through both paths, compared after each one
+    unsigned long bad[2] = { 0, 0 };
+    char str[40];
+    srand(fw);
+    for(int i = 0; i < 400; i++)
+    {
+      uint8_t color = rand() % 2;
+      int x = rand() % (WIDTH + 40) - 30;
+      int endX;
+      randomText(str, sizeof(str));
+      if(i % 2 == 0)
+      {
+        int y = rand() % (HEIGHT + 20) - 5;
+        endX = text.drawText(x, y, str, color);
+        shadow.flush();
+        bad[0] += (modelText(x, y, str, color, 0, HEIGHT) != endX);
+        bad[0] += compare(emu, fw);
+      }
+      else
+      {
+        int top = rand() % HEIGHT;
+        int bottom = (top + Y_ADVANCE > HEIGHT) ? HEIGHT : top + Y_ADVANCE;
+        endX = text.printLine(top, x, str, color);
+        for(int y = top; y < bottom; y++)
+        {
+          memset(model[y], color ? 0 : 1, WIDTH);
+        }
+        bad[1] += (modelText(x, top + ascent, str, color, top, bottom) != endX);
+        bad[1] += compare(emu, fw);
+      }
+    }
+
+    // Throughput: one 30 glyph line per call
+    for(int path = 0; path < 2; path++)
+    {
+      unsigned long glyphsDrawn = 0;
+      emu.resetCounters();
+      double start = seconds();
+      for(int i = 0; i < count; i++)
+      {
+        if(path == 0)
+        {
+          text.drawText(0, ascent + (i % 4) * Y_ADVANCE, line, i & 1);
+          shadow.flush();
+        }
+        else
+        {
+          text.printLine( (i % 4) * Y_ADVANCE, 0, line, i & 1);
+        }
+        glyphsDrawn += sizeof(line) - 1;
+      }
+      double host = seconds() - start;
+      printf("%4u %-10s %10lu %10.1f %12.0f %12.0f %8s\n", fw,
+             path == 0 ? "drawText" : "printLine", glyphsDrawn,
+             (double)emu.counters.busCycles / glyphsDrawn, glyphsDrawn / host,
+             glyphsDrawn / (emu.counters.busCycles * usPerCycle * 1e-6),
+             bad[path] == 0 ? "ok" : "FAIL");
+      if(bad[path] != 0)
+      {
+        rtn = 1;
+      }
+    }
+    printf("%4u glyph row cache: %lu hits, %lu misses\n", fw,
+           (unsigned long)text.getCacheHits(), (unsigned long)text.getCacheMisses());
+    if(emu.counters.errors != 0)
+    {
+      rtn = 1;
+    }
+  }
+  printf("%s\n", rtn == 0 ? "PASS" : "FAIL");
+  return rtn;
+}
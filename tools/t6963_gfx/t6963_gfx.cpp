@@ -0,0 +1,417 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_gfx.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Graphics against a pixel by pixel model on the
+///        emulator and measure each primitive.  Random shapes, in both
+///        colours, are drawn over a random background with 6 and 8 pixel
+///        bytes, straight to the controller and through a T6963Shadow,
+///        and graphic RAM is compared with the model after each one.
+///        Build from the top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_gfx/t6963_gfx.cpp Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_gfx.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_shadow.cpp -o t6963_gfx
+///
+///        Add -DT6963_GFX_MAX_COLS=4 to exercise runs split into bursts.
+///
+///        Usage: t6963_gfx [-n shapes] [-u us]
+///          -n  shapes per primitive to check and time (default 2000)
+///          -u  microseconds per bus cycle on the target (default 2)
+///        Prints, per primitive, the bus cycles per pixel, the host
+///        pixels per second, and the pixels per second the bus allows at
+///        -u microseconds per cycle.  Exits non-zero on any mismatch.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "T6963_emu.h"
+#include "T6963_gfx.h"
+
+#define WIDTH                           240
+#define HEIGHT                           64
+#define GRAPHIC_HOME                 0x0800
+
+enum shape
+{
+  SHAPE_PIXEL,
+  SHAPE_HLINE,
+  SHAPE_VLINE,
+  SHAPE_LINE,
+  SHAPE_RECT,
+  SHAPE_FILL_RECT,
+  SHAPE_CIRCLE,
+  SHAPE_BITMAP,
+  SHAPES
+};
+
+static const char* const shapeNames[SHAPES] =
+{
+  "pixel", "hline", "vline", "line", "rect", "fillRect", "circle", "bitmap",
+};
+
+// Pixels as the model expects them, and how many each shape drew
+static uint8_t model[HEIGHT][WIDTH];
+static unsigned long plotted;
+
+struct Shape
+{
+  uint8_t kind;
+  int16_t x0;
+  int16_t y0;
+  int16_t x1;
+  int16_t y1;
+  uint8_t color;
+  uint8_t bits[32 * 8];     // bitmap, up to 64x32
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn plot
+///  @brief  Set one model pixel, clipped
+////////////////////////////////////////////////////////////////////////////////
+static void plot(int x, int y, uint8_t color)
+{
+  if(x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT)
+  {
+    model[y][x] = (color != 0);
+    plotted++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn modelLine
+///  @brief  Plain Bresenham, one pixel at a time
+////////////////////////////////////////////////////////////////////////////////
+static void modelLine(int x0, int y0, int x1, int y1, uint8_t color)
+{
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+  int t;
+  if(steep)
+  {
+    t = x0; x0 = y0; y0 = t;
+    t = x1; x1 = y1; y1 = t;
+  }
+  if(x0 > x1)
+  {
+    t = x0; x0 = x1; x1 = t;
+    t = y0; y0 = y1; y1 = t;
+  }
+  int dx = x1 - x0;
+  int dy = abs(y1 - y0);
+  int err = dx / 2;
+  int ystep = (y0 < y1) ? 1 : -1;
+  for(int x = x0; x <= x1; x++)
+  {
+    if(steep)
+    {
+      plot(y0, x, color);
+    }
+    else
+    {
+      plot(x, y0, color);
+    }
+    err -= dy;
+    if(err < 0)
+    {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn modelCircle
+///  @brief  Midpoint circle, eight octants
+////////////////////////////////////////////////////////////////////////////////
+static void modelCircle(int x0, int y0, int r, uint8_t color)
+{
+  int x = r;
+  int y = 0;
+  int err = 1 - r;
+  while(x >= y)
+  {
+    plot(x0 + x, y0 + y, color);
+    plot(x0 - x, y0 + y, color);
+    plot(x0 + x, y0 - y, color);
+    plot(x0 - x, y0 - y, color);
+    plot(x0 + y, y0 + x, color);
+    plot(x0 - y, y0 + x, color);
+    plot(x0 + y, y0 - x, color);
+    plot(x0 - y, y0 - x, color);
+    y++;
+    if(err < 0)
+    {
+      err += 2 * y + 1;
+    }
+    else
+    {
+      x--;
+      err += 2 * (y - x) + 1;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn randomShape
+///  @brief  A random shape of one kind, partly off screen at times
+////////////////////////////////////////////////////////////////////////////////
+static void randomShape(Shape& s, uint8_t kind)
+{
+  s.kind = kind;
+  s.x0 = rand() % (WIDTH + 40) - 20;
+  s.y0 = rand() % (HEIGHT + 20) - 10;
+  s.x1 = rand() % (WIDTH + 40) - 20;
+  s.y1 = rand() % (HEIGHT + 20) - 10;
+  s.color = rand() % 2;
+  if(kind == SHAPE_PIXEL || kind == SHAPE_CIRCLE)
+  {
+    s.x1 = rand() % 40;     // radius for a circle
+  }
+  else if(kind == SHAPE_HLINE || kind == SHAPE_VLINE || kind == SHAPE_RECT ||
+          kind == SHAPE_FILL_RECT || kind == SHAPE_BITMAP)
+  {
+    s.x1 = rand() % (kind == SHAPE_BITMAP ? 64 : 120) + 1;   // w
+    s.y1 = rand() % (kind == SHAPE_BITMAP ? 32 : 40) + 1;    // h
+  }
+  for(size_t i = 0; i < sizeof(s.bits); i++)
+  {
+    s.bits[i] = rand();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn drawModel
+///  @brief  Draw a shape into the model
+////////////////////////////////////////////////////////////////////////////////
+static void drawModel(const Shape& s)
+{
+  if(s.kind == SHAPE_PIXEL)
+  {
+    plot(s.x0, s.y0, s.color);
+  }
+  else if(s.kind == SHAPE_HLINE)
+  {
+    for(int x = 0; x < s.x1; x++)
+    {
+      plot(s.x0 + x, s.y0, s.color);
+    }
+  }
+  else if(s.kind == SHAPE_VLINE)
+  {
+    for(int y = 0; y < s.y1; y++)
+    {
+      plot(s.x0, s.y0 + y, s.color);
+    }
+  }
+  else if(s.kind == SHAPE_LINE)
+  {
+    modelLine(s.x0, s.y0, s.x1, s.y1, s.color);
+  }
+  else if(s.kind == SHAPE_RECT || s.kind == SHAPE_FILL_RECT)
+  {
+    for(int y = 0; y < s.y1; y++)
+    {
+      for(int x = 0; x < s.x1; x++)
+      {
+        if(s.kind == SHAPE_FILL_RECT || y == 0 || y == s.y1 - 1 || x == 0 || x == s.x1 - 1)
+        {
+          plot(s.x0 + x, s.y0 + y, s.color);
+        }
+      }
+    }
+  }
+  else if(s.kind == SHAPE_CIRCLE)
+  {
+    modelCircle(s.x0, s.y0, s.x1, s.color);
+  }
+  else
+  {
+    int stride = (s.x1 + 7) / 8;
+    for(int y = 0; y < s.y1; y++)
+    {
+      for(int x = 0; x < s.x1; x++)
+      {
+        plot(s.x0 + x, s.y0 + y, (s.bits[y * stride + x / 8] >> (7 - x % 8)) & 1);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn drawShape
+///  @brief  Draw a shape with T6963Graphics
+////////////////////////////////////////////////////////////////////////////////
+static void drawShape(T6963Graphics& gfx, const Shape& s)
+{
+  if(s.kind == SHAPE_PIXEL)
+  {
+    gfx.pixel(s.x0, s.y0, s.color);
+  }
+  else if(s.kind == SHAPE_HLINE)
+  {
+    gfx.hline(s.x0, s.y0, s.x1, s.color);
+  }
+  else if(s.kind == SHAPE_VLINE)
+  {
+    gfx.vline(s.x0, s.y0, s.y1, s.color);
+  }
+  else if(s.kind == SHAPE_LINE)
+  {
+    gfx.line(s.x0, s.y0, s.x1, s.y1, s.color);
+  }
+  else if(s.kind == SHAPE_RECT)
+  {
+    gfx.rect(s.x0, s.y0, s.x1, s.y1, s.color);
+  }
+  else if(s.kind == SHAPE_FILL_RECT)
+  {
+    gfx.fillRect(s.x0, s.y0, s.x1, s.y1, s.color);
+  }
+  else if(s.kind == SHAPE_CIRCLE)
+  {
+    gfx.circle(s.x0, s.y0, s.x1, s.color);
+  }
+  else
+  {
+    gfx.bitmap(s.x0, s.y0, s.bits, s.x1, s.y1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn compare
+///  @return  Pixels of graphic RAM that differ from the model
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long compare(T6963Emulator& emu, uint8_t fw)
+{
+  unsigned long rtn = 0;
+  for(int y = 0; y < HEIGHT; y++)
+  {
+    for(int x = 0; x < WIDTH; x++)
+    {
+      uint8_t d = emu.ram(GRAPHIC_HOME + y * (WIDTH / fw) + x / fw);
+      rtn += ( (d >> (fw - 1 - x % fw)) & 1) != model[y][x];
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn seconds
+///  @return  Monotonic time in seconds
+////////////////////////////////////////////////////////////////////////////////
+static double seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int rtn = 0;
+  int count = 2000;
+  double usPerCycle = 2;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      count = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-u") == 0 && i + 1 < argc)
+    {
+      usPerCycle = atof(argv[++i]);
+    }
+  }
+
+  static Shape shapes[SHAPES][100];
+  static uint8_t graphicBuf[(WIDTH / 6) * HEIGHT];
+
+  printf("%-9s %4s %-7s %10s %10s %12s %12s\n", "", "font", "mode",
+         "pixels", "cycles/px", "host px/s", "bus px/s");
+  for(uint8_t fw = 6; fw <= 8; fw += 2)
+  {
+    for(int shadowed = 0; shadowed < 2; shadowed++)
+    {
+      T6963Emulator emu(WIDTH / fw, HEIGHT, fw);
+      T6963 lcd(emu);
+      lcd.ports_init();
+      lcd.setFontWidth(fw);
+      lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+      lcd.setGraphicArea(WIDTH / fw);
+      lcd.setDisplayMode(0, 1);
+      T6963Graphics gfx(lcd, WIDTH, HEIGHT);
+      T6963Shadow shadow(lcd, HEIGHT);
+
+      srand(fw * 2 + shadowed);
+      for(int y = 0; y < HEIGHT; y++)
+      {
+        for(int c = 0; c < WIDTH / fw; c++)
+        {
+          uint8_t d = rand() & ( (1 << fw) - 1);
+          emu.ram(GRAPHIC_HOME + y * (WIDTH / fw) + c, d);
+          graphicBuf[y * (WIDTH / fw) + c] = d;
+          for(int p = 0; p < fw; p++)
+          {
+            model[y][c * fw + p] = (d >> (fw - 1 - p)) & 1;
+          }
+        }
+      }
+      if(shadowed)
+      {
+        shadow.begin(NULL, graphicBuf);
+        gfx.setFramebuffer(&shadow);
+      }
+
+      for(uint8_t k = 0; k < SHAPES; k++)
+      {
+        unsigned long bad = 0;
+        unsigned long pixels = 0;
+        unsigned long cycles = 0;
+        double host = 0;
+        for(int done = 0; done < count; done += 100)
+        {
+          int n = (count - done < 100) ? count - done : 100;
+          for(int i = 0; i < n; i++)
+          {
+            randomShape(shapes[k][i], k);
+          }
+          emu.resetCounters();
+          double start = seconds();
+          for(int i = 0; i < n; i++)
+          {
+            drawShape(gfx, shapes[k][i]);
+          }
+          if(shadowed)
+          {
+            shadow.flush();
+          }
+          host += seconds() - start;
+          cycles += emu.counters.busCycles;
+          plotted = 0;
+          for(int i = 0; i < n; i++)
+          {
+            drawModel(shapes[k][i]);
+          }
+          pixels += plotted;
+          bad += compare(emu, fw);
+        }
+        printf("%-9s %4u %-7s %10lu %10.2f %12.0f %12.0f%s\n", shapeNames[k], fw,
+               shadowed ? "shadow" : "direct", pixels, (double)cycles / pixels,
+               pixels / host, pixels / (cycles * usPerCycle * 1e-6),
+               bad == 0 ? "" : "  FAIL");
+        if(bad != 0 || emu.counters.errors != 0)
+        {
+          rtn = 1;
+        }
+      }
+    }
+  }
+  printf("%s\n", rtn == 0 ? "PASS" : "FAIL");
+  return rtn;
+}
@@ -0,0 +1,481 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_anim_check.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Anim on the emulator.  Random picture sequences are
+///        coded as looping write and XOR animations, laid out as
+///        t6963_image -a lays them out, and played at random places over
+///        a random background.  After every frame, for at least 30 frames
+///        and twice round the loop, the box must hold the picture (write)
+///        or the background XOR the picture (XOR), and nothing outside
+///        the box may change.  Paced play, play once and rejected
+///        animations are checked too.  Build from the top of the
+///        repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_image/t6963_anim_check.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_anim.cpp -o t6963_anim_check
+///
+///        Usage: t6963_anim_check [path of t6963_image]
+///        With the converter given, random PBM sequences are also
+///        converted with it (-a, -a -x, -l) and played pixel for pixel.
+///        Exits non-zero on any failure.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "T6963_emu.h"
+#include "T6963_anim.h"
+
+#define AREA                             40
+#define HEIGHT                           64
+#define GRAPHIC_HOME                 0x0800
+#define MIN_FRAMES                       30
+#define CASES                           200
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn check
+///  @brief  Report one group of checks, counting failures
+////////////////////////////////////////////////////////////////////////////////
+static void check(const char* what, unsigned long cases, unsigned long bad)
+{
+  printf("%-40s %6lu cases  %s\n", what, cases, bad == 0 ? "ok" : "FAIL");
+  if(bad != 0)
+  {
+    printf("  %lu failed\n", bad);
+    failures++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pictures
+///  @brief  A sequence of pictures: a random first one, then each a copy
+///          of the one before with a few runs changed
+////////////////////////////////////////////////////////////////////////////////
+static std::vector<Bytes> pictures(int count, int cols, int rows)
+{
+  std::vector<Bytes> rtn;
+  Bytes pic(cols * rows);
+  for(size_t i = 0; i < pic.size(); i++)
+  {
+    pic[i] = (rand() % 3 == 0) ? rand() : 0;
+  }
+  for(int f = 0; f < count; f++)
+  {
+    for(int k = (f == 0) ? 0 : 1 + rand() % 6; k > 0; k--)
+    {
+      int at = rand() % pic.size();
+      for(int n = 1 + rand() % 12; n > 0 && at < (int)pic.size(); n--)
+      {
+        pic[at++] = rand();
+      }
+    }
+    rtn.push_back(pic);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn addFrame
+///  @brief  Append the spans that turn one picture into the next, per
+///          row, up to 128 bytes each.  With too many spans for the count
+///          byte, each changed row is sent as one span instead.
+///  @param[in] full  Send every byte, not only the changed ones
+////////////////////////////////////////////////////////////////////////////////
+static void addFrame(Bytes& anim, const Bytes& from, const Bytes& to, int cols, bool isXor, bool full)
+{
+  int rows = to.size() / cols;
+  Bytes spans;
+  int count = 0;
+  for(int pass = 0; pass < 2 && (pass == 0 || count > 255); pass++)
+  {
+    spans.clear();
+    count = 0;
+    for(int r = 0; r < rows; r++)
+    {
+      int c = 0;
+      while(c < cols)
+      {
+        int start = c;
+        int end;
+        while(start < cols && !full && from[r * cols + start] == to[r * cols + start])
+        {
+          start++;
+        }
+        end = start;
+        while(end < cols && end - start < 128 &&
+              (full || pass == 1 || from[r * cols + end] != to[r * cols + end]))
+        {
+          end++;
+        }
+        if(pass == 1)
+        {
+          while(end > start && from[r * cols + end - 1] == to[r * cols + end - 1])
+          {
+            end--;
+          }
+        }
+        if(end > start)
+        {
+          int off = r * cols + start;
+          spans.push_back(off & 0xff);
+          spans.push_back(off >> 8);
+          spans.push_back( (end - start - 1) | (isXor ? T6963_ANIM_XOR : 0));
+          for(int i = off; i < r * cols + end; i++)
+          {
+            spans.push_back(isXor ? from[i] ^ to[i] : to[i]);
+          }
+          count++;
+        }
+        c = (end > start) ? end : cols;
+      }
+    }
+  }
+  anim.push_back(count);
+  anim.insert(anim.end(), spans.begin(), spans.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn encode
+///  @brief  Code pictures as an animation.  Frame 0 draws picture 0 (XOR:
+///          over a blank box); with a loop a last frame returns to the
+///          loop picture and play continues after it.
+///  @param[in] loopTo  Picture to loop back to, -1 to play once
+////////////////////////////////////////////////////////////////////////////////
+static Bytes encode(const std::vector<Bytes>& pics, int cols, bool isXor, int loopTo)
+{
+  Bytes rtn;
+  int n = pics.size();
+  Bytes blank(pics[0].size(), 0);
+  rtn.push_back(n + (loopTo >= 0));
+  rtn.push_back(loopTo >= 0 ? loopTo + 1 : T6963_ANIM_NO_LOOP);
+  rtn.push_back(cols);
+  rtn.push_back(pics[0].size() / cols);
+  for(int f = 0; f < n + (loopTo >= 0); f++)
+  {
+    const Bytes& from = (f == 0) ? blank : pics[f - 1];
+    const Bytes& to = (f < n) ? pics[f] : pics[loopTo];
+    addFrame(rtn, from, to, cols, isXor, f == 0 && !isXor);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn shown
+///  @brief  The picture on show after a number of frames, counted from
+///          the layout rather than from the player
+////////////////////////////////////////////////////////////////////////////////
+static int shown(int step, int n, int loopTo)
+{
+  int rtn = step;
+  if(step >= n)
+  {
+    int cycle = n - loopTo;  // loop picture, then the ones after it
+    rtn = loopTo + (step - n) % cycle;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn background
+///  @brief  Fill all of display RAM with random bytes and keep a copy
+////////////////////////////////////////////////////////////////////////////////
+static Bytes background(T6963Emulator& emu)
+{
+  Bytes rtn(T6963_EMU_RAM_SIZE);
+  for(uint32_t a = 0; a < T6963_EMU_RAM_SIZE; a++)
+  {
+    rtn[a] = rand();
+    emu.ram(a, rtn[a]);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn compare
+///  @return  Bytes of RAM that differ from the background with the box
+///           holding a picture, written or XORed
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long compare(T6963Emulator& emu, const Bytes& bg, const Bytes& pic,
+                             uint16_t base, int cols, bool isXor)
+{
+  unsigned long rtn = 0;
+  for(uint32_t a = 0; a < T6963_EMU_RAM_SIZE; a++)
+  {
+    uint8_t want = bg[a];
+    int r = ( (int)a - base) / AREA;
+    int c = ( (int)a - base) % AREA;
+    if(a >= base && c < cols && r < (int)pic.size() / cols)
+    {
+      want = isXor ? bg[a] ^ pic[r * cols + c] : pic[r * cols + c];
+    }
+    rtn += emu.ram(a) != want;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn play
+///  @brief  Random looping animations, stepped, checked after each frame
+///  @return  Failed cases
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long play(T6963Emulator& emu, T6963Anim& anim, bool isXor, int cases, unsigned long& frames)
+{
+  unsigned long rtn = 0;
+  frames = 0;
+  for(int t = 0; t < cases; t++)
+  {
+    int cols = 1 + rand() % 12;
+    int rows = 1 + rand() % 24;
+    int n = 1 + rand() % 12;
+    int loopTo = rand() % n;
+    int col = rand() % (AREA - cols + 1);
+    int y = rand() % (HEIGHT - rows + 1);
+    std::vector<Bytes> pics = pictures(n, cols, rows);
+    Bytes data = encode(pics, cols, isXor, loopTo);
+    Bytes bg = background(emu);
+    int steps = MIN_FRAMES;
+    bool ok = (t % 2) ? anim.start_P(&data[0], col, y, 0) : anim.start(&data[0], col, y, 0);
+    anim.resetCounters();
+    steps = (steps < 2 * (n + 1)) ? 2 * (n + 1) : steps;
+    for(int s = 0; ok && s < steps; s++)
+    {
+      ok = anim.step() && anim.isPlaying();
+      ok = ok && compare(emu, bg, pics[shown(s, n, loopTo)], GRAPHIC_HOME + y * AREA + col, cols, isXor) == 0;
+      frames++;
+    }
+    ok = ok && anim.getFramesShown() == (uint32_t)steps;
+    rtn += !ok;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn paced
+///  @brief  update() every 10 ms with 40 ms frames and two stalls.  Every
+///          frame slot must be shown or dropped, no slot may start early,
+///          and the pictures must follow in order.
+///  @return  Failed checks
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long paced(T6963Emulator& emu, T6963Anim& anim)
+{
+  unsigned long rtn = 0;
+  std::vector<Bytes> pics = pictures(6, 4, 8);
+  Bytes data = encode(pics, 4, false, 2);
+  Bytes bg = background(emu);
+  unsigned long start = hostMicros();
+  rtn += !anim.start(&data[0], 3, 5, 40000);
+  anim.resetCounters();
+  for(int t = 0; t < 100; t++)
+  {
+    if(anim.update())
+    {
+      unsigned long now = hostMicros();
+      rtn += (now - start) / 40000 < anim.getFramesShown() + anim.getDropped() - 1;
+      rtn += compare(emu, bg, pics[shown(anim.getFramesShown() - 1, 6, 2)],
+                     GRAPHIC_HOME + 5 * AREA + 3, 4, false) != 0;
+    }
+    hostMicros() += (t == 30 || t == 70) ? 130000 : 10000;
+  }
+  unsigned long slots = (hostMicros() - start - 10000) / 40000 + 1;
+  rtn += anim.getFramesShown() + anim.getDropped() != slots;
+  rtn += anim.getDropped() == 0;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn rejects
+///  @brief  Play once, animations that do not fit, and a bad span
+///  @return  Failed checks
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long rejects(T6963Emulator& emu, T6963Anim& anim, unsigned long& cases)
+{
+  unsigned long rtn = 0;
+  std::vector<Bytes> pics = pictures(5, 4, 8);
+  Bytes once = encode(pics, 4, true, -1);
+  Bytes looping = encode(pics, 4, false, 0);
+  Bytes bg = background(emu);
+  int n = 0;
+  rtn += !anim.start(&once[0], 0, 0, 0);
+  while(anim.step())
+  {
+    n++;
+  }
+  rtn += n != 5 || anim.isPlaying();
+  rtn += compare(emu, bg, pics[4], GRAPHIC_HOME, 4, true) != 0;
+
+  rtn += anim.start(&looping[0], AREA - 3, 0, 0);       // off the right edge
+  rtn += anim.start(&looping[0], 0, HEIGHT - 7, 0);     // off the bottom
+  Bytes badLoop(looping);
+  badLoop[1] = badLoop[0];
+  rtn += anim.start(&badLoop[0], 0, 0, 0);              // loop past the end
+  rtn += anim.start(NULL, 0, 0, 0);
+
+  bg = background(emu);
+  Bytes badSpan(looping);
+  badSpan[T6963_ANIM_HEADER + 1] = 4 * 8;               // first span below the box
+  rtn += !anim.start(&badSpan[0], 0, 0, 0);
+  rtn += anim.step() || anim.isPlaying();
+  rtn += compare(emu, bg, Bytes(), GRAPHIC_HOME, 4, false) != 0;
+  cases = 9;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn convert
+///  @brief  Run the converter on pictures and read back its array
+///  @return  The animation bytes, empty on failure
+////////////////////////////////////////////////////////////////////////////////
+static Bytes convert(const char* tool, const char* args, const std::vector<char*>& paths)
+{
+  Bytes rtn;
+  std::string cmd = std::string(tool) + " " + args;
+  char line[512];
+  bool inArray = false;
+  for(size_t i = 0; i < paths.size(); i++)
+  {
+    cmd += std::string(" ") + paths[i];
+  }
+  cmd += " 2>/dev/null";
+  FILE* p = popen(cmd.c_str(), "r");
+  while(p != NULL && fgets(line, sizeof(line), p) != NULL)
+  {
+    if(strchr(line, '{') != NULL)
+    {
+      inArray = true;
+    }
+    else if(strchr(line, '}') != NULL)
+    {
+      inArray = false;
+    }
+    else if(inArray)
+    {
+      char* s = line;
+      char* e;
+      for(long v = strtol(s, &e, 0); e != s; v = strtol(s, &e, 0))
+      {
+        rtn.push_back(v);
+        s = e + strspn(e, ", \t\r\n");
+      }
+    }
+  }
+  if(p != NULL)
+  {
+    pclose(p);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn converter
+///  @brief  Random PBM sequences through the converter, played pixel for
+///          pixel for at least 30 frames
+///  @return  Failed cases
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long converter(const char* tool, int cases)
+{
+  unsigned long rtn = 0;
+  for(int t = 0; t < cases; t++)
+  {
+    uint8_t fw = (t % 2) ? 8 : 6;
+    int w = 1 + rand() % 60;
+    int h = 1 + rand() % 32;
+    int n = 1 + rand() % 8;
+    int loopTo = rand() % n;
+    bool isXor = (t / 2) % 2;
+    std::vector<std::vector<uint8_t> > pix(n, std::vector<uint8_t>(w * h));
+    std::vector<char*> paths;
+    for(int f = 0; f < n; f++)
+    {
+      char* path = strdup("/tmp/t6963_animXXXXXX");
+      int fd = mkstemp(path);
+      FILE* file = (fd < 0) ? NULL : fdopen(fd, "w");
+      paths.push_back(path);
+      if(file == NULL)
+      {
+        return cases;
+      }
+      fprintf(file, "P1\n%d %d\n", w, h);
+      for(int i = 0; i < w * h; i++)
+      {
+        pix[f][i] = (f > 0 && rand() % 6 != 0) ? pix[f - 1][i] : rand() % 2;
+        fprintf(file, "%d%c", pix[f][i], (i % w == w - 1) ? '\n' : ' ');
+      }
+      fclose(file);
+    }
+    char args[64];
+    snprintf(args, sizeof(args), "-a %s-l %d -f %u", isXor ? "-x " : "", loopTo, fw);
+    Bytes data = convert(tool, args, paths);
+    for(size_t f = 0; f < paths.size(); f++)
+    {
+      unlink(paths[f]);
+      free(paths[f]);
+    }
+
+    T6963Emulator emu(240 / fw, HEIGHT, fw);
+    T6963 lcd(emu);
+    T6963Anim anim(lcd);
+    lcd.ports_init();
+    lcd.setFontWidth(fw);
+    lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+    lcd.setGraphicArea(240 / fw);
+    lcd.setDisplayMode(0, 1);
+    lcd.setPanelSize(240, HEIGHT);
+    lcd.clearGraphic();
+    int col = rand() % (240 / fw - (w + fw - 1) / fw + 1);
+    int y = rand() % (HEIGHT - h + 1);
+    bool ok = data.size() > T6963_ANIM_HEADER && anim.start(&data[0], col, y, 0);
+    for(int s = 0; ok && s < MIN_FRAMES; s++)
+    {
+      const std::vector<uint8_t>& want = pix[shown(s, n, loopTo)];
+      ok = anim.step();
+      for(int i = 0; ok && i < w * h; i++)
+      {
+        ok = emu.pixel(col * fw + i % w, y + i / w) == want[i];
+      }
+    }
+    rtn += !ok;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  T6963Emulator emu(AREA, HEIGHT, 6);
+  T6963 lcd(emu);
+  T6963Anim anim(lcd);
+  unsigned long frames;
+  unsigned long cases;
+  lcd.ports_init();
+  lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+  lcd.setGraphicArea(AREA);
+  lcd.setPanelSize(AREA * 6, HEIGHT);
+  srand(23);
+
+  check("looping write animations", CASES, play(emu, anim, false, CASES, frames));
+  printf("  %lu frames\n", frames);
+  check("looping XOR animations", CASES, play(emu, anim, true, CASES, frames));
+  printf("  %lu frames\n", frames);
+  check("paced play with stalls", 1, paced(emu, anim));
+  unsigned long bad = rejects(emu, anim, cases);
+  check("play once and rejected animations", cases, bad);
+  if(argc > 1)
+  {
+    check("converter, write and XOR, looping", 40, converter(argv[1], 40));
+  }
+  check("emulator errors", 1, emu.counters.errors);
+  printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,564 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_image.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Convert PBM or PGM pictures into a T6963Image or a T6963Anim
+///        for PROGMEM.  Build from the top of the repository with
+///
+///   g++ -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_image/t6963_image.cpp -o t6963_image
+///
+///        Usage: t6963_image [-f font] [-n name] [-i] [-d previous]
+///                           picture [> picture.h]
+///          -f  pixels per graphic byte, 6 or 8 as set by the FS pin
+///          -n  name of the array (default image)
+///          -i  invert: light pixels on
+///          -d  code a delta image against the previous picture
+///
+///               t6963_image -a [-x] [-l loop] [-f font] [-n name] [-i]
+///                           picture... [> animation.h]
+///          -a  code the pictures as the frames of an animation
+///          -x  XOR spans, to play over other graphics (default write)
+///          -l  picture to loop back to, -1 to play once (default 0)
+///        Dark pixels are on.  A PGM is cut at half its maximum value.
+///        Convert PNG and other formats first, e.g. with netpbm's
+///        pngtopnm or ImageMagick's convert picture.png picture.pbm.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "T6963_image.h"
+#include "T6963_anim.h"
+
+// Unchanged bytes worth a skip: fewer are cheaper to rewrite than a burst
+#define SKIP_MIN                          (T6963_IMAGE_BURST_COST + 1)
+
+// Longest literal or repeat a single code holds
+#define RUN_MAX                         128
+
+struct Picture
+{
+  int width;
+  int height;
+  std::vector<bool> on;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readToken
+///  @brief  Read one whitespace separated header field, skipping comments
+///  @return  The value, -1 at end of file
+////////////////////////////////////////////////////////////////////////////////
+static int readToken(FILE* in)
+{
+  int rtn = -1;
+  int c = fgetc(in);
+  while(c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+  {
+    if(c == '#')
+    {
+      while(c != '\n' && c != EOF)
+      {
+        c = fgetc(in);
+      }
+    }
+    c = fgetc(in);
+  }
+  if(c >= '0' && c <= '9')
+  {
+    rtn = 0;
+    while(c >= '0' && c <= '9')
+    {
+      rtn = rtn * 10 + c - '0';
+      c = fgetc(in);
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readPicture
+///  @brief  Read a plain or raw PBM (P1, P4) or PGM (P2, P5)
+///  @param[in]  path  The file
+///  @param[out] pic   The pixels, true where on
+///  @return  True if the file was read
+////////////////////////////////////////////////////////////////////////////////
+static bool readPicture(const char* path, Picture& pic)
+{
+  bool rtn = false;
+  FILE* in = fopen(path, "rb");
+  if(in != NULL && fgetc(in) == 'P')
+  {
+    int kind = fgetc(in);
+    int maxval = 1;
+    pic.width = readToken(in);
+    pic.height = readToken(in);
+    if(kind == '2' || kind == '5')
+    {
+      maxval = readToken(in);
+    }
+    if(pic.width > 0 && pic.height > 0 && maxval > 0 && maxval < 256)
+    {
+      rtn = true;
+      pic.on.assign(pic.width * pic.height, false);
+      for(int y = 0; y < pic.height && rtn; y++)
+      {
+        int bits = 0;
+        for(int x = 0; x < pic.width && rtn; x++)
+        {
+          int v = -1;
+          if(kind == '1' || kind == '2')
+          {
+            v = readToken(in);
+          }
+          else if(kind == '4')
+          {
+            if(x % 8 == 0)
+            {
+              bits = fgetc(in);
+            }
+            v = (bits == EOF) ? -1 : (bits >> (7 - x % 8)) & 1;
+          }
+          else if(kind == '5')
+          {
+            v = fgetc(in);
+          }
+          rtn = (v >= 0);
+          if(kind == '1' || kind == '4')
+          {
+            pic.on[y * pic.width + x] = (v == 1);
+          }
+          else
+          {
+            pic.on[y * pic.width + x] = (v * 2 < maxval);
+          }
+        }
+      }
+    }
+  }
+  if(in != NULL)
+  {
+    fclose(in);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pack
+///  @brief  Pack pixels into graphic bytes, MSB leftmost, font bits per byte
+///  @return  The bytes, rows top to bottom
+////////////////////////////////////////////////////////////////////////////////
+static std::vector<uint8_t> pack(const Picture& pic, int font, bool invert, int cols)
+{
+  std::vector<uint8_t> rtn(cols * pic.height, 0);
+  for(int y = 0; y < pic.height; y++)
+  {
+    for(int x = 0; x < pic.width; x++)
+    {
+      if(pic.on[y * pic.width + x] != invert)
+      {
+        rtn[y * cols + x / font] |= 1 << (font - 1 - x % font);
+      }
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn encode
+///  @brief  Code bytes as literals, repeats and (for a delta) skips
+///  @param[in] data  The picture bytes
+///  @param[in] keep  True where a byte may be skipped, empty for none
+///  @return  The payload
+////////////////////////////////////////////////////////////////////////////////
+static std::vector<uint8_t> encode(const std::vector<uint8_t>& data, const std::vector<bool>& keep)
+{
+  std::vector<uint8_t> rtn;
+  size_t n = data.size();
+  size_t lit = 0;     // start of the pending literal
+  size_t i = 0;
+  while(i <= n)
+  {
+    size_t same = 0;
+    size_t rep = 1;
+    while(i + same < n && !keep.empty() && keep[i + same])
+    {
+      same++;
+    }
+    while(i + rep < n && rep < RUN_MAX && data[i + rep] == data[i])
+    {
+      rep++;
+    }
+    bool flush = (i == n || same >= SKIP_MIN || rep >= 3 || i - lit == RUN_MAX);
+    if(flush && i > lit)
+    {
+      rtn.push_back(i - lit - 1);
+      rtn.insert(rtn.end(), data.begin() + lit, data.begin() + i);
+    }
+    if(i == n)
+    {
+      i++;
+    }
+    else if(same >= SKIP_MIN)
+    {
+      for(size_t k = 0; k < same; k += 256)
+      {
+        rtn.push_back(T6963_IMAGE_SKIP);
+        rtn.push_back( (same - k > 256 ? 256 : same - k) - 1);
+      }
+      i += same;
+      lit = i;
+    }
+    else if(rep >= 3)
+    {
+      rtn.push_back(257 - rep);
+      rtn.push_back(data[i]);
+      i += rep;
+      lit = i;
+    }
+    else
+    {
+      lit = flush ? i : lit;
+      i++;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn decode
+///  @brief  Decode a payload the way T6963Image does, as a check, counting
+///          the bytes written and auto write bursts for a full width image
+///  @return  True if the payload reproduces want where it writes
+////////////////////////////////////////////////////////////////////////////////
+static bool decode(const std::vector<uint8_t>& code, const std::vector<uint8_t>& want,
+                   unsigned long& written, unsigned long& bursts)
+{
+  bool rtn = true;
+  bool open = false;
+  size_t out = 0;
+  size_t i = 0;
+  written = 0;
+  bursts = 0;
+  while(i < code.size() && rtn)
+  {
+    uint8_t c = code[i++];
+    int count = (c == T6963_IMAGE_SKIP) ? code[i++] + 1 : (c < T6963_IMAGE_SKIP) ? c + 1 : 257 - c;
+    uint8_t d = (c > T6963_IMAGE_SKIP) ? code[i++] : 0;
+    open = open && c != T6963_IMAGE_SKIP;
+    for(int k = 0; k < count && rtn; k++)
+    {
+      if(c != T6963_IMAGE_SKIP)
+      {
+        bursts += open ? 0 : 1;
+        open = true;
+        written++;
+        rtn = (out < want.size() && want[out] == ( (c < T6963_IMAGE_SKIP) ? code[i++] : d));
+      }
+      out++;
+    }
+  }
+  return rtn && out == want.size() && i == code.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeImage
+///  @brief  Code one picture, or a delta against previous, as a C array
+///  @return  0 on success
+////////////////////////////////////////////////////////////////////////////////
+static int writeImage(const char* path, const char* previous, const char* name,
+                      int font, bool invert)
+{
+  int rtn = 0;
+  Picture pic;
+  Picture prev;
+  if(!readPicture(path, pic))
+  {
+    fprintf(stderr, "%s: not a PBM or PGM picture\n", path);
+    rtn = 1;
+  }
+  else if(previous != NULL && (!readPicture(previous, prev) ||
+          prev.width != pic.width || prev.height != pic.height))
+  {
+    fprintf(stderr, "%s: not a picture the size of %s\n", previous, path);
+    rtn = 1;
+  }
+  else if( (pic.width + font - 1) / font > 255 || pic.height > 255)
+  {
+    fprintf(stderr, "%s: larger than 255 bytes by 255 rows\n", path);
+    rtn = 1;
+  }
+  else
+  {
+    int cols = (pic.width + font - 1) / font;
+    std::vector<uint8_t> data = pack(pic, font, invert, cols);
+    std::vector<bool> keep;
+    std::vector<uint8_t> code;
+    unsigned long written = 0;
+    unsigned long bursts = 0;
+    if(previous != NULL)
+    {
+      std::vector<uint8_t> old = pack(prev, font, invert, cols);
+      keep.resize(data.size());
+      for(size_t i = 0; i < data.size(); i++)
+      {
+        keep[i] = ( (data[i] ^ old[i]) == 0);
+      }
+    }
+    code = encode(data, keep);
+    if(code.size() > 0xffff || !decode(code, data, written, bursts))
+    {
+      fprintf(stderr, "%s: coding failed\n", path);
+      rtn = 1;
+    }
+    else
+    {
+      size_t raw = data.size();
+      printf("// %s: %dx%d pixels, %d bytes x %d rows, font %d%s\n",
+             path, pic.width, pic.height, cols, pic.height, font,
+             previous != NULL ? ", delta" : "");
+      printf("// flash %lu bytes (raw %lu)\n",
+             (unsigned long)(code.size() + T6963_IMAGE_HEADER), (unsigned long)raw);
+      printf("// bus bytes: %lu drawn, %lu as one burst, %lu with dataWriteIncrement\n",
+             written + bursts * T6963_IMAGE_BURST_COST,
+             (unsigned long)raw + T6963_IMAGE_BURST_COST, (unsigned long)raw * 2 + 3);
+      printf("const uint8_t %s[] PROGMEM =\n{\n", name);
+      printf("  0x%02x, %d, %d, 0x%02x, 0x%02x,", previous != NULL ? T6963_IMAGE_DELTA : 0,
+             cols, pic.height, (unsigned)(code.size() & 0xff), (unsigned)(code.size() >> 8));
+      for(size_t i = 0; i < code.size(); i++)
+      {
+        printf("%s0x%02x,", (i % 12 == 0) ? "\n  " : " ", code[i]);
+      }
+      printf("\n};\n");
+      fprintf(stderr, "%s: %lu bytes, %lu bus bytes\n", name,
+              (unsigned long)(code.size() + T6963_IMAGE_HEADER),
+              written + bursts * T6963_IMAGE_BURST_COST);
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn addFrame
+///  @brief  Append one animation frame: the spans that turn from into to.
+///          Changed bytes closer than a burst's cost are joined into one
+///          span, and spans never cross a row.
+///  @param[out] out    The animation so far
+///  @param[in]  from   Bytes shown before the frame
+///  @param[in]  to     Bytes shown after it
+///  @param[in]  cols   Bytes per row
+///  @param[in]  isXor  True for XOR spans, false for write spans
+///  @param[in]  all    True to write every byte (a first frame)
+///  @param[out] bus    Bus bytes the frame costs
+///  @return  False if the frame needs more than 255 spans
+////////////////////////////////////////////////////////////////////////////////
+static bool addFrame(std::vector<uint8_t>& out, const std::vector<uint8_t>& from,
+                     const std::vector<uint8_t>& to, int cols, bool isXor, bool all,
+                     unsigned long& bus)
+{
+  size_t countAt = out.size();
+  int spans = 0;
+  out.push_back(0);
+  bus = 0;
+  for(size_t row = 0; row < to.size(); row += cols)
+  {
+    int x = 0;
+    while(x < cols)
+    {
+      if(all || from[row + x] != to[row + x])
+      {
+        int end = x + 1;      // one past the last changed byte
+        for(int k = x + 1; k < cols && k - end <= T6963_IMAGE_BURST_COST &&
+            k - x < T6963_ANIM_LENGTH + 1; k++)
+        {
+          if(all || from[row + k] != to[row + k])
+          {
+            end = k + 1;
+          }
+        }
+        size_t off = row + x;
+        int len = end - x;
+        out.push_back(off & 0xff);
+        out.push_back(off >> 8);
+        out.push_back( (len - 1) | (isXor ? T6963_ANIM_XOR : 0));
+        for(int k = x; k < end; k++)
+        {
+          out.push_back(isXor ? from[row + k] ^ to[row + k] : to[row + k]);
+        }
+        if(isXor)
+        {
+          int chunks = (len + T6963_ANIM_CHUNK - 1) / T6963_ANIM_CHUNK;
+          bus += 2 * len + 2 * chunks * T6963_IMAGE_BURST_COST;
+        }
+        else
+        {
+          bus += len + T6963_IMAGE_BURST_COST;
+        }
+        spans++;
+        x = end;
+      }
+      else
+      {
+        x++;
+      }
+    }
+  }
+  out[countAt] = spans;
+  return spans <= 255;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn writeAnimation
+///  @brief  Code a sequence of pictures as a span delta animation.  The
+///          first frame draws picture 0 (XOR: over a blank box); with a
+///          loop a last frame returns to the loop picture and play goes
+///          on from the frame after it.
+///  @param[in] paths   The pictures, all one size
+///  @param[in] loopTo  Picture to loop back to, -1 to play once
+///  @return  0 on success
+////////////////////////////////////////////////////////////////////////////////
+static int writeAnimation(const std::vector<const char*>& paths, const char* name,
+                          int font, bool invert, bool isXor, int loopTo)
+{
+  int rtn = 0;
+  std::vector<std::vector<uint8_t> > pics;
+  int width = 0;
+  int height = 0;
+  int cols = 0;
+  for(size_t i = 0; i < paths.size() && rtn == 0; i++)
+  {
+    Picture pic;
+    if(!readPicture(paths[i], pic) || (i > 0 && (pic.width != width || pic.height != height)))
+    {
+      fprintf(stderr, "%s: not a PBM or PGM picture the size of the first\n", paths[i]);
+      rtn = 1;
+    }
+    else
+    {
+      width = pic.width;
+      height = pic.height;
+      cols = (width + font - 1) / font;
+      pics.push_back(pack(pic, font, invert, cols));
+    }
+  }
+  if(rtn == 0 && (cols > 255 || height > 255 || cols * height > 0xffff ||
+                  loopTo >= (int)pics.size() || pics.size() + (loopTo >= 0) > 254))
+  {
+    fprintf(stderr, "animation too large, or loop picture out of range\n");
+    rtn = 1;
+  }
+  if(rtn == 0)
+  {
+    std::vector<uint8_t> anim;
+    std::vector<uint8_t> blank(pics[0].size(), 0);
+    std::vector<unsigned long> bus;
+    int frames = pics.size() + (loopTo >= 0 ? 1 : 0);
+    anim.push_back(frames);
+    anim.push_back(loopTo >= 0 ? loopTo + 1 : T6963_ANIM_NO_LOOP);
+    anim.push_back(cols);
+    anim.push_back(height);
+    for(int f = 0; f < frames && rtn == 0; f++)
+    {
+      const std::vector<uint8_t>& from = (f == 0) ? blank : pics[f - 1];
+      const std::vector<uint8_t>& to = (f < (int)pics.size()) ? pics[f] : pics[loopTo];
+      unsigned long cost = 0;
+      if(!addFrame(anim, from, to, cols, isXor, f == 0 && !isXor, cost))
+      {
+        fprintf(stderr, "frame %d: too many spans\n", f);
+        rtn = 1;
+      }
+      bus.push_back(cost);
+    }
+    if(rtn == 0)
+    {
+      // a box narrower than the area is redrawn a burst per row
+      unsigned long redraw = (unsigned long)(cols + T6963_IMAGE_BURST_COST) * height;
+      printf("// %d frames of %dx%d pixels, %d bytes x %d rows, font %d, %s spans, %s\n",
+             frames, width, height, cols, height, font, isXor ? "XOR" : "write",
+             loopTo >= 0 ? "looping" : "once");
+      printf("// flash %lu bytes; bus bytes per frame (redraw %lu):\n//",
+             (unsigned long)anim.size(), redraw);
+      for(size_t f = 0; f < bus.size(); f++)
+      {
+        printf(" %lu", bus[f]);
+      }
+      printf("\nconst uint8_t %s[] PROGMEM =\n{", name);
+      for(size_t i = 0; i < anim.size(); i++)
+      {
+        printf("%s0x%02x,", (i % 12 == 0) ? "\n  " : " ", anim[i]);
+      }
+      printf("\n};\n");
+      fprintf(stderr, "%s: %lu bytes, %d frames\n", name, (unsigned long)anim.size(), frames);
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int rtn = 0;
+  int font = 6;
+  int loopTo = 0;
+  bool invert = false;
+  bool animate = false;
+  bool isXor = false;
+  const char* name = "image";
+  const char* previous = NULL;
+  std::vector<const char*> paths;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+    {
+      font = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      name = argv[++i];
+    }
+    else if(strcmp(argv[i], "-i") == 0)
+    {
+      invert = true;
+    }
+    else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+    {
+      previous = argv[++i];
+    }
+    else if(strcmp(argv[i], "-a") == 0)
+    {
+      animate = true;
+    }
+    else if(strcmp(argv[i], "-x") == 0)
+    {
+      isXor = true;
+    }
+    else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+    {
+      loopTo = atoi(argv[++i]);
+    }
+    else
+    {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  if(paths.empty() || (!animate && paths.size() != 1) || (font != 6 && font != 8))
+  {
+    fprintf(stderr, "usage: t6963_image [-f 6|8] [-n name] [-i] [-d previous] picture\n"
+                    "       t6963_image -a [-x] [-l loop] [-f 6|8] [-n name] [-i] "
+                    "picture...\n");
+    rtn = 1;
+  }
+  else if(animate)
+  {
+    rtn = writeAnimation(paths, name, font, invert, isXor, loopTo);
+  }
+  else
+  {
+    rtn = writeImage(paths[0], previous, name, font, invert);
+  }
+  return rtn;
+}
@@ -0,0 +1,531 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_image_check.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Image on the emulator.  Random images are coded
+///        with every payload code, drawn with draw, draw_P and drawAt and
+///        compared byte for byte, delta images included.  Then 3000
+///        damaged payloads (cut short, overrunning, bytes changed, wrong
+///        length, noise) are checked against a strict reference decoder:
+///        T6963Image must accept exactly the valid ones, draw them
+///        exactly, and never write outside the image rectangle.  Build
+///        from the top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_image/t6963_image_check.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_image.cpp -o t6963_image_check
+///
+///        Usage: t6963_image_check [path of t6963_image]
+///        With the converter given, random pictures are also converted
+///        with it, plain and as deltas, and drawn pixel for pixel.
+///        Exits non-zero on any failure.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "T6963_emu.h"
+#include "T6963_image.h"
+
+#define AREA                             40
+#define HEIGHT                           64
+#define GRAPHIC_HOME                 0x0800
+#define CANARY                         0xa5
+#define FUZZ_CASES                     3000
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn check
+///  @brief  Report one group of checks, counting failures
+////////////////////////////////////////////////////////////////////////////////
+static void check(const char* what, unsigned long cases, unsigned long bad)
+{
+  printf("%-40s %6lu cases  %s\n", what, cases, bad == 0 ? "ok" : "FAIL");
+  if(bad != 0)
+  {
+    printf("  %lu failed\n", bad);
+    failures++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn randomData
+///  @brief  Image bytes with runs, repeats and noise
+////////////////////////////////////////////////////////////////////////////////
+static Bytes randomData(int n)
+{
+  Bytes rtn(n);
+  int i = 0;
+  while(i < n)
+  {
+    int run = 1 + rand() % 40;
+    uint8_t d = rand();
+    bool noise = rand() % 2;
+    for(int k = 0; k < run && i < n; k++)
+    {
+      rtn[i++] = noise ? rand() : d;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn encode
+///  @brief  Code an image, choosing among the codes that fit at random so
+///          that every code and length turns up
+///  @param[in] prev  The image shown before, for a delta, or NULL
+////////////////////////////////////////////////////////////////////////////////
+static Bytes encode(const Bytes& data, const Bytes* prev, uint8_t cols, uint8_t rows)
+{
+  Bytes payload;
+  int n = data.size();
+  int i = 0;
+  while(i < n)
+  {
+    int same = 0;
+    int equal = 1;
+    while(prev != NULL && i + same < n && same < 256 && (*prev)[i + same] == data[i + same])
+    {
+      same++;
+    }
+    while(i + equal < n && equal < 128 && data[i + equal] == data[i])
+    {
+      equal++;
+    }
+    int pick = rand() % 3;
+    if(same > 0 && pick == 0)
+    {
+      int k = 1 + rand() % same;
+      payload.push_back(T6963_IMAGE_SKIP);
+      payload.push_back(k - 1);
+      i += k;
+    }
+    else if(equal >= 2 && pick != 2)
+    {
+      int k = 2 + rand() % (equal - 1);
+      payload.push_back(257 - k);
+      payload.push_back(data[i]);
+      i += k;
+    }
+    else
+    {
+      int k = 1 + rand() % ( (n - i < 128) ? n - i : 128);
+      payload.push_back(k - 1);
+      payload.insert(payload.end(), data.begin() + i, data.begin() + i + k);
+      i += k;
+    }
+  }
+  Bytes rtn;
+  rtn.push_back(prev != NULL ? T6963_IMAGE_DELTA : 0);
+  rtn.push_back(cols);
+  rtn.push_back(rows);
+  rtn.push_back(payload.size() & 0xff);
+  rtn.push_back(payload.size() >> 8);
+  rtn.insert(rtn.end(), payload.begin(), payload.end());
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn refDecode
+///  @brief  Strict decoder written from the format in T6963_image.h
+///  @param[in,out] out  The image before; the image after if valid
+///  @return  True if every code fits and the payload fills the image
+////////////////////////////////////////////////////////////////////////////////
+static bool refDecode(const Bytes& image, Bytes& out)
+{
+  bool rtn = image.size() >= T6963_IMAGE_HEADER;
+  size_t total = 0;
+  size_t end = 0;
+  if(rtn)
+  {
+    total = (size_t)image[1] * image[2];
+    end = T6963_IMAGE_HEADER + (image[3] | (image[4] << 8));
+    rtn = total != 0 && end <= image.size();
+  }
+  Bytes result(out);
+  size_t at = 0;
+  size_t i = T6963_IMAGE_HEADER;
+  while(rtn && i < end && at < total)
+  {
+    uint8_t c = image[i++];
+    size_t k = (c < T6963_IMAGE_SKIP) ? c + 1 : (c == T6963_IMAGE_SKIP) ? 0 : 257 - c;
+    if(c == T6963_IMAGE_SKIP)
+    {
+      rtn = i < end;
+      k = rtn ? image[i++] + 1 : 0;
+    }
+    else
+    {
+      rtn = i + (c < T6963_IMAGE_SKIP ? k : 1) <= end;
+    }
+    rtn = rtn && at + k <= total;
+    for(size_t j = 0; rtn && j < k; j++)
+    {
+      if(c < T6963_IMAGE_SKIP)
+      {
+        result[at] = image[i + j];
+      }
+      else if(c > T6963_IMAGE_SKIP)
+      {
+        result[at] = image[i];
+      }
+      at++;
+    }
+    if(c != T6963_IMAGE_SKIP)
+    {
+      i += (c < T6963_IMAGE_SKIP) ? k : 1;
+    }
+  }
+  rtn = rtn && at == total && i == end;
+  if(rtn)
+  {
+    out = result;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn canary
+///  @brief  Fill all of display RAM with a known byte
+////////////////////////////////////////////////////////////////////////////////
+static void canary(T6963Emulator& emu)
+{
+  for(uint32_t a = 0; a < T6963_EMU_RAM_SIZE; a++)
+  {
+    emu.ram(a, CANARY);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readRect
+///  @brief  The bytes of a rectangle of display RAM
+////////////////////////////////////////////////////////////////////////////////
+static Bytes readRect(T6963Emulator& emu, uint16_t addr, uint8_t stride, uint8_t cols, uint8_t rows)
+{
+  Bytes rtn;
+  for(int r = 0; r < rows; r++)
+  {
+    for(int c = 0; c < cols; c++)
+    {
+      rtn.push_back(emu.ram(addr + r * stride + c));
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn outside
+///  @return  Bytes outside a rectangle that are not the canary
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long outside(T6963Emulator& emu, uint16_t addr, uint8_t stride, uint8_t cols, uint8_t rows)
+{
+  unsigned long rtn = 0;
+  for(uint32_t a = 0; a < T6963_EMU_RAM_SIZE; a++)
+  {
+    bool in = a >= addr && a < addr + (uint32_t)rows * stride && (a - addr) % stride < cols;
+    rtn += (!in && emu.ram(a) != CANARY);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn roundTrip
+///  @brief  Random images, plain and delta, through draw, draw_P and drawAt
+///  @return  Failed cases
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long roundTrip(T6963Emulator& emu, T6963Image& img, int cases)
+{
+  unsigned long rtn = 0;
+  for(int t = 0; t < cases; t++)
+  {
+    uint8_t cols = 1 + rand() % AREA;
+    uint8_t rows = 1 + rand() % HEIGHT;
+    uint8_t col = rand() % (AREA - cols + 1);
+    uint8_t y = rand() % (HEIGHT - rows + 1);
+    uint16_t addr = GRAPHIC_HOME + y * AREA + col;
+    Bytes first = randomData(cols * rows);
+    Bytes second = first;
+    for(int k = rand() % 8; k > 0; k--)
+    {
+      int at = rand() % second.size();
+      int n = 1 + rand() % 20;
+      for(int j = at; j < at + n && j < (int)second.size(); j++)
+      {
+        second[j] = rand();
+      }
+    }
+    Bytes plain = encode(first, NULL, cols, rows);
+    Bytes delta = encode(second, &first, cols, rows);
+    bool ok;
+
+    canary(emu);
+    if(t % 3 == 0)
+    {
+      ok = img.draw(&plain[0], col, y);
+    }
+    else if(t % 3 == 1)
+    {
+      ok = img.draw_P(&plain[0], col, y);
+    }
+    else
+    {
+      ok = img.drawAt(&plain[0], addr, AREA);
+    }
+    ok = ok && img.getColumns() == cols && img.getRows() == rows && img.getFlags() == 0;
+    ok = ok && readRect(emu, addr, AREA, cols, rows) == first;
+    ok = ok && img.draw(&delta[0], col, y) && img.getFlags() == T6963_IMAGE_DELTA;
+    ok = ok && readRect(emu, addr, AREA, cols, rows) == second;
+    ok = ok && outside(emu, addr, AREA, cols, rows) == 0;
+    rtn += !ok;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn damage
+///  @brief  Break a valid image in one of several ways
+////////////////////////////////////////////////////////////////////////////////
+static void damage(Bytes& image, int how)
+{
+  uint16_t length = image[3] | (image[4] << 8);
+  if(how == 0 && length > 0)
+  {
+    image.resize(image.size() - 1 - rand() % length);  // cut short
+    length = image.size() - T6963_IMAGE_HEADER;
+  }
+  else if(how == 1)
+  {
+    Bytes extra;                                      // one code too many
+    int c = rand() % 3;
+    extra.push_back(c == 0 ? rand() % 4 : c == 1 ? 0xff - rand() % 4 : T6963_IMAGE_SKIP);
+    extra.push_back(rand());
+    extra.push_back(rand());
+    extra.push_back(rand());
+    image.insert(image.end(), extra.begin(), extra.begin() + 1 + rand() % 4);
+    length = image.size() - T6963_IMAGE_HEADER;
+  }
+  else if(how == 2 && length > 0)
+  {
+    image[T6963_IMAGE_HEADER + rand() % length] = rand();  // one byte changed
+  }
+  else if(how == 3)
+  {
+    length += (rand() % 2) ? 1 + rand() % 4 : -(1 + rand() % 4);  // wrong length
+    length = (length > image.size() - T6963_IMAGE_HEADER) ? image.size() - T6963_IMAGE_HEADER : length;
+    image.resize(T6963_IMAGE_HEADER + length);
+  }
+  else
+  {
+    for(size_t i = T6963_IMAGE_HEADER; i < image.size(); i++)
+    {
+      image[i] = rand();                              // noise
+    }
+  }
+  image[3] = length & 0xff;
+  image[4] = length >> 8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fuzz
+///  @brief  Damaged images against the reference decoder
+///  @return  Failed cases
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long fuzz(T6963Emulator& emu, T6963Image& img, int cases, unsigned long& rejected)
+{
+  unsigned long rtn = 0;
+  rejected = 0;
+  for(int t = 0; t < cases; t++)
+  {
+    uint8_t cols = 1 + rand() % 12;
+    uint8_t rows = 1 + rand() % 6;
+    uint16_t addr = GRAPHIC_HOME + (rand() % (HEIGHT - rows + 1)) * AREA + rand() % (AREA - cols + 1);
+    Bytes data = randomData(cols * rows);
+    Bytes image = encode(data, (t % 2) ? &data : NULL, cols, rows);
+    damage(image, t % 5);
+
+    Bytes want(cols * rows, CANARY);
+    bool valid = refDecode(image, want);
+    canary(emu);
+    bool ok = img.drawAt(&image[0], addr, AREA);
+    bool good = (ok == valid) && outside(emu, addr, AREA, cols, rows) == 0;
+    if(valid)
+    {
+      good = good && readRect(emu, addr, AREA, cols, rows) == want;
+    }
+    rejected += !ok;
+    rtn += !good;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn rejects
+///  @brief  Headers that must not draw at all
+///  @return  Failed cases
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long rejects(T6963Emulator& emu, T6963Image& img, unsigned long& cases)
+{
+  static const uint8_t image[] = { 0, 4, 2, 2, 0, 0xf9, 0x3c };
+  static const uint8_t noCols[] = { 0, 0, 2, 2, 0, 0xf9, 0x3c };
+  static const uint8_t noRows[] = { 0, 4, 0, 2, 0, 0xf9, 0x3c };
+  unsigned long rtn = 0;
+  canary(emu);
+  rtn += img.draw(image, AREA - 3, 0);        // off the right edge
+  rtn += img.draw(image, 0, HEIGHT - 1);      // off the bottom
+  rtn += img.draw(noCols, 0, 0);
+  rtn += img.draw(noRows, 0, 0);
+  rtn += img.drawAt(image, GRAPHIC_HOME, 3);  // wider than the stride
+  rtn += img.draw(NULL, 0, 0);
+  rtn += outside(emu, 0, 1, 0, 0) != 0;       // nothing written anywhere
+  rtn += !img.draw(image, AREA - 4, HEIGHT - 2);
+  rtn += readRect(emu, GRAPHIC_HOME + (HEIGHT - 2) * AREA + AREA - 4, AREA, 4, 2) != Bytes(8, 0x3c);
+  cases = 9;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn convert
+///  @brief  Run the converter on a picture and read back its array
+///  @return  The image bytes, empty on failure
+////////////////////////////////////////////////////////////////////////////////
+static Bytes convert(const char* tool, const char* args, const char* picture)
+{
+  Bytes rtn;
+  char cmd[512];
+  char line[512];
+  bool inArray = false;
+  snprintf(cmd, sizeof(cmd), "%s %s %s 2>/dev/null", tool, args, picture);
+  FILE* p = popen(cmd, "r");
+  while(p != NULL && fgets(line, sizeof(line), p) != NULL)
+  {
+    if(strchr(line, '{') != NULL)
+    {
+      inArray = true;
+    }
+    else if(strchr(line, '}') != NULL)
+    {
+      inArray = false;
+    }
+    else if(inArray)
+    {
+      char* s = line;
+      char* e;
+      for(long v = strtol(s, &e, 0); e != s; v = strtol(s, &e, 0))
+      {
+        rtn.push_back(v);
+        s = e + strspn(e, ", \t\r\n");
+      }
+    }
+  }
+  if(p != NULL)
+  {
+    pclose(p);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn converter
+///  @brief  Random pictures through the converter, plain and delta
+///  @return  Failed cases
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long converter(const char* tool, int cases)
+{
+  unsigned long rtn = 0;
+  char first[] = "/tmp/t6963_imageAXXXXXX";
+  char second[] = "/tmp/t6963_imageBXXXXXX";
+  int fa = mkstemp(first);
+  int fb = mkstemp(second);
+  if(fa < 0 || fb < 0)
+  {
+    return cases;
+  }
+  close(fa);
+  close(fb);
+  for(int t = 0; t < cases; t++)
+  {
+    uint8_t fw = (t % 2) ? 8 : 6;
+    int w = 1 + rand() % (AREA * 6);
+    int h = 1 + rand() % HEIGHT;
+    std::vector<uint8_t> pix[2];
+    for(int k = 0; k < 2; k++)
+    {
+      FILE* f = fopen(k == 0 ? first : second, "w");
+      fprintf(f, "P1\n%d %d\n", w, h);
+      for(int i = 0; i < w * h; i++)
+      {
+        uint8_t on = (k == 1 && rand() % 8 != 0) ? pix[0][i] : (i / 7 + rand() % 3) % 2;
+        pix[k].push_back(on);
+        fprintf(f, "%d%c", on, (i % w == w - 1) ? '\n' : ' ');
+      }
+      fclose(f);
+    }
+    char args[64];
+    char deltaArgs[600];
+    snprintf(args, sizeof(args), "-f %u", fw);
+    snprintf(deltaArgs, sizeof(deltaArgs), "-f %u -d %s", fw, first);
+    Bytes plain = convert(tool, args, first);
+    Bytes delta = convert(tool, deltaArgs, second);
+
+    T6963Emulator emu(240 / fw, HEIGHT, fw);
+    T6963 lcd(emu);
+    T6963Image img(lcd);
+    lcd.ports_init();
+    lcd.setFontWidth(fw);
+    lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+    lcd.setGraphicArea(240 / fw);
+    lcd.setDisplayMode(0, 1);
+    lcd.setPanelSize(240, HEIGHT);
+    lcd.clearGraphic();
+    bool ok = plain.size() > T6963_IMAGE_HEADER && delta.size() > T6963_IMAGE_HEADER;
+    for(int k = 0; ok && k < 2; k++)
+    {
+      ok = img.draw(k == 0 ? &plain[0] : &delta[0], 0, 0);
+      for(int i = 0; ok && i < w * h; i++)
+      {
+        ok = emu.pixel(i % w, i / w) == pix[k][i];
+      }
+    }
+    rtn += !ok;
+  }
+  unlink(first);
+  unlink(second);
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  T6963Emulator emu(AREA, HEIGHT, 6);
+  T6963 lcd(emu);
+  T6963Image img(lcd);
+  unsigned long cases;
+  unsigned long rejected;
+  lcd.ports_init();
+  lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+  lcd.setGraphicArea(AREA);
+  lcd.setPanelSize(AREA * 6, HEIGHT);
+  srand(22);
+
+  check("round trip, plain and delta", 300, roundTrip(emu, img, 300));
+  unsigned long bad = fuzz(emu, img, FUZZ_CASES, rejected);
+  check("damaged payloads against the reference", FUZZ_CASES, bad);
+  printf("  %lu rejected, %lu accepted\n", rejected, FUZZ_CASES - rejected);
+  bad = rejects(emu, img, cases);
+  check("headers that must not draw", cases, bad);
+  if(argc > 1)
+  {
+    check("converter, plain and delta", 40, converter(argv[1], 40));
+  }
+  check("emulator errors", 1, emu.counters.errors);
+  printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures == 0 ? 0 : 1;
+}
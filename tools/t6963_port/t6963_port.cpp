@@ -0,0 +1,364 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_port.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check the pin bus backends against the fake ports of the host
+///        Arduino.h and time them.  For several pin layouts every byte is
+///        written as data and as a command and read back, and the port
+///        registers are compared with the pin map.  Build once per backend
+///        from the top of the repository and compare the throughput lines:
+///
+///   g++ -O2 -DT6963_BUS=1 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_port/t6963_port.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp -o t6963_port
+///   g++ -O2 -DT6963_BUS=0 (the rest as above) -o t6963_port_digital
+///   g++ -O2 -DT6963_BUS=3 (the rest as above) -o t6963_port_fast
+///
+///        The fast backend has its pins fixed at compile time, so only the
+///        default layout is checked.  It also times the same byte loop
+///        through a T6963Bus vtable; a desktop CPU predicts that call, so
+///        expect no difference here.  The saving on an AVR shows in the
+///        code size and call overhead t6963_size.sh reports per backend.
+///
+///        Usage: t6963_port [-n bytes]
+///          -n  bytes to time (default 1000000)
+///        It also counts the pinMode / digitalWrite / digitalRead calls
+///        per byte of a long writeBlock, polled and with fixed delays.
+///        Exits non-zero if a layout does not map, if the port backend
+///        accepts a data pin that is not a pin, or if the bus direction
+///        is switched when no status read needs it.  On the host the
+///        digitalWrite path has no pin table lookups or PWM checks, so
+///        the ratio understates the difference on an AVR.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "T6963.h"
+#if T6963_BUS == T6963_BUS_FAST
+#include "T6963_fast.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class VirtualFast
+/// @brief The fast bus behind a T6963Bus vtable, as the external backend
+///        would drive it, to time what the direct calls save
+//////////////////////////////////////////////////////////////////////////////
+
+class VirtualFast : public T6963Bus
+{
+  public:
+    void write(uint8_t cd, uint8_t d) { T6963_FAST_BUS::write(cd, d); }
+    uint8_t read(uint8_t cd) { return T6963_FAST_BUS::read(cd); }
+};
+#endif
+
+#if T6963_BUS == T6963_BUS_PORT
+#define BACKEND                           "port"
+#elif T6963_BUS == T6963_BUS_DIGITAL
+#define BACKEND                           "digital"
+#elif T6963_BUS == T6963_BUS_FAST
+#define BACKEND                           "fast"
+#else
+#error build with -DT6963_BUS=0, 1 or 3
+#endif
+
+// d0-d7, wr, rd, ce, cd, res, fs
+struct Layout
+{
+  const char* name;
+  uint8_t pins[14];
+};
+
+static const Layout layouts[] =
+{
+  { "default, two runs",      { 4, 5, 6, 7, 8, 9, 10, 11, 2, 3, A5, A4, A3, 12 } },
+#if T6963_BUS != T6963_BUS_FAST
+  { "one whole port",         { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 } },
+  { "reversed",               { 11, 10, 9, 8, 7, 6, 5, 4, A0, A1, A2, A3, 0, 0 } },
+  { "three ports, shifted",   { A0, A1, A2, A3, 8, 9, 6, 7, 2, 3, 4, 5, 0, 0 } },
+#endif
+};
+
+#if T6963_BUS == T6963_BUS_FAST
+#define DISPLAY(p)                        T6963 lcd; (void)(p)
+#else
+#define DISPLAY(p)                        T6963 lcd(p[0], p[1], p[2], p[3], p[4], p[5], p[6], \
+                                                    p[7], p[8], p[9], p[10], p[11], p[12], p[13])
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn level
+///  @return  The level a pin drives
+////////////////////////////////////////////////////////////////////////////////
+static bool level(uint8_t pin)
+{
+  return (*portOutputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn isOutput
+///  @return  True if a pin is set as an output
+////////////////////////////////////////////////////////////////////////////////
+static bool isOutput(uint8_t pin)
+{
+  return (*portModeRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn busValue
+///  @return  The byte the data pins drive
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t busValue(const Layout& l)
+{
+  uint8_t rtn = 0;
+  for(int b = 0; b < 8; b++)
+  {
+    rtn |= level(l.pins[b]) << b;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn present
+///  @brief  Make the data pins read d
+////////////////////////////////////////////////////////////////////////////////
+static void present(const Layout& l, uint8_t d)
+{
+  for(int b = 0; b < 8; b++)
+  {
+    volatile uint8_t* in = portInputRegister(digitalPinToPort(l.pins[b]));
+    if(d & (1 << b))
+    {
+      *in |= digitalPinToBitMask(l.pins[b]);
+    }
+    else
+    {
+      *in &= ~digitalPinToBitMask(l.pins[b]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn resetPorts
+///  @brief  Clear the fake ports, then drive every pin the layout does not
+///          use high as an output, so a backend that touches them shows
+////////////////////////////////////////////////////////////////////////////////
+static void resetPorts(const Layout& l, uint8_t* spare, int& spares)
+{
+  spares = 0;
+  for(int port = HOST_PORT_B; port <= HOST_PORT_D; port++)
+  {
+    hostPort(port).out = 0;
+    hostPort(port).in = 0;
+    hostPort(port).mode = 0;
+  }
+  for(int p = 0; p < 20; p++)
+  {
+    bool used = false;
+    for(int i = 0; i < 14; i++)
+    {
+      used = used || (l.pins[i] == p && (p != 0 || i < 12));
+    }
+    if(!used)
+    {
+      *portModeRegister(digitalPinToPort(p)) |= digitalPinToBitMask(p);
+      *portOutputRegister(digitalPinToPort(p)) |= digitalPinToBitMask(p);
+      spare[spares++] = p;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn checkLayout
+///  @brief  Write and read every byte through one layout
+///  @return  Number of mismatches
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long checkLayout(const Layout& l)
+{
+  unsigned long rtn = 0;
+  uint8_t spare[20];
+  int spares;
+  const uint8_t* p = l.pins;
+  resetPorts(l, spare, spares);
+  DISPLAY(p);
+  rtn += !lcd.ports_init();
+  lcd.setReadyStrategy(T6963_READY_DELAY);   // no status reads: the pins hold the last byte
+
+  for(int d = 0; d < 256; d++)
+  {
+    bool strobesIdle;
+    lcd.writeDataByte(d);
+    strobesIdle = level(p[8]) && level(p[9]) && level(p[10]);
+    rtn += (busValue(l) != d || level(p[11]) || !strobesIdle);
+    lcd.writeCommandByte(d ^ 0xff);
+    strobesIdle = level(p[8]) && level(p[9]) && level(p[10]);
+    rtn += (busValue(l) != (d ^ 0xff) || !level(p[11]) || !strobesIdle);
+    for(int b = 0; b < 8; b++)
+    {
+      rtn += !isOutput(p[b]);
+    }
+
+    present(l, d ^ 0xa5);
+    rtn += (lcd.dataRead() != (d ^ 0xa5));
+    for(int b = 0; b < 8; b++)
+    {
+      rtn += isOutput(p[b]) || level(p[b]);   // input, no pull-up
+    }
+  }
+  for(int i = 0; i < spares; i++)
+  {
+    rtn += !level(spare[i]) || !isOutput(spare[i]);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn pinOps
+///  @brief  Count the pin function calls of one long writeBlock
+///  @param[out] ops  pinMode, digitalWrite and digitalRead calls per byte
+///  @return  False if the bus direction was switched without need: 17 or
+///           more pinMode calls per byte when polling (a status read
+///           between two writes costs 16, switching before every transfer
+///           24), any with no status reads, or any pin call at all on the
+///           register backends
+////////////////////////////////////////////////////////////////////////////////
+static bool pinOps(T6963& lcd, uint8_t strategy, double* ops)
+{
+  static uint8_t block[2560];
+  lcd.setReadyStrategy(strategy);
+  lcd.writeBlock(0, block, 8);        // settle the bus direction
+  hostPinOps().pinModes = 0;
+  hostPinOps().digitalWrites = 0;
+  hostPinOps().digitalReads = 0;
+  lcd.writeBlock(0, block, sizeof(block));
+  ops[0] = (double)hostPinOps().pinModes / sizeof(block);
+  ops[1] = (double)hostPinOps().digitalWrites / sizeof(block);
+  ops[2] = (double)hostPinOps().digitalReads / sizeof(block);
+  lcd.setReadyStrategy(T6963_READY_POLL);
+#if T6963_BUS == T6963_BUS_DIGITAL
+  return (strategy == T6963_READY_DELAY) ? ops[0] == 0 : ops[0] < 17;
+#else
+  return ops[0] == 0 && ops[1] == 0 && ops[2] == 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn seconds
+///  @return  Monotonic time in seconds
+////////////////////////////////////////////////////////////////////////////////
+static double seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int rtn = 0;
+  unsigned long count = 1000000;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      count = strtoul(argv[++i], NULL, 0);
+    }
+  }
+
+  for(size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++)
+  {
+    unsigned long bad = checkLayout(layouts[i]);
+    printf("%-8s %-24s %s (%lu mismatches)\n", BACKEND, layouts[i].name,
+           bad == 0 ? "ok" : "FAIL", bad);
+    rtn = (bad == 0) ? rtn : 1;
+  }
+
+#if T6963_BUS == T6963_BUS_PORT
+  // A data pin with no port bit must fail ports_init, not hang it
+  static const Layout badPin = { "data pin not a pin", { 4, 5, 6, 7, 8, 9, 10, 40,
+                                                        2, 3, A5, A4, A3, 12 } };
+  {
+    const uint8_t* p = badPin.pins;
+    DISPLAY(p);
+    bool ok = !lcd.ports_init();
+    printf("%-8s %-24s %s\n", BACKEND, badPin.name, ok ? "ok (refused)" : "FAIL");
+    rtn = ok ? rtn : 1;
+  }
+#endif
+
+  // Throughput on the default pins.  Every pin reads high, so each status
+  // poll finds the controller ready at once.
+  const Layout& l = layouts[0];
+  const uint8_t* p = l.pins;
+  uint8_t spare[20];
+  int spares;
+  static uint8_t block[256];
+  resetPorts(l, spare, spares);
+  DISPLAY(p);
+  lcd.ports_init();
+  present(l, 0xff);
+  for(size_t i = 0; i < sizeof(block); i++)
+  {
+    block[i] = i * 7;
+  }
+
+  double start = seconds();
+  for(unsigned long n = 0; n < count; n++)
+  {
+    lcd.writeDataByte(n);
+  }
+  double single = seconds() - start;
+  start = seconds();
+  for(unsigned long n = 0; n < count; n += sizeof(block))
+  {
+    lcd.writeBlock(0, block, sizeof(block));
+  }
+  double burst = seconds() - start;
+  printf("%-8s writeDataByte %10.0f bytes/s, writeBlock %10.0f bytes/s\n", BACKEND,
+         count / single, count / burst);
+
+  // Pin function calls per byte of a long writeBlock, polling STA3 and
+  // with fixed delays
+  static const char* const strategies[] = { "polled", "delayed" };
+  for(int i = 0; i < 2; i++)
+  {
+    double ops[3];
+    bool ok = pinOps(lcd, i == 0 ? T6963_READY_POLL : T6963_READY_DELAY, ops);
+    printf("%-8s writeBlock, %-7s %5.2f pinMode %5.2f digitalWrite %5.2f digitalRead"
+           " per byte  %s\n", BACKEND, strategies[i], ops[0], ops[1], ops[2],
+           ok ? "ok" : "FAIL");
+    rtn = ok ? rtn : 1;
+  }
+
+#if T6963_BUS == T6963_BUS_FAST
+  // Status read and data strobe per byte, called directly and through a
+  // vtable the compiler cannot see past
+  static VirtualFast virtualFast;
+  T6963Bus* volatile bus = &virtualFast;
+  T6963Bus* b = bus;
+  start = seconds();
+  for(unsigned long n = 0; n < count; n++)
+  {
+    while( (T6963_FAST_BUS::read(HIGH) & 0x03) != 0x03)
+    {
+    }
+    T6963_FAST_BUS::write(LOW, n);
+  }
+  double direct = seconds() - start;
+  start = seconds();
+  for(unsigned long n = 0; n < count; n++)
+  {
+    while( (b->read(HIGH) & 0x03) != 0x03)
+    {
+    }
+    b->write(LOW, n);
+  }
+  double virt = seconds() - start;
+  printf("%-8s direct    %10.0f bytes/s, T6963Bus vtable %10.0f bytes/s\n", BACKEND,
+         count / direct, count / virt);
+#endif
+  return rtn;
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+##############################################################################
+## @file t6963_size.sh
+## @copy Copyright (C) 2021 Will Cooke
+## @brief Code size of T6963.cpp for each bus backend.  Run from the top of
+##        the repository.  Uses $CXX (default g++) with the host Arduino.h;
+##        for target numbers point it at the AVR compiler and core, e.g.
+##
+##   CXX=avr-g++ SIZE=avr-size CXXFLAGS="-mmcu=atmega328p -DF_CPU=16000000L"
+##   INCLUDES="-I<core> -I<variant>" tools/t6963_port/t6963_size.sh
+##############################################################################
+
+CXX=${CXX:-g++}
+SIZE=${SIZE:-size}
+LIB=Arduino/T6963_lib/T6963_lib
+INCLUDES=${INCLUDES:--Itools/t6963_trace}
+OUT=${TMPDIR:-/tmp}/t6963_size.$$
+mkdir -p "$OUT" || exit 1
+status=0
+
+printf "%-10s %8s %8s %8s\n" backend text data bss
+for bus in 0:digital 1:port 2:external 3:fast
+do
+  n=${bus%%:*}
+  name=${bus#*:}
+  if $CXX -Os $CXXFLAGS -DT6963_BUS=$n $INCLUDES -I$LIB -c $LIB/T6963.cpp -o "$OUT/$name.o"
+  then
+    $SIZE "$OUT/$name.o" | awk -v name=$name 'NR == 2 { printf "%-10s %8s %8s %8s\n", name, $1, $2, $3 }'
+  else
+    status=1
+  fi
+done
+rm -rf "$OUT"
+exit $status
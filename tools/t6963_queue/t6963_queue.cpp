@@ -0,0 +1,382 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_queue.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Simulated main loop comparing blocking writes with T6963Queue.
+///        Each frame the application works for a while, then updates a
+///        strip of graphic rows: once with writeBlock, spinning on the
+///        status byte, and once by queueing the rows for pump() run from a
+///        timer tick.  A simulated clock charges every bus strobe and
+///        holds the controller busy after each byte, and the main loop
+///        time lost to the display is reported for both.  Build from the
+///        top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -DT6963_EMU_CMD_BUSY=0 -DT6963_EMU_DATA_BUSY=0
+///       -DT6963_EMU_AUTO_BUSY=0 -Itools/t6963_trace
+///       -IArduino/T6963_lib/T6963_lib tools/t6963_queue/t6963_queue.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_queue.cpp -o t6963_queue
+///
+///        Usage: t6963_queue [-f frames] [-r rows] [-w us] [-s ns] [-b ns]
+///                           [-t us] [-m bytes]
+///          -f  frames (default 100)
+///          -r  graphic rows of 40 bytes updated per frame (default 8)
+///          -w  application work per frame in microseconds (default 2000)
+///          -s  nanoseconds per bus strobe (default 500)
+///          -b  nanoseconds the controller is busy after a byte (default:
+///              a sweep from 0 to 4000)
+///          -t  timer tick running pump() in microseconds (default 20)
+///          -m  most bytes pump() sends per tick (default 16)
+///        For each busy time it prints the main loop time the display took
+///        per frame (the whole writeBlock, or the pump() ticks plus any
+///        wait for queue space), the longest single stall, status reads
+///        that found the controller busy, and the time the queue saved.
+///        The queue wins when a frame's update fits in the ring: the main
+///        loop never waits for space, writes to neighbouring rows merge
+///        into fewer bursts, and a busy spell longer than
+///        T6963_QUEUE_POLLS status reads is left to the next tick instead
+///        of spun on.  When a frame does not fit (try -r 16) the main loop
+///        waits for space and the queue can lose; its longest stall still
+///        stays a few ticks.
+///        Exits non-zero if RAM does not hold the last frame, a fence is
+///        missed, the emulator saw a bad sequence, or, with the default
+///        options, the queue saved no time at any busy time.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "T6963_emu.h"
+#include "T6963_queue.h"
+
+#if T6963_EMU_CMD_BUSY != 0 || T6963_EMU_DATA_BUSY != 0 || T6963_EMU_AUTO_BUSY != 0
+#error build with the emulator busy times 0: SimBus keeps the time
+#endif
+
+#define COLUMNS                          40
+#define GRAPHIC_HOME                 0x0800
+#define QUEUE_HEADER                      4     // write entry: op, address, length
+#define QUEUE_FENCE                       2     // fence entry: op, id
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class SimBus
+/// @brief The emulator on a simulated clock: each strobe takes strobe ns
+///        and the controller stays busy for busy ns after each write
+//////////////////////////////////////////////////////////////////////////////
+
+class SimBus : public T6963Bus
+{
+  public:
+    SimBus(T6963Emulator& emu, uint32_t strobe, uint32_t busy)
+      : emu(emu), strobe(strobe), busy(busy), clock(0), busyUntil(0), busyPolls(0) {}
+
+    void write(uint8_t cd, uint8_t d)
+    {
+      clock += strobe;
+      emu.write(cd, d);
+      busyUntil = clock + busy;
+    }
+
+    uint8_t read(uint8_t cd)
+    {
+      uint8_t rtn;
+      clock += strobe;
+      rtn = emu.read(cd);
+      if(cd != LOW && clock < busyUntil)
+      {
+        rtn &= ~(T6963_STA0 | T6963_STA1 | T6963_STA2 | T6963_STA3);
+        busyPolls++;
+      }
+      return rtn;
+    }
+
+    T6963Emulator& emu;
+    uint32_t strobe;
+    uint32_t busy;
+    uint64_t clock;           // ns
+    uint64_t busyUntil;
+    uint32_t busyPolls;       // status reads that found the controller busy
+};
+
+// Time the display took from the main loop
+struct Report
+{
+  uint64_t elapsed;         // ns for all frames
+  uint64_t blocked;         // ns the main loop was not running its own work
+  uint64_t longest;         // ns of the longest single stall
+  uint32_t busyPolls;
+  unsigned long bad;
+};
+
+struct Options
+{
+  int frames;
+  int rows;
+  uint32_t work;            // ns
+  uint32_t tick;            // ns
+  uint16_t maxBytes;
+};
+
+static int fencesSeen = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn onFence
+///  @brief  Queue callback, run from pump()
+////////////////////////////////////////////////////////////////////////////////
+static void onFence(uint8_t id)
+{
+  (void)id;
+  fencesSeen++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn fillRow
+///  @brief  The bytes of one row in one frame
+////////////////////////////////////////////////////////////////////////////////
+static void fillRow(uint8_t* row, int frame, int r)
+{
+  for(int c = 0; c < COLUMNS; c++)
+  {
+    row[c] = frame * 7 + r * 3 + c;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn checkRam
+///  @return  Bytes of the strip that do not hold the last frame
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long checkRam(T6963Emulator& emu, const Options& o)
+{
+  unsigned long rtn = 0;
+  uint8_t row[COLUMNS];
+  for(int r = 0; r < o.rows; r++)
+  {
+    fillRow(row, o.frames - 1, r);
+    for(int c = 0; c < COLUMNS; c++)
+    {
+      rtn += (emu.ram(GRAPHIC_HOME + r * COLUMNS + c) != row[c]);
+    }
+  }
+  return rtn + emu.counters.errors;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn runBlocking
+///  @brief  Work, then write each row with writeBlock
+////////////////////////////////////////////////////////////////////////////////
+static Report runBlocking(const Options& o, uint32_t strobe, uint32_t busy)
+{
+  Report rtn;
+  T6963Emulator emu(COLUMNS, 64, 6);
+  SimBus bus(emu, strobe, busy);
+  T6963 lcd(bus);
+  uint8_t row[COLUMNS];
+  memset(&rtn, 0, sizeof(rtn));
+  lcd.ports_init();
+  for(int f = 0; f < o.frames; f++)
+  {
+    bus.clock += o.work;
+    uint64_t start = bus.clock;
+    for(int r = 0; r < o.rows; r++)
+    {
+      fillRow(row, f, r);
+      lcd.writeBlock(GRAPHIC_HOME + r * COLUMNS, row, COLUMNS);
+    }
+    rtn.blocked += bus.clock - start;
+    rtn.longest = (bus.clock - start > rtn.longest) ? bus.clock - start : rtn.longest;
+  }
+  rtn.elapsed = bus.clock;
+  rtn.busyPolls = bus.busyPolls;
+  rtn.bad = checkRam(emu, o);
+  return rtn;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class Timer
+/// @brief Runs pump() every tick while the main loop works or waits,
+///        charging the time it takes to the main loop
+//////////////////////////////////////////////////////////////////////////////
+
+class Timer
+{
+  public:
+    Timer(SimBus& bus, T6963Queue& q, const Options& o, Report& r)
+      : bus(bus), q(q), o(o), r(r), next(o.tick) {}
+
+    // The main loop does its own work for ns
+    void work(uint64_t ns)
+    {
+      uint64_t end = bus.clock + ns;
+      while(next <= end)
+      {
+        uint64_t taken;
+        bus.clock = next;
+        taken = interrupt();
+        stall(taken);
+        end += taken;
+      }
+      bus.clock = end;
+    }
+
+    // The main loop has nothing to do until the next tick
+    void idle()
+    {
+      uint64_t start = bus.clock;
+      bus.clock = next;
+      interrupt();
+      stall(bus.clock - start);
+    }
+
+  private:
+    uint64_t interrupt()
+    {
+      uint64_t start = bus.clock;
+      q.pump(o.maxBytes);
+      while(next <= bus.clock)
+      {
+        next += o.tick;     // ticks missed while pumping run once
+      }
+      return bus.clock - start;
+    }
+
+    void stall(uint64_t ns)
+    {
+      r.blocked += ns;
+      r.longest = (ns > r.longest) ? ns : r.longest;
+    }
+
+    SimBus& bus;
+    T6963Queue& q;
+    const Options& o;
+    Report& r;
+    uint64_t next;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn runQueued
+///  @brief  Work, then queue each row; pump() drains from the timer tick
+////////////////////////////////////////////////////////////////////////////////
+static Report runQueued(const Options& o, uint32_t strobe, uint32_t busy)
+{
+  Report rtn;
+  T6963Emulator emu(COLUMNS, 64, 6);
+  SimBus bus(emu, strobe, busy);
+  T6963 lcd(bus);
+  T6963Queue q(lcd);
+  uint8_t row[COLUMNS];
+  uint8_t id = 0;
+  memset(&rtn, 0, sizeof(rtn));
+  lcd.ports_init();
+  fencesSeen = 0;
+  q.setCallback(onFence);
+  Timer timer(bus, q, o, rtn);
+  for(int f = 0; f < o.frames; f++)
+  {
+    timer.work(o.work);
+    for(int r = 0; r < o.rows; r++)
+    {
+      fillRow(row, f, r);
+      while(!q.write(GRAPHIC_HOME + r * COLUMNS, row, COLUMNS))
+      {
+        timer.idle();      // queue full
+      }
+    }
+    id = q.fence();
+  }
+  while(!q.isEmpty())
+  {
+    timer.idle();
+  }
+  rtn.elapsed = bus.clock;
+  rtn.busyPolls = bus.busyPolls;
+  rtn.bad = checkRam(emu, o) + !q.reached(id) + (fencesSeen != o.frames);
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  static const uint32_t sweep[] = { 0, 250, 500, 1000, 2000, 4000 };
+  int rtn = 0;
+  Options o = { 100, 8, 2000000, 20000, 16 };
+  uint32_t strobe = 500;
+  long busy = -1;
+  bool defaults = (argc < 3);
+  for(int i = 1; i + 1 < argc; i += 2)
+  {
+    unsigned long v = strtoul(argv[i + 1], NULL, 0);
+    if(strcmp(argv[i], "-f") == 0)
+    {
+      o.frames = v;
+    }
+    else if(strcmp(argv[i], "-r") == 0)
+    {
+      o.rows = (v > 64) ? 64 : v;
+    }
+    else if(strcmp(argv[i], "-w") == 0)
+    {
+      o.work = v * 1000;
+    }
+    else if(strcmp(argv[i], "-s") == 0)
+    {
+      strobe = v;
+    }
+    else if(strcmp(argv[i], "-b") == 0)
+    {
+      busy = v;
+    }
+    else if(strcmp(argv[i], "-t") == 0)
+    {
+      o.tick = v * 1000;
+    }
+    else if(strcmp(argv[i], "-m") == 0)
+    {
+      o.maxBytes = v;
+    }
+  }
+  if(o.frames < 1 || o.tick == 0 || o.maxBytes == 0)
+  {
+    fprintf(stderr, "frames, tick and bytes per tick must be positive\n");
+    return 2;
+  }
+
+  printf("%d frames of %d rows x %d bytes, %.0f us work each; strobe %u ns, "
+         "pump() every %.0f us, up to %u bytes\n", o.frames, o.rows, COLUMNS,
+         o.work / 1e3, strobe, o.tick / 1e3, o.maxBytes);
+  // Rows are consecutive, so a frame merges into one write entry per 255
+  // bytes, then a fence
+  int frame = o.rows * COLUMNS;
+  printf("a frame is %d queue bytes of %d\n",
+         frame + QUEUE_HEADER * ( (frame + 254) / 255) + QUEUE_FENCE, T6963_QUEUE_SIZE);
+  printf("%7s  %-28s  %-28s  %s\n", "", "blocking writeBlock", "queued, pump() on tick",
+         "main loop");
+  printf("%7s  %9s %9s %8s  %9s %9s %8s  %s\n", "busy ns", "us/frame", "max us",
+         "busy", "us/frame", "max us", "busy", "time saved");
+  for(size_t k = 0; k < sizeof(sweep) / sizeof(sweep[0]); k++)
+  {
+    uint32_t b = (busy >= 0) ? busy : sweep[k];
+    Report blocking = runBlocking(o, strobe, b);
+    Report queued = runQueued(o, strobe, b);
+    double saved = (double)blocking.blocked - (double)queued.blocked;
+    bool ok = (blocking.bad == 0 && queued.bad == 0 && (!defaults || saved >= 0));
+    printf("%7u  %9.1f %9.1f %8lu  %9.1f %9.1f %8lu  %+6.0f%%%s\n", b,
+           blocking.blocked / 1e3 / o.frames, blocking.longest / 1e3,
+           (unsigned long)blocking.busyPolls,
+           queued.blocked / 1e3 / o.frames, queued.longest / 1e3,
+           (unsigned long)queued.busyPolls,
+           blocking.blocked == 0 ? 0.0 : 100.0 * saved / blocking.blocked,
+           ok ? "" : "  FAIL");
+    if(!ok)
+    {
+      rtn = 1;
+    }
+    if(busy >= 0)
+    {
+      break;
+    }
+  }
+  printf("%s\n", rtn == 0 ? "PASS" : "FAIL");
+  return rtn;
+}
@@ -0,0 +1,263 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_shadow.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Shadow against the emulator.  A shadow that has not
+///        had begin() must be clean and ignore edits.  Then random text
+///        and graphic edits (single bytes, strings, runs through
+///        graphicRow, fills) are flushed and display RAM must equal a
+///        model of both planes.  The same edits are also sent straight
+///        to a second emulator with setAddress / dataWriteIncrement and
+///        the bus cycles compared.  Last, dirty spans just inside and
+///        just outside T6963_SHADOW_GAP must merge, or not.  Build from
+///        the top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_shadow/t6963_shadow.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_shadow.cpp -o t6963_shadow
+///
+///        Usage: t6963_shadow [-n frames]
+///          -n  frames of random edits (default 500)
+///        Exits non-zero if any check fails.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <vector>
+#include "T6963_emu.h"
+#include "T6963_shadow.h"
+
+#define WIDTH                           240
+#define HEIGHT                           64
+#define FONT_WIDTH                        8
+#define AREA            (WIDTH / FONT_WIDTH)
+#define ROWS                 (HEIGHT / 8)
+#define GRAPHIC_HOME                 0x0800
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn check
+///  @brief  Print one result row and count failures
+////////////////////////////////////////////////////////////////////////////////
+static void check(const char* name, bool ok)
+{
+  printf("%-44s %s\n", name, ok ? "ok" : "FAIL");
+  if(!ok)
+  {
+    failures++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setup
+///  @brief  Text at 0, graphics at GRAPHIC_HOME, both AREA bytes wide
+////////////////////////////////////////////////////////////////////////////////
+static void setup(T6963& lcd)
+{
+  lcd.ports_init();
+  lcd.setFontWidth(FONT_WIDTH);
+  lcd.setPanelSize(WIDTH, HEIGHT);
+  lcd.setTextHomeAddress(0);
+  lcd.setTextArea(AREA);
+  lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+  lcd.setGraphicArea(AREA);
+  lcd.setOrMode();
+  lcd.setDisplayMode(1, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn differ
+///  @return  Bytes of display RAM from home that differ from the model
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long differ(T6963Emulator& emu, uint16_t home, const Bytes& model)
+{
+  unsigned long rtn = 0;
+  for(size_t i = 0; i < model.size(); i++)
+  {
+    rtn += emu.ram(home + i) != model[i];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn checkUnbegun
+///  @brief  A shadow built over junk memory must be clean before begin()
+////////////////////////////////////////////////////////////////////////////////
+static void checkUnbegun(T6963& lcd, T6963Emulator& emu)
+{
+  static union
+  {
+    double align;
+    uint8_t raw[sizeof(T6963Shadow)];
+  } junk;
+  memset(junk.raw, 0x5a, sizeof(junk.raw));
+  T6963Shadow* shadow = new(junk.raw) T6963Shadow(lcd, HEIGHT);
+
+  check("before begin: not dirty", !shadow->isDirty());
+  shadow->markGraphicDirty(3, 0, 5);
+  shadow->writeText(1, 1, 0x21);
+  shadow->writeGraphic(1, 1, 0x21);
+  shadow->markAllDirty();
+  check("before begin: edits ignored", !shadow->isDirty());
+  uint32_t cycles = emu.counters.busCycles;
+  check("before begin: flush sends nothing",
+        shadow->flush() == 0 && emu.counters.busCycles == cycles);
+  shadow->~T6963Shadow();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int frames = 500;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      frames = atoi(argv[++i]);
+    }
+  }
+
+  T6963Emulator emu(AREA, HEIGHT, FONT_WIDTH);
+  T6963 lcd(emu);
+  T6963Emulator direct(AREA, HEIGHT, FONT_WIDTH);
+  T6963 lcd2(direct);
+  setup(lcd);
+  setup(lcd2);
+  checkUnbegun(lcd, emu);
+
+  // Both displays and the model start zeroed, so the shadow starts clean
+  Bytes text(AREA * ROWS);
+  Bytes graphic(AREA * HEIGHT);
+  Bytes textBuf(text.size());
+  Bytes graphicBuf(graphic.size());
+  lcd.clear();
+  lcd2.clear();
+  T6963Shadow shadow(lcd, HEIGHT);
+  check("begin", shadow.begin(&textBuf[0], &graphicBuf[0]) &&
+        shadow.textSize() == text.size() && shadow.graphicSize() == graphic.size());
+
+  srand(2);
+  uint32_t shadowCycles = 0;
+  uint32_t directCycles = 0;
+  unsigned long bad = 0;
+  for(int f = 0; f < frames; f++)
+  {
+    int edits = 1 + rand() % 40;
+    for(int e = 0; e < edits; e++)
+    {
+      int op = rand() % 100;
+      uint32_t before = direct.counters.busCycles;
+      if(op < 35)
+      {
+        uint8_t col = rand() % AREA;
+        uint8_t row = rand() % ROWS;
+        uint8_t c = rand() & 0x7f;
+        shadow.writeText(col, row, c);
+        text[row * AREA + col] = c;
+        lcd2.setAddress(row * AREA + col);
+        lcd2.dataWriteIncrement(c);
+      }
+      else if(op < 45)
+      {
+        char str[12];
+        uint8_t col = rand() % AREA;
+        uint8_t row = rand() % ROWS;
+        int len = 1 + rand() % (sizeof(str) - 1);
+        for(int i = 0; i < len; i++)
+        {
+          str[i] = 32 + rand() % 95;
+        }
+        str[len] = 0;
+        shadow.printText(col, row, str);
+        lcd2.setAddress(row * AREA + col);
+        for(int i = 0; i < len && col + i < AREA; i++)
+        {
+          text[row * AREA + col + i] = str[i] - 32;
+          lcd2.dataWriteIncrement(str[i] - 32);
+        }
+      }
+      else if(op < 80)
+      {
+        uint8_t col = rand() % AREA;
+        uint8_t row = rand() % HEIGHT;
+        uint8_t d = rand();
+        shadow.writeGraphic(col, row, d);
+        graphic[row * AREA + col] = d;
+        lcd2.setAddress(GRAPHIC_HOME + row * AREA + col);
+        lcd2.dataWriteIncrement(d);
+      }
+      else if(op < 99)
+      {
+        uint8_t row = rand() % HEIGHT;
+        uint8_t first = rand() % AREA;
+        uint8_t last = first + rand() % (AREA - first);
+        uint8_t* p = shadow.graphicRow(row);
+        lcd2.setAddress(GRAPHIC_HOME + row * AREA + first);
+        for(uint8_t col = first; col <= last; col++)
+        {
+          p[col] ^= 1 << (rand() % 8);
+          graphic[row * AREA + col] = p[col];
+          lcd2.dataWriteIncrement(p[col]);
+        }
+        shadow.markGraphicDirty(row, first, last);
+      }
+      else
+      {
+        uint8_t d = rand();
+        shadow.fillGraphic(d);
+        memset(&graphic[0], d, graphic.size());
+        lcd2.fill(GRAPHIC_HOME, d, graphic.size());
+      }
+      directCycles += direct.counters.busCycles - before;
+    }
+    uint32_t before = emu.counters.busCycles;
+    shadow.flush();
+    shadowCycles += emu.counters.busCycles - before;
+    bad += shadow.isDirty();
+    bad += differ(emu, 0, text) + differ(emu, GRAPHIC_HOME, graphic);
+    bad += differ(direct, 0, text) + differ(direct, GRAPHIC_HOME, graphic);
+  }
+  bad += emu.counters.errors + direct.counters.errors;
+  char line[64];
+  snprintf(line, sizeof(line), "random edits, %d frames, RAM matches", frames);
+  check(line, bad == 0);
+  printf("  bus cycles: shadow flush %lu, direct writes %lu (%.2fx)\n",
+         (unsigned long)shadowCycles, (unsigned long)directCycles,
+         shadowCycles ? (double)directCycles / shadowCycles : 0.0);
+  check("shadow flush uses fewer bus cycles", shadowCycles < directCycles);
+
+  // A row's edits widen one span.  The spans of neighbouring rows go as
+  // one burst when no more than T6963_SHADOW_GAP clean bytes lie between
+  shadow.writeGraphic(2, 4, graphic[4 * AREA + 2] ^ 0x81);
+  shadow.writeGraphic(8, 4, graphic[4 * AREA + 8] ^ 0x81);
+  check("one row's edits make one span", shadow.flush() == 7);
+  shadow.writeGraphic(AREA - 3, 5, graphic[5 * AREA + AREA - 3] ^ 0x81);
+  shadow.writeGraphic(T6963_SHADOW_GAP - 2, 6, graphic[6 * AREA + T6963_SHADOW_GAP - 2] ^ 0x81);
+  check("row spans within the gap merge", shadow.flush() == T6963_SHADOW_GAP + 2);
+  shadow.writeGraphic(AREA - 3, 7, graphic[7 * AREA + AREA - 3] ^ 0x81);
+  shadow.writeGraphic(T6963_SHADOW_GAP - 1, 8, graphic[8 * AREA + T6963_SHADOW_GAP - 1] ^ 0x81);
+  check("row spans past the gap stay apart", shadow.flush() == 2);
+  for(uint8_t r = 4; r <= 8; r++)
+  {
+    for(uint8_t col = 0; col < AREA; col++)
+    {
+      graphic[r * AREA + col] = shadow.readGraphic(col, r);
+    }
+  }
+  shadow.markAllDirty();
+  check("markAllDirty resends both planes",
+        shadow.flush() == text.size() + graphic.size() &&
+        differ(emu, 0, text) + differ(emu, GRAPHIC_HOME, graphic) == 0 &&
+        emu.counters.errors == 0);
+
+  printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures != 0;
+}
@@ -0,0 +1,291 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_sprite.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Sprite against a pixel model on the emulator and
+///        measure what a move costs.  Random sprites (any size up to the
+///        largest, with and without a mask, in all four ROPs) walk,
+///        jump, hang off every edge, hide, change image and change ROP
+///        over a random background, with 6 and 8 pixel bytes.  After
+///        every step each graphic byte must equal the model, the text
+///        plane must be untouched, and after hide the background must be
+///        back exactly.  Build from the top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_sprite/t6963_sprite.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_sprite.cpp -o t6963_sprite
+///
+///        Usage: t6963_sprite [-n steps]
+///          -n  steps per sprite and ROP (default 300)
+///        Prints bus bytes per one pixel move against hiding and
+///        redrawing.  Exits non-zero if any byte differs from the model.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "T6963_emu.h"
+#include "T6963_sprite.h"
+
+#define WIDTH                           240
+#define HEIGHT                           64
+#define GRAPHIC_HOME                 0x0800
+#define SPRITES                          12
+
+typedef std::vector<uint8_t> Bytes;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @struct Image
+/// @brief  A sprite bitmap and mask, rows (w + 7) / 8 bytes, MSB leftmost
+//////////////////////////////////////////////////////////////////////////////
+
+struct Image
+{
+  uint8_t w;
+  uint8_t h;
+  Bytes bits;
+  Bytes mask;                   // empty for none
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn randomImage
+///  @brief  A random sprite, masked or not
+////////////////////////////////////////////////////////////////////////////////
+static Image randomImage(bool masked)
+{
+  Image rtn;
+  rtn.w = 1 + rand() % T6963_SPRITE_MAX_W;
+  rtn.h = 1 + rand() % T6963_SPRITE_MAX_H;
+  rtn.bits.resize( (rtn.w + 7) / 8 * rtn.h);
+  for(size_t i = 0; i < rtn.bits.size(); i++)
+  {
+    rtn.bits[i] = rand();
+    if(masked)
+    {
+      rtn.mask.push_back(rand() | rand());
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn bitAt
+///  @return  Pixel x, y of a bitmap, rows (w + 7) / 8 bytes
+////////////////////////////////////////////////////////////////////////////////
+static bool bitAt(const Bytes& bits, uint8_t w, int x, int y)
+{
+  return (bits[y * ( (w + 7) / 8) + x / 8] >> (7 - x % 8)) & 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn expected
+///  @brief  The graphic plane with a sprite at x, y over a background,
+///          worked out pixel by pixel.  Bits above the font width keep
+///          the background.
+////////////////////////////////////////////////////////////////////////////////
+static Bytes expected(const Bytes& bg, uint8_t fw, const Image* img, uint8_t rop, int x, int y)
+{
+  Bytes rtn(bg);
+  uint8_t area = WIDTH / fw;
+  for(int py = 0; img != NULL && py < HEIGHT; py++)
+  {
+    for(int px = 0; px < area * fw; px++)
+    {
+      int sx = px - x;
+      int sy = py - y;
+      if(sx >= 0 && sx < img->w && sy >= 0 && sy < img->h &&
+         (img->mask.empty() || bitAt(img->mask, img->w, sx, sy)))
+      {
+        uint8_t& d = rtn[py * area + px / fw];
+        uint8_t bit = 1 << (fw - 1 - px % fw);
+        bool b = (d & bit) != 0;
+        bool s = bitAt(img->bits, img->w, sx, sy);
+        bool on = (rop == T6963_ROP_OR) ? b || s : (rop == T6963_ROP_XOR) ? b != s :
+                  (rop == T6963_ROP_AND) ? b && s : s;
+        d = on ? (d | bit) : (d & ~bit);
+      }
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn graphic
+///  @return  The graphic plane read from display RAM
+////////////////////////////////////////////////////////////////////////////////
+static Bytes graphic(T6963Emulator& emu, uint8_t fw)
+{
+  Bytes rtn((WIDTH / fw) * HEIGHT);
+  for(size_t i = 0; i < rtn.size(); i++)
+  {
+    rtn[i] = emu.ram(GRAPHIC_HOME + i);
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn differ
+///  @return  Bytes that differ between two planes
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long differ(const Bytes& a, const Bytes& b)
+{
+  unsigned long rtn = 0;
+  for(size_t i = 0; i < a.size(); i++)
+  {
+    rtn += a[i] != b[i];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int rtn = 0;
+  int steps = 300;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      steps = atoi(argv[++i]);
+    }
+  }
+
+  printf("%4s %8s %8s %8s %10s %10s %8s\n", "font", "steps", "bad", "hidden",
+         "move bus", "redraw bus", "result");
+  for(uint8_t fw = 6; fw <= 8; fw += 2)
+  {
+    uint8_t area = WIDTH / fw;
+    T6963Emulator emu(area, HEIGHT, fw);
+    T6963 lcd(emu);
+    lcd.ports_init();
+    lcd.setFontWidth(fw);
+    lcd.setPanelSize(WIDTH, HEIGHT);
+    lcd.setTextHomeAddress(0);
+    lcd.setTextArea(area);
+    lcd.setGraphicHomeAddress(GRAPHIC_HOME);
+    lcd.setGraphicArea(area);
+    lcd.setXorMode();
+    lcd.setDisplayMode(1, 1);
+    srand(25 + fw);
+
+    Bytes bg(area * HEIGHT);
+    Bytes text(area * HEIGHT / 8);
+    for(size_t i = 0; i < bg.size(); i++)
+    {
+      bg[i] = rand() & ( (1 << fw) - 1);
+      emu.ram(GRAPHIC_HOME + i, bg[i]);
+    }
+    for(size_t i = 0; i < text.size(); i++)
+    {
+      text[i] = rand() & 0x3f;
+      emu.ram(i, text[i]);
+    }
+
+    T6963Sprite sprite(lcd);
+    unsigned long bad = 0;
+    unsigned long hidden = 0;
+    unsigned long total = 0;
+    for(int n = 0; n < SPRITES; n++)
+    {
+      Image imgs[2] = { randomImage(n % 2), randomImage(n % 3 == 0) };
+      uint8_t which = 0;
+      for(uint8_t rop = 0; rop <= T6963_ROP_COPY; rop++)
+      {
+        const Image* img = &imgs[which];
+        bool shown = false;
+        int x = 0;
+        int y = 0;
+        bad += !sprite.setImage_P(&img->bits[0], img->w, img->h,
+                                  img->mask.empty() ? NULL : &img->mask[0]);
+        sprite.setRop(rop);
+        for(int s = 0; s < steps; s++)
+        {
+          int op = rand() % 100;
+          if(op < 3)
+          {
+            sprite.hide();
+            shown = false;
+          }
+          else if(op < 6)
+          {
+            which ^= 1;                                   // change image in place
+            img = &imgs[which];
+            sprite.setImage_P(&img->bits[0], img->w, img->h,
+                              img->mask.empty() ? NULL : &img->mask[0]);
+          }
+          else if(op < 8)
+          {
+            uint8_t other = (rop + 1 + rand() % 3) % 4;   // change ROP in place, and back
+            sprite.setRop(other);
+            bad += differ(graphic(emu, fw), expected(bg, fw, shown ? img : NULL, other, x, y));
+            sprite.setRop(rop);
+          }
+          else
+          {
+            if(op < 14)
+            {
+              x = rand() % (WIDTH + 2 * T6963_SPRITE_MAX_W) - T6963_SPRITE_MAX_W - 2;
+              y = rand() % (HEIGHT + 2 * T6963_SPRITE_MAX_H) - T6963_SPRITE_MAX_H - 2;
+            }
+            else
+            {
+              x += rand() % 5 - 2;
+              y += rand() % 5 - 2;
+            }
+            bad += !sprite.moveTo(x, y);
+            shown = true;
+          }
+          bad += sprite.isVisible() != shown;
+          bad += shown && (sprite.getX() != x || sprite.getY() != y);
+          bad += differ(graphic(emu, fw), expected(bg, fw, shown ? img : NULL, rop, x, y));
+          total++;
+        }
+        sprite.hide();
+        hidden += differ(graphic(emu, fw), bg);
+      }
+    }
+    for(size_t i = 0; i < text.size(); i++)
+    {
+      bad += emu.ram(i) != text[i];
+    }
+    bad += emu.counters.errors;
+
+    // A one pixel move against taking the sprite off and drawing it again
+    static const uint8_t box[32] = { 0xff, 0xff, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01,
+                                     0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01,
+                                     0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01,
+                                     0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0xff, 0xff };
+    sprite.setImage_P(box, 16, 16);
+    sprite.setRop(T6963_ROP_XOR);
+    sprite.moveTo(100, 20);
+    sprite.resetCounters();
+    for(int i = 1; i <= 20; i++)
+    {
+      sprite.moveTo(100 + i, 20 + i / 2);
+    }
+    double move = sprite.getBusBytes() / 20.0;
+    sprite.resetCounters();
+    for(int i = 1; i <= 20; i++)
+    {
+      sprite.hide();
+      sprite.moveTo(120 - i, 30 - i / 2);
+    }
+    double redraw = sprite.getBusBytes() / 20.0;
+    sprite.hide();
+    hidden += differ(graphic(emu, fw), bg);
+
+    bool ok = (bad == 0 && hidden == 0 && move < redraw);
+    printf("%4u %8lu %8lu %8lu %10.1f %10.1f %8s\n", fw, total, bad, hidden, move, redraw,
+           ok ? "ok" : "FAIL");
+    if(!ok)
+    {
+      rtn = 1;
+    }
+  }
+  printf("%s\n", rtn == 0 ? "PASS" : "FAIL");
+  return rtn;
+}
@@ -0,0 +1,626 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_term.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check T6963Terminal against a screen model on the emulator and
+///        measure its throughput.  Random streams of text, control
+///        characters, well formed and malformed escape sequences are fed
+///        through write(c), write(buf, n) and pump(), with and without an
+///        attribute ring, on a ring small enough to wrap often.  After
+///        every chunk the visible text, the attributes and the hardware
+///        cursor must equal the model.  Then fixed SGR sequences with
+///        several parameters, and lines of text to time.  Build from the
+///        top of the repository with
+///
+///   g++ -O2 -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_term/t6963_term.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_term.cpp -o t6963_term
+///
+///        Usage: t6963_term [-n chunks] [-s ns]
+///          -n  random chunks per run (default 3000)
+///          -s  nanoseconds per bus cycle for the throughput (default 500)
+///        Bus cycles include the status reads that found the controller
+///        busy, so the characters per second figure counts the emulated
+///        busy times.  Exits non-zero if any check fails.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "T6963_emu.h"
+#include "T6963_term.h"
+
+#define WIDTH                           240
+#define HEIGHT                           64
+#define FONT_WIDTH                        6
+#define COLS            (WIDTH / FONT_WIDTH)
+#define ROWS                 (HEIGHT / 8)
+#define RING_ROWS                        20
+#define ATTR_BASE                    0x0400
+
+static int failures = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn check
+///  @brief  Print one result row and count failures
+////////////////////////////////////////////////////////////////////////////////
+static void check(const char* name, bool ok)
+{
+  printf("%-48s %s\n", name, ok ? "ok" : "FAIL");
+  if(!ok)
+  {
+    failures++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class Model
+/// @brief The screen the terminal documents: codes and attributes per
+///        cell, the cursor and the escape parser, written independently
+///        of the ring
+//////////////////////////////////////////////////////////////////////////////
+
+class Model
+{
+  public:
+    Model() : attribute(T6963_ATTR_NORMAL), state(0) { clear(); }
+
+    void put(uint8_t c);
+    uint8_t text[ROWS][COLS];
+    uint8_t attr[ROWS][COLS];
+    int col;                    // COLS = wrap before the next character
+    int row;
+    uint8_t attribute;
+
+  private:
+    void clear();
+    void blank(int r, int c, int n);
+    void newline();
+    void final(uint8_t c);
+    void rendition(int n);
+    int param(size_t i, int dflt);
+    int column() { return col < COLS ? col : COLS - 1; }
+    void gotoXY(int c, int r);
+
+    int state;                  // 0 text, 1 ESC, 2 CSI
+    std::vector<int> params;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn blank
+///  @brief  Blank n cells of a row from column c, attributes normal
+////////////////////////////////////////////////////////////////////////////////
+void Model::blank(int r, int c, int n)
+{
+  for(int i = c; i < c + n && i < COLS; i++)
+  {
+    text[r][i] = 0;
+    attr[r][i] = T6963_ATTR_NORMAL;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn clear
+///  @brief  Blank the screen and home the cursor
+////////////////////////////////////////////////////////////////////////////////
+void Model::clear()
+{
+  for(int r = 0; r < ROWS; r++)
+  {
+    blank(r, 0, COLS);
+  }
+  col = 0;
+  row = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn gotoXY
+///  @brief  Move the cursor, clamped to the screen
+////////////////////////////////////////////////////////////////////////////////
+void Model::gotoXY(int c, int r)
+{
+  col = c < 0 ? 0 : c < COLS ? c : COLS - 1;
+  row = r < 0 ? 0 : r < ROWS ? r : ROWS - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn newline
+///  @brief  Column 0 of the next row, scrolling at the bottom
+////////////////////////////////////////////////////////////////////////////////
+void Model::newline()
+{
+  col = 0;
+  if(row + 1 < ROWS)
+  {
+    row++;
+  }
+  else
+  {
+    memmove(text[0], text[1], sizeof(text) - sizeof(text[0]));
+    memmove(attr[0], attr[1], sizeof(attr) - sizeof(attr[0]));
+    blank(ROWS - 1, 0, COLS);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn param
+///  @return  Parameter i, or dflt if missing or zero
+////////////////////////////////////////////////////////////////////////////////
+int Model::param(size_t i, int dflt)
+{
+  return (i < params.size() && params[i] != 0) ? params[i] : dflt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn rendition
+///  @brief  Apply one SGR parameter
+////////////////////////////////////////////////////////////////////////////////
+void Model::rendition(int n)
+{
+  uint8_t blink = attribute & T6963_ATTR_BLINK;
+  if(n == 0)
+  {
+    attribute = T6963_ATTR_NORMAL;
+  }
+  else if(n == 5)
+  {
+    attribute |= T6963_ATTR_BLINK;
+  }
+  else if(n == 7)
+  {
+    attribute = blink | T6963_ATTR_REVERSE;
+  }
+  else if(n == 8)
+  {
+    attribute = blink | T6963_ATTR_INHIBIT;
+  }
+  else if(n == 25)
+  {
+    attribute &= ~T6963_ATTR_BLINK;
+  }
+  else if(n == 27 || n == 28)
+  {
+    attribute = blink;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn final
+///  @brief  The final character of an ESC [ sequence
+////////////////////////////////////////////////////////////////////////////////
+void Model::final(uint8_t c)
+{
+  int n = param(0, 1);
+  int c0 = column();
+  if(params.size() > T6963_TERM_PARAMS)
+  {
+    params.resize(T6963_TERM_PARAMS);
+  }
+  switch(c)
+  {
+    case 'A':
+      gotoXY(c0, row - n);
+      break;
+    case 'B':
+      gotoXY(c0, row + n);
+      break;
+    case 'C':
+      gotoXY(c0 + n, row);
+      break;
+    case 'D':
+      gotoXY(c0 - n, row);
+      break;
+    case 'H':
+    case 'f':
+      gotoXY(param(1, 1) - 1, n - 1);
+      break;
+    case 'J':
+      if(param(0, 0) == 2)
+      {
+        clear();
+      }
+      else if(param(0, 0) == 1)
+      {
+        for(int r = 0; r < row; r++)
+        {
+          blank(r, 0, COLS);
+        }
+        blank(row, 0, c0 + 1);
+      }
+      else
+      {
+        blank(row, col, COLS - col);
+        for(int r = row + 1; r < ROWS; r++)
+        {
+          blank(r, 0, COLS);
+        }
+      }
+      break;
+    case 'K':
+      if(param(0, 0) == 2)
+      {
+        blank(row, 0, COLS);
+      }
+      else if(param(0, 0) == 1)
+      {
+        blank(row, 0, c0 + 1);
+      }
+      else
+      {
+        blank(row, col, COLS - col);
+      }
+      break;
+    case 'm':
+      rendition(param(0, 0));
+      for(size_t i = 1; i < params.size(); i++)
+      {
+        rendition(param(i, 0));
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn put
+///  @brief  Feed one input byte
+////////////////////////////////////////////////////////////////////////////////
+void Model::put(uint8_t c)
+{
+  if(state == 1)
+  {
+    state = 0;
+    if(c == '[')
+    {
+      state = 2;
+      params.clear();
+    }
+    else if(c == 'c')
+    {
+      attribute = T6963_ATTR_NORMAL;
+      clear();
+    }
+  }
+  else if(state == 2)
+  {
+    if(c >= '0' && c <= '9')
+    {
+      if(params.empty())
+      {
+        params.push_back(0);
+      }
+      int v = params.back() * 10 + (c - '0');
+      params.back() = v > 255 ? 255 : v;
+    }
+    else if(c == ';')
+    {
+      if(params.empty())
+      {
+        params.push_back(0);
+      }
+      params.push_back(0);
+    }
+    else if(c != '?')
+    {
+      state = 0;
+      final(c);
+    }
+  }
+  else if(c >= ' ' && c < 0x80)
+  {
+    if(col >= COLS)
+    {
+      newline();
+    }
+    text[row][col] = c - ' ';
+    attr[row][col] = attribute;
+    col++;
+  }
+  else if(c == 8)
+  {
+    col = column();
+    col -= (col > 0);
+  }
+  else if(c == 9)
+  {
+    col = (col | 7) + 1;
+    col = col < COLS ? col : COLS - 1;
+  }
+  else if(c == 10)
+  {
+    newline();
+  }
+  else if(c == 12)
+  {
+    clear();
+  }
+  else if(c == 13)
+  {
+    col = 0;
+  }
+  else if(c == 27)
+  {
+    state = 1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class ByteStream
+/// @brief A Stream over a string, for pump()
+//////////////////////////////////////////////////////////////////////////////
+
+class ByteStream : public Stream
+{
+  public:
+    ByteStream(const std::string& s) : s(s), at(0) {}
+    int available() { return s.size() - at; }
+    int read() { return at < s.size() ? (uint8_t)s[at++] : -1; }
+    int peek() { return at < s.size() ? (uint8_t)s[at] : -1; }
+    size_t write(uint8_t) { return 0; }
+
+  private:
+    std::string s;
+    size_t at;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn setup
+///  @brief  Text area COLS wide, in text attribute mode when attrs is set
+////////////////////////////////////////////////////////////////////////////////
+static void setup(T6963& lcd, bool attrs)
+{
+  lcd.ports_init();
+  lcd.setFontWidth(FONT_WIDTH);
+  lcd.setPanelSize(WIDTH, HEIGHT);
+  lcd.setTextArea(COLS);
+  lcd.setGraphicArea(COLS);
+  if(attrs)
+  {
+    lcd.setTextAttributeMode();
+    lcd.setDisplayMode(1, 1);
+  }
+  else
+  {
+    lcd.setOrMode();
+    lcd.setDisplayMode(1, 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn randomChunk
+///  @return  Random terminal input: text runs, controls, escape sequences
+///           (mostly well formed) and bytes above 0x7f
+////////////////////////////////////////////////////////////////////////////////
+static std::string randomChunk()
+{
+  static const char finals[] = "ABCDHfJKmmmz\n";
+  static const int sgr[] = { 0, 1, 5, 7, 8, 25, 27, 28 };
+  std::string rtn;
+  int tokens = 1 + rand() % 6;
+  for(int t = 0; t < tokens; t++)
+  {
+    int op = rand() % 100;
+    if(op < 40)
+    {
+      int n = 1 + rand() % (2 * COLS);
+      for(int i = 0; i < n; i++)
+      {
+        rtn += (char)(' ' + rand() % 95);
+      }
+    }
+    else if(op < 60)
+    {
+      static const char controls[] = { 8, 9, 10, 10, 13, 13, 7, 0, (char)0x85 };
+      rtn += controls[rand() % sizeof(controls)];
+    }
+    else if(op < 62)
+    {
+      rtn += (rand() % 4 == 0) ? "\x1b" "c" : "\f";
+    }
+    else if(op < 64)
+    {
+      rtn += '\x1b';
+      rtn += (char)(' ' + rand() % 95);
+    }
+    else
+    {
+      char f = finals[rand() % (sizeof(finals) - 1)];
+      int n = rand() % 11;
+      rtn += "\x1b[";
+      if(rand() % 8 == 0)
+      {
+        rtn += '?';
+      }
+      for(int i = 0; i < n; i++)
+      {
+        if(i > 0)
+        {
+          rtn += ';';
+        }
+        int v = (f == 'm') ? sgr[rand() % 8] : rand() % (rand() % 8 == 0 ? 400 : 12);
+        if(v != 0 || rand() % 2)
+        {
+          rtn += std::to_string(v);
+        }
+      }
+      rtn += f;
+    }
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn differ
+///  @return  Cells, attributes and cursor differences between the
+///           display and the model
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long differ(T6963Emulator& emu, T6963Terminal& term, const Model& m, bool attrs)
+{
+  unsigned long rtn = 0;
+  for(int r = 0; r < ROWS; r++)
+  {
+    for(int c = 0; c < COLS; c++)
+    {
+      rtn += emu.ram(emu.getTextHome() + r * COLS + c) != m.text[r][c];
+      rtn += attrs && emu.ram(emu.getGraphicHome() + r * COLS + c) != m.attr[r][c];
+    }
+  }
+  int c = m.col < COLS ? m.col : COLS - 1;
+  rtn += emu.getTextHome() != term.getHome();
+  rtn += emu.getCursor() != ( (m.row << 8) | c);
+  rtn += term.getColumn() != c || term.getRow() != m.row;
+  rtn += term.getAttribute() != m.attribute;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn randomRun
+///  @brief  Feed random chunks to a terminal and the model
+////////////////////////////////////////////////////////////////////////////////
+static void randomRun(bool attrs, int chunks)
+{
+  T6963Emulator emu(COLS, HEIGHT, FONT_WIDTH);
+  T6963 lcd(emu);
+  setup(lcd, attrs);
+  T6963Terminal term(lcd, 0, RING_ROWS * COLS, ROWS);
+  if(attrs)
+  {
+    term.setAttributeBase(ATTR_BASE);
+  }
+  bool begun = term.begin();
+  Model m;
+  unsigned long bad = 0;
+  unsigned long bytes = 0;
+  for(int i = 0; i < chunks && begun; i++)
+  {
+    std::string s = randomChunk();
+    int how = rand() % 3;
+    if(how == 0)
+    {
+      bad += term.write( (const uint8_t*)s.data(), s.size()) != s.size();
+    }
+    else if(how == 1)
+    {
+      for(size_t k = 0; k < s.size(); k++)
+      {
+        bad += term.write( (uint8_t)s[k]) != 1;
+      }
+    }
+    else
+    {
+      ByteStream in(s);
+      bad += term.pump(in) != s.size();
+    }
+    for(size_t k = 0; k < s.size(); k++)
+    {
+      m.put(s[k]);
+    }
+    bytes += s.size();
+    bad += differ(emu, term, m, attrs);
+  }
+  bad += emu.counters.errors;
+
+  char line[80];
+  snprintf(line, sizeof(line), "random input %s attributes, %lu bytes",
+           attrs ? "with" : "without", bytes);
+  check(line, begun && bad == 0);
+  printf("  scrolls %lu, ring wraps %lu\n", (unsigned long)term.getScrolls(),
+         (unsigned long)term.getWraps());
+  snprintf(line, sizeof(line), "ring wrapped %s attributes", attrs ? "with" : "without");
+  check(line, term.getWraps() > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn sgr
+///  @return  The attribute after a sequence from normal
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t sgr(T6963Terminal& term, const char* seq)
+{
+  term.print("\x1b[0m");
+  term.print(seq);
+  return term.getAttribute();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int chunks = 3000;
+  double ns = 500;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      chunks = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      ns = atof(argv[++i]);
+    }
+  }
+
+  srand(10);
+  randomRun(false, chunks);
+  randomRun(true, chunks);
+
+  T6963Emulator emu(COLS, HEIGHT, FONT_WIDTH);
+  T6963 lcd(emu);
+  setup(lcd, true);
+  T6963Terminal term(lcd, 0, RING_ROWS * COLS, ROWS);
+  term.setAttributeBase(ATTR_BASE);
+  check("begin", term.begin());
+  check("ESC[0;1;7m is reverse", sgr(term, "\x1b[0;1;7m") == T6963_ATTR_REVERSE);
+  check("ESC[5;7m is blink and reverse",
+        sgr(term, "\x1b[5;7m") == (T6963_ATTR_BLINK | T6963_ATTR_REVERSE));
+  check("ESC[1;2;3;4;5;6;8m applies the seventh",
+        sgr(term, "\x1b[1;2;3;4;5;6;8m") == (T6963_ATTR_BLINK | T6963_ATTR_INHIBIT));
+  check("ESC[5;7;27m ends blinking, not reversed",
+        sgr(term, "\x1b[5;7;27m") == T6963_ATTR_BLINK);
+  check("ESC[m is normal", sgr(term, "\x1b[7m\x1b[m") == T6963_ATTR_NORMAL);
+  if(T6963_TERM_PARAMS < 9)
+  {
+    check("parameters past T6963_TERM_PARAMS are dropped",
+          sgr(term, "\x1b[0;0;0;0;0;0;0;0;7m") == T6963_ATTR_NORMAL);
+  }
+  term.print("\x1b[2J\x1b[7mX");
+  check("reverse reaches the attribute ring",
+        emu.ram(emu.getGraphicHome()) == T6963_ATTR_REVERSE && emu.ram(emu.getTextHome()) == 'X' - ' ');
+  check("no emulator errors", emu.counters.errors == 0);
+
+  // Throughput: lines of 38 characters and CR LF, the usual log output
+  static const char text[] = "The quick brown fox jumps over the laz";
+  const int lines = 2000;
+  term.print("\x1b[0m\f");
+  emu.resetCounters();
+  for(int i = 0; i < lines; i++)
+  {
+    term.print(text);
+    term.print("\r\n");
+  }
+  double perChar = (double)emu.counters.busCycles / (lines * (sizeof(text) + 1));
+  printf("  text, block writes: %.2f bus cycles/char, %.0f chars/s at %.0f ns a cycle\n",
+         perChar, 1e9 / (perChar * ns), ns);
+  emu.resetCounters();
+  for(int i = 0; i < lines; i++)
+  {
+    for(size_t k = 0; k < sizeof(text) - 1; k++)
+    {
+      term.write( (uint8_t)text[k]);
+    }
+    term.write('\r');
+    term.write('\n');
+  }
+  double single = (double)emu.counters.busCycles / (lines * (sizeof(text) + 1));
+  printf("  text, write(c):     %.2f bus cycles/char, %.0f chars/s at %.0f ns a cycle\n",
+         single, 1e9 / (single * ns), ns);
+  check("block writes take fewer bus cycles", perChar < single);
+  check("no emulator errors", emu.counters.errors == 0);
+
+  printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures != 0;
+}
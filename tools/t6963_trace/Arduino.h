@@ -0,0 +1,177 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file Arduino.h
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief The few Arduino definitions the library needs to build on a PC
+///        against the emulator, shared by the tools.  Time only passes in
+///        delay() and delayMicroseconds().  Interrupts are not modelled:
+///        noInterrupts() and interrupts() do nothing.
+///
+///        Pins live on fake Uno ports: 0-7 on port D, 8-13 on port B and
+///        14-19 (A0-A5) on port C.  pinMode and digitalWrite change the
+///        mode and output registers the way the core does, so both the
+///        digital and the port bus backends can be checked against them
+///        (see tools/t6963_port).  Inputs read hostPort(p).in, which a
+///        test sets to what the pins would show.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef T6963_HOST_ARDUINO_H
+#define T6963_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define HIGH                              1
+#define LOW                               0
+#define INPUT                             0
+#define OUTPUT                            1
+
+#define A0                               14
+#define A1                               15
+#define A2                               16
+#define A3                               17
+#define A4                               18
+#define A5                               19
+
+// Fake port registers, indexed by the AVR port numbers
+#define HOST_PORT_B                       2
+#define HOST_PORT_C                       3
+#define HOST_PORT_D                       4
+
+struct HostPort
+{
+  volatile uint8_t out;     // PORTx
+  volatile uint8_t in;      // PINx, set by the test
+  volatile uint8_t mode;    // DDRx
+};
+
+inline HostPort& hostPort(uint8_t port) { static HostPort ports[5]; return ports[port % 5]; }
+inline uint8_t& hostSREG() { static uint8_t sreg = 0x80; return sreg; }
+
+// Pins past A5 are NOT_A_PIN: port 0, bit mask 0
+#define digitalPinToPort(p)               ( (p) < 8 ? HOST_PORT_D : (p) < 14 ? HOST_PORT_B : \
+                                            (p) < 20 ? HOST_PORT_C : 0)
+#define digitalPinToBitMask(p)            ( (p) >= 20 ? 0 : \
+                                            (uint8_t)(1 << ( (p) < 8 ? (p) : (p) < 14 ? (p) - 8 : (p) - 14)))
+#define portOutputRegister(port)          (&hostPort(port).out)
+#define portInputRegister(port)           (&hostPort(port).in)
+#define portModeRegister(port)            (&hostPort(port).mode)
+#define SREG                              hostSREG()
+inline void cli() {}
+
+#define PROGMEM
+#define pgm_read_byte(p)                  (*(const uint8_t*)(p))
+#define pgm_read_word(p)                  (*(const uint16_t*)(p))
+#define pgm_read_ptr(p)                   (*(void* const*)(p))
+
+inline unsigned long& hostMicros() { static unsigned long us = 0; return us; }
+inline unsigned long micros() { return hostMicros(); }
+inline unsigned long millis() { return hostMicros() / 1000; }
+inline void delayMicroseconds(unsigned int us) { hostMicros() += us; }
+inline void delay(unsigned long ms) { hostMicros() += ms * 1000; }
+
+// Calls of the pin functions, for tools that count pin operations
+struct HostPinOps
+{
+  unsigned long pinModes;
+  unsigned long digitalWrites;
+  unsigned long digitalReads;
+};
+
+inline HostPinOps& hostPinOps() { static HostPinOps ops = { 0, 0, 0 }; return ops; }
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  hostPinOps().pinModes++;
+  HostPort& port = hostPort(digitalPinToPort(pin));
+  uint8_t bit = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  cli();
+  if(mode == OUTPUT)
+  {
+    port.mode |= bit;
+  }
+  else
+  {
+    port.mode &= ~bit;
+    port.out &= ~bit;
+  }
+  SREG = oldSREG;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+  hostPinOps().digitalWrites++;
+  HostPort& port = hostPort(digitalPinToPort(pin));
+  uint8_t bit = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  cli();
+  if(level == LOW)
+  {
+    port.out &= ~bit;
+  }
+  else
+  {
+    port.out |= bit;
+  }
+  SREG = oldSREG;
+}
+
+inline int digitalRead(uint8_t pin)
+{
+  hostPinOps().digitalReads++;
+  return (hostPort(digitalPinToPort(pin)).in & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void yield() {}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class Print
+/// @brief The part of the Arduino Print class the library uses: a byte
+///        sink with text and number printing on top
+//////////////////////////////////////////////////////////////////////////////
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t size)
+    {
+      size_t rtn = 0;
+      while(size-- > 0)
+      {
+        rtn += write(*buf++);
+      }
+      return rtn;
+    }
+    size_t write(const char* s) { return write( (const uint8_t*)s, strlen(s)); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write( (uint8_t)c); }
+    size_t print(long v) { char b[12]; snprintf(b, sizeof(b), "%ld", v); return write(b); }
+    size_t print(unsigned long v) { char b[12]; snprintf(b, sizeof(b), "%lu", v); return write(b); }
+    size_t print(int v) { return print( (long)v); }
+    size_t print(unsigned int v) { return print( (unsigned long)v); }
+    size_t println() { return write("\n"); }
+    template<class T> size_t println(T v) { return print(v) + println(); }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class Stream
+/// @brief A Print that can also be read from
+//////////////////////////////////////////////////////////////////////////////
+
+class Stream : public Print
+{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#endif
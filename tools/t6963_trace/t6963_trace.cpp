@@ -0,0 +1,358 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_trace.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Decode a bus trace printed by T6963::dumpTrace and replay it on
+///        the emulator.  Build from the top of the repository with
+///
+///   g++ -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_trace/t6963_trace.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp -o t6963_trace
+///
+///        Usage: t6963_trace [-l] [-s] [-c columns] [-h height] [-f font]
+///                           [capture.txt]
+///          -l  list every transaction
+///          -s  print the emulated screen after the replay
+///        The capture may hold other serial output around the trace.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "T6963_emu.h"
+
+struct Record
+{
+  uint8_t type;
+  uint8_t value;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn commandName
+///  @return  Name of a command byte, NULL if unknown
+////////////////////////////////////////////////////////////////////////////////
+static const char* commandName(uint8_t cmd)
+{
+  const char* rtn = NULL;
+  if(cmd == T6963_SET_CURSOR_POINTER)
+  {
+    rtn = "SET_CURSOR_POINTER";
+  }
+  else if(cmd == T6963_SET_OFFSET_REGISTER)
+  {
+    rtn = "SET_OFFSET_REGISTER";
+  }
+  else if(cmd == T6963_SET_ADDRESS_POINTER)
+  {
+    rtn = "SET_ADDRESS_POINTER";
+  }
+  else if(cmd == T6963_SET_TEXT_HOME_ADDRESS)
+  {
+    rtn = "SET_TEXT_HOME_ADDRESS";
+  }
+  else if(cmd == T6963_SET_TEXT_AREA)
+  {
+    rtn = "SET_TEXT_AREA";
+  }
+  else if(cmd == T6963_SET_GRAPHIC_HOME_ADDRESS)
+  {
+    rtn = "SET_GRAPHIC_HOME_ADDRESS";
+  }
+  else if(cmd == T6963_SET_GRAPHIC_AREA)
+  {
+    rtn = "SET_GRAPHIC_AREA";
+  }
+  else if( (cmd & 0xf0) == T6963_SET_MODE)
+  {
+    rtn = "SET_MODE";
+  }
+  else if( (cmd & 0xf0) == T6963_DISPLAY_MODE)
+  {
+    rtn = "DISPLAY_MODE";
+  }
+  else if( (cmd & 0xf8) == T6963_CURSOR_SIZE)
+  {
+    rtn = "CURSOR_SIZE";
+  }
+  else if(cmd == T6963_AUTO_WRITE_SET)
+  {
+    rtn = "AUTO_WRITE_SET";
+  }
+  else if(cmd == T6963_AUTO_READ_SET)
+  {
+    rtn = "AUTO_READ_SET";
+  }
+  else if( (cmd & 0xfe) == T6963_AUTO_RESET)
+  {
+    rtn = "AUTO_RESET";
+  }
+  else if(cmd == T6963_DATA_WRITE_INC || cmd == T6963_DATA_WRITE_DEC ||
+          cmd == T6963_DATA_WRITE)
+  {
+    rtn = "DATA_WRITE";
+  }
+  else if(cmd == T6963_DATA_READ_INC || cmd == T6963_DATA_READ_DEC ||
+          cmd == T6963_DATA_READ)
+  {
+    rtn = "DATA_READ";
+  }
+  else if(cmd == T6963_SCREEN_PEEK)
+  {
+    rtn = "SCREEN_PEEK";
+  }
+  else if(cmd == T6963_SCREEN_COPY)
+  {
+    rtn = "SCREEN_COPY";
+  }
+  else if( (cmd & 0xf0) == T6963_SET_RESET)
+  {
+    rtn = (cmd & 0x08) ? "SET_BIT" : "RESET_BIT";
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn hexValue
+///  @return  Value of a hex digit, -1 if c is not one
+////////////////////////////////////////////////////////////////////////////////
+static int hexValue(int c)
+{
+  int rtn = -1;
+  if(c >= '0' && c <= '9')
+  {
+    rtn = c - '0';
+  }
+  else if(c >= 'a' && c <= 'f')
+  {
+    rtn = c - 'a' + 10;
+  }
+  else if(c >= 'A' && c <= 'F')
+  {
+    rtn = c - 'A' + 10;
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn readTrace
+///  @brief  Find the first trace in a capture and decode its records
+///  @param[in]  in    The capture
+///  @param[out] recs  The records, oldest first
+///  @param[out] lost  Records the board overwrote before the dump
+///  @return  True if a complete trace was found
+////////////////////////////////////////////////////////////////////////////////
+static bool readTrace(FILE* in, std::vector<Record>& recs, unsigned long& lost)
+{
+  char line[512];
+  bool inside = false;
+  bool done = false;
+  unsigned long count = 0;
+  std::vector<uint8_t> bytes;
+  while(!done && fgets(line, sizeof(line), in) != NULL)
+  {
+    const char* start = strstr(line, "T6963 TRACE ");
+    if(!inside)
+    {
+      if(start != NULL && sscanf(start, "T6963 TRACE %lu %lu", &count, &lost) == 2)
+      {
+        inside = true;
+      }
+    }
+    else if(strncmp(line, "END", 3) == 0)
+    {
+      done = true;
+    }
+    else
+    {
+      for(const char* p = line; hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0; p += 2)
+      {
+        bytes.push_back(hexValue(p[0]) << 4 | hexValue(p[1]));
+      }
+    }
+  }
+  for(size_t i = 0; i + 1 < bytes.size(); i += 2)
+  {
+    Record r = { bytes[i], bytes[i + 1] };
+    recs.push_back(r);
+  }
+  if(done && recs.size() != count)
+  {
+    fprintf(stderr, "warning: header says %lu records, found %lu\n",
+            count, (unsigned long)recs.size());
+  }
+  return done;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int rtn = 0;
+  bool list = false;
+  bool screen = false;
+  int columns = 40;
+  int height = 64;
+  int font = 6;
+  const char* path = NULL;
+  FILE* in = stdin;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-l") == 0)
+    {
+      list = true;
+    }
+    else if(strcmp(argv[i], "-s") == 0)
+    {
+      screen = true;
+    }
+    else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+    {
+      columns = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-h") == 0 && i + 1 < argc)
+    {
+      height = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+    {
+      font = atoi(argv[++i]);
+    }
+    else
+    {
+      path = argv[i];
+    }
+  }
+  if(path != NULL)
+  {
+    in = fopen(path, "r");
+  }
+
+  std::vector<Record> recs;
+  unsigned long lost = 0;
+  if(in == NULL || !readTrace(in, recs, lost))
+  {
+    fprintf(stderr, "no complete T6963 TRACE found\n");
+    rtn = 1;
+  }
+  else
+  {
+    T6963Emulator emu(columns, height, font);
+    unsigned long data = 0;
+    unsigned long commands = 0;
+    unsigned long reads = 0;
+    unsigned long polls = 0;
+    unsigned long waits = 0;
+    unsigned long mismatches = 0;
+    unsigned long perCommand[256];
+    uint8_t params[2] = { 0, 0 };
+    uint8_t numParams = 0;
+    bool autoMode = false;
+    memset(perCommand, 0, sizeof(perCommand));
+
+    for(size_t i = 0; i < recs.size(); i++)
+    {
+      const Record& r = recs[i];
+      if(r.type == T6963_REC_DATA)
+      {
+        data++;
+        if(!autoMode)
+        {
+          params[0] = (numParams == 2) ? params[1] : params[0];
+          params[numParams == 2 ? 1 : numParams] = r.value;
+          numParams = (numParams == 2) ? 2 : numParams + 1;
+        }
+        emu.write(LOW, r.value);
+        if(list)
+        {
+          printf("%6lu  data     %02x\n", (unsigned long)i, r.value);
+        }
+      }
+      else if(r.type == T6963_REC_COMMAND)
+      {
+        const char* name = commandName(r.value);
+        commands++;
+        perCommand[r.value]++;
+        emu.write(HIGH, r.value);
+        if(list)
+        {
+          printf("%6lu  command  %02x %-24s", (unsigned long)i, r.value, name ? name : "?");
+          if(numParams == 2)
+          {
+            printf(" %02x %02x (%u)", params[0], params[1], params[0] | params[1] << 8);
+          }
+          else if(numParams == 1)
+          {
+            printf(" %02x", params[0]);
+          }
+          printf("\n");
+        }
+        numParams = 0;
+        autoMode = (r.value == T6963_AUTO_WRITE_SET || r.value == T6963_AUTO_READ_SET);
+      }
+      else if(r.type == T6963_REC_READ)
+      {
+        uint8_t d = emu.read(LOW);
+        reads++;
+        if(d != r.value)
+        {
+          mismatches++;
+        }
+        if(list)
+        {
+          printf("%6lu  read     %02x%s\n", (unsigned long)i, r.value,
+                 d != r.value ? "  (emulator differs)" : "");
+        }
+      }
+      else if(r.type == T6963_REC_POLLS)
+      {
+        polls += r.value;
+        waits++;
+        if(list)
+        {
+          printf("%6lu  busy     %u polls\n", (unsigned long)i, r.value);
+        }
+      }
+    }
+
+    printf("records %lu (lost %lu)\n", (unsigned long)recs.size(), lost);
+    printf("data bytes %lu, commands %lu, data reads %lu\n", data, commands, reads);
+    printf("busy polls %lu in %lu waits\n", polls, waits);
+    for(int c = 0; c < 256; c++)
+    {
+      if(perCommand[c] != 0)
+      {
+        const char* name = commandName(c);
+        printf("  %02x %-24s %lu\n", c, name ? name : "?", perCommand[c]);
+      }
+    }
+    printf("replay: %lu bus cycles, %lu errors, %lu read mismatches\n",
+           (unsigned long)emu.counters.busCycles, (unsigned long)emu.counters.errors,
+           mismatches);
+    printf("registers: text home %u area %u, graphic home %u area %u, "
+           "mode %02x display %02x\n",
+           emu.getTextHome(), emu.getTextArea(), emu.getGraphicHome(),
+           emu.getGraphicArea(), emu.getMode(), emu.getDisplayMode());
+    if(mismatches != 0)
+    {
+      printf("note: reads differ where the trace began after RAM was written\n");
+    }
+    if(screen)
+    {
+      for(int y = 0; y < height; y++)
+      {
+        for(int x = 0; x < columns * font; x++)
+        {
+          putchar(emu.pixel(x, y) ? '#' : '.');
+        }
+        putchar('\n');
+      }
+    }
+  }
+  if(in != NULL && in != stdin)
+  {
+    fclose(in);
+  }
+  return rtn;
+}
@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_trace_check.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Check that a trace recorded by the instrumented driver replays
+///        to the same screen.  Draws on the emulator with T6963_TRACE
+///        built in, dumps the trace the way a board does over Serial, runs
+///        t6963_trace on the capture and compares its counts and screen
+///        with the live emulator.  Build from the top of the repository
+///        with
+///
+///   g++ -DT6963_BUS=2 -DT6963_TRACE=1 -DT6963_TRACE_SIZE=4096
+///       -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_trace/t6963_trace_check.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_gfx.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_shadow.cpp -o t6963_trace_check
+///
+///        Usage: t6963_trace_check [path of t6963_trace]
+///        (default ./t6963_trace).  Exits non-zero on any difference.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "T6963_emu.h"
+#include "T6963_gfx.h"
+
+#if !T6963_TRACE
+#error build with -DT6963_TRACE=1
+#endif
+
+#define COLUMNS                          40
+#define HEIGHT                           64
+#define FONT                              6
+
+//////////////////////////////////////////////////////////////////////////////
+/// @class FilePrint
+/// @brief Print to a stdio file, standing in for Serial
+//////////////////////////////////////////////////////////////////////////////
+
+class FilePrint : public Print
+{
+  public:
+    FilePrint(FILE* f) : f(f) {}
+    size_t write(uint8_t c) { return fputc(c, f) == EOF ? 0 : 1; }
+    using Print::write;
+
+  private:
+    FILE* f;
+};
+
+static int failures = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn check
+///  @brief  Report one comparison, counting failures
+////////////////////////////////////////////////////////////////////////////////
+static void check(bool ok, const char* what, unsigned long got, unsigned long want)
+{
+  printf("%-34s %8lu %8lu  %s\n", what, got, want, ok ? "ok" : "FAIL");
+  if(!ok)
+  {
+    failures++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  const char* tool = (argc > 1) ? argv[1] : "./t6963_trace";
+  char path[] = "/tmp/t6963_traceXXXXXX";
+  int fd = mkstemp(path);
+  FILE* capture = (fd >= 0) ? fdopen(fd, "w") : NULL;
+  if(capture == NULL)
+  {
+    fprintf(stderr, "cannot create %s\n", path);
+    return 2;
+  }
+
+  // Draw with every record type in the trace: parameters, commands,
+  // auto writes, reads for the read-modify-write, and busy polls
+  T6963Emulator emu(COLUMNS, HEIGHT, FONT);
+  T6963 lcd(emu);
+  lcd.ports_init();
+  lcd.startTrace();
+  lcd.setTextHomeAddress(0);
+  lcd.setTextArea(COLUMNS);
+  lcd.setGraphicHomeAddress(0x0800);
+  lcd.setGraphicArea(COLUMNS);
+  lcd.setOrMode();
+  lcd.setDisplayMode(0, 1);
+  lcd.clearText();
+  T6963Graphics gfx(lcd, COLUMNS * FONT, HEIGHT);
+  gfx.fillRect(10, 10, 50, 20, 1);
+  gfx.circle(120, 32, 20, 1);
+  gfx.line(0, 63, 239, 0, 1);
+  gfx.rmwRect(20, 15, 30, 10, T6963_ROP_XOR);
+  lcd.setAddress(0x0800);
+  lcd.dataReadIncrement();
+  lcd.stopTrace();
+
+  fprintf(capture, "boot messages before the trace\n");
+  FilePrint out(capture);
+  lcd.dumpTrace(out);
+  fprintf(capture, "and after it\n");
+  fclose(capture);
+
+  T6963Stats& s = lcd.getStats();
+  char cmd[512];
+  snprintf(cmd, sizeof(cmd), "%s -s -c %d -h %d -f %d %s", tool, COLUMNS, HEIGHT, FONT, path);
+  FILE* replay = popen(cmd, "r");
+  if(replay == NULL)
+  {
+    fprintf(stderr, "cannot run %s\n", tool);
+    unlink(path);
+    return 2;
+  }
+
+  char line[COLUMNS * FONT + 64];
+  unsigned long records = 0;
+  unsigned long lost = 1;
+  unsigned long data = 0;
+  unsigned long commands = 0;
+  unsigned long reads = 0;
+  unsigned long cycles = 0;
+  unsigned long errors = 1;
+  unsigned long mismatches = 1;
+  int y = -1;
+  unsigned long pixelDiffs = 0;
+  while(fgets(line, sizeof(line), replay) != NULL)
+  {
+    if(y >= 0 && y < HEIGHT)
+    {
+      for(int x = 0; x < COLUMNS * FONT; x++)
+      {
+        if( (line[x] == '#') != emu.pixel(x, y))
+        {
+          pixelDiffs++;
+        }
+      }
+      y++;
+    }
+    else if(sscanf(line, "records %lu (lost %lu)", &records, &lost) == 2 ||
+            sscanf(line, "data bytes %lu, commands %lu, data reads %lu", &data, &commands, &reads) == 3)
+    {
+    }
+    else if(sscanf(line, "replay: %lu bus cycles, %lu errors, %lu read mismatches",
+                   &cycles, &errors, &mismatches) == 3)
+    {
+    }
+    else if(strncmp(line, "registers:", 10) == 0)
+    {
+      y = 0;    // the screen follows
+    }
+  }
+  pclose(replay);
+  unlink(path);
+
+  printf("%-34s %8s %8s\n", "", "replay", "driver");
+  check(records == lcd.getTraceLength(), "records", records, lcd.getTraceLength());
+  check(lost == 0 && lcd.getTraceLost() == 0, "records lost", lost, lcd.getTraceLost());
+  check(data == s.dataBytes, "data bytes", data, s.dataBytes);
+  check(commands == s.commandBytes, "commands", commands, s.commandBytes);
+  check(reads == s.dataReads, "data reads", reads, s.dataReads);
+  check(errors == 0, "emulator errors", errors, 0);
+  check(mismatches == 0, "read mismatches", mismatches, 0);
+  check(y == HEIGHT, "screen rows", y < 0 ? 0 : y, HEIGHT);
+  check(pixelDiffs == 0, "pixels differing", pixelDiffs, 0);
+  printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures == 0 ? 0 : 1;
+}
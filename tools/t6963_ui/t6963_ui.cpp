@@ -0,0 +1,380 @@
+//////////////////////////////////////////////////////////////////////////////
+/// @file t6963_ui.cpp
+/// @copy Copyright (C) 2021 Will Cooke
+/// @brief Run a widget screen headless against the emulator, report the
+///        bytes each refresh sends and check the display RAM after every
+///        refresh: number and menu text cells, bar, sparkline and icon
+///        pixels, and that RAM matches the shadow.  A second screen runs
+///        in text attribute mode and checks the reverse video menu
+///        highlight and setAttribute in the attribute plane.  Build from
+///        the top of the repository with
+///
+///   g++ -DT6963_BUS=2 -Itools/t6963_trace -IArduino/T6963_lib/T6963_lib
+///       tools/t6963_ui/t6963_ui.cpp Arduino/T6963_lib/T6963_lib/T6963.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_emu.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_shadow.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_gfx.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_attr.cpp
+///       Arduino/T6963_lib/T6963_lib/T6963_ui.cpp -o t6963_ui
+///
+///        Usage: t6963_ui [-t ticks] [-q] [-s]
+///          -t  UI ticks to run (default 60)
+///          -q  only print the totals
+///          -s  print the text area and the graphic area at the end
+///        Exits non-zero if any check fails.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "T6963_emu.h"
+#include "T6963_ui.h"
+
+#define COLUMNS                          40
+#define HEIGHT                           64
+#define FONT                              6
+#define ATTR_HOME                    0x0800
+
+// 16x16 icons, 2 bytes per row
+static const uint8_t flameIcon[] PROGMEM =
+{
+  0x01, 0x00, 0x03, 0x00, 0x03, 0x80, 0x07, 0x80, 0x07, 0xc0, 0x0f, 0xc0,
+  0x0f, 0xe0, 0x1f, 0xe0, 0x1e, 0xf0, 0x3c, 0xf0, 0x3c, 0x78, 0x38, 0x78,
+  0x38, 0x38, 0x1c, 0x70, 0x0f, 0xe0, 0x07, 0xc0,
+};
+
+static const uint8_t idleIcon[] PROGMEM =
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x3f, 0xfc, 0x3f, 0xfc,
+};
+
+static const char* const menuItems[] =
+{
+  "Setpoint", "Schedule", "Alarms", "History", "Network",
+};
+
+static const char* const menuItems2[] =
+{
+  "Off", "Low", "High", "Auto",
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn textAt
+///  @return  Text cells that differ from a string, read from display RAM
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long textAt(T6963Emulator& emu, uint8_t col, uint8_t row, const char* str)
+{
+  unsigned long rtn = 0;
+  for(uint8_t i = 0; str[i] != 0; i++)
+  {
+    uint8_t code = emu.ram(emu.getTextHome() + row * emu.getTextArea() + col + i);
+    rtn += (code != (uint8_t)(str[i] - 32));
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn menuRow
+///  @brief  What a menu row should hold: the item padded to width, behind
+///          a '>' or a space unless the selection is shown reversed
+////////////////////////////////////////////////////////////////////////////////
+static void menuRow(char* buf, uint8_t width, const char* item, bool selected, bool reverse)
+{
+  snprintf(buf, width + 1, "%s%-*s", reverse ? "" : (selected ? ">" : " "),
+           reverse ? width : width - 1, item);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn matchesShadow
+///  @return  Bytes of display RAM that differ from the shadow
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long matchesShadow(T6963Emulator& emu, const uint8_t* textBuf,
+                                   const uint8_t* graphicBuf)
+{
+  unsigned long rtn = 0;
+  for(int i = 0; i < COLUMNS * HEIGHT / 8; i++)
+  {
+    rtn += emu.ram(emu.getTextHome() + i) != textBuf[i];
+  }
+  for(int i = 0; graphicBuf != NULL && i < COLUMNS * HEIGHT; i++)
+  {
+    rtn += emu.ram(emu.getGraphicHome() + i) != graphicBuf[i];
+  }
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn attributeScreen
+///  @brief  Labels and a menu in text attribute mode: the selection must be
+///          reversed in the attribute plane, with no '>' in the text, and
+///          setAttribute must write once and be counted by render
+///  @return  Failed checks
+////////////////////////////////////////////////////////////////////////////////
+static unsigned long attributeScreen()
+{
+  unsigned long rtn = 0;
+  T6963Emulator emu(COLUMNS, HEIGHT, FONT);
+  T6963 lcd(emu);
+  lcd.ports_init();
+  lcd.setFontWidth(FONT);
+  lcd.setPanelSize(COLUMNS * FONT, HEIGHT);
+  lcd.setTextHomeAddress(0);
+  lcd.setTextArea(COLUMNS);
+  lcd.setGraphicHomeAddress(ATTR_HOME);
+  lcd.setGraphicArea(COLUMNS);
+  lcd.setTextAttributeMode();
+  lcd.setDisplayMode(1, 1);
+  lcd.clear();
+
+  static uint8_t textBuf[COLUMNS * HEIGHT / 8];
+  T6963Shadow shadow(lcd, HEIGHT);
+  T6963Graphics gfx(lcd, COLUMNS * FONT, HEIGHT);
+  T6963Attributes attrs(lcd, COLUMNS, HEIGHT / 8);
+  shadow.begin(textBuf, NULL);
+  T6963Ui ui(shadow, gfx, &attrs);
+
+  T6963Group screen;
+  T6963Label title(0, 0, 20, "MODE");
+  T6963Menu menu(0, 2, 10, 2);
+  screen.add(title);
+  screen.add(menu);
+  menu.setItems(menuItems2, sizeof(menuItems2) / sizeof(menuItems2[0]));
+  ui.setScreen(&screen);
+
+  uint8_t sel = 0;
+  uint8_t top = 0;
+  for(int step = 0; step < 10; step++)
+  {
+    ui.render();
+    rtn += textAt(emu, 0, 0, "MODE");
+    for(uint8_t r = 0; r < 2; r++)
+    {
+      char buf[16];
+      menuRow(buf, 10, menuItems2[top + r], false, true);
+      rtn += textAt(emu, 0, 2 + r, buf);
+    }
+    for(uint8_t row = 0; row < HEIGHT / 8; row++)
+    {
+      for(uint8_t col = 0; col < COLUMNS; col++)
+      {
+        bool reversed = (row == 2 + sel - top && col < 10);
+        uint8_t want = reversed ? T6963_ATTR_REVERSE : T6963_ATTR_NORMAL;
+        rtn += emu.ram(ATTR_HOME + row * COLUMNS + col) != want;
+        rtn += attrs.get(col, row) != want;
+      }
+    }
+    menu.next();
+    sel = (sel + 1) % 4;
+    top = (sel < top) ? sel : (sel >= top + 2) ? sel - 1 : top;
+  }
+  ui.render();
+  rtn += matchesShadow(emu, textBuf, NULL);
+
+  // Between renders: written at once, counted by the next render, and
+  // not written again when nothing changes
+  ui.setAttribute(0, 0, 4, T6963_ATTR_BLINK);
+  for(uint8_t col = 0; col < COLUMNS; col++)
+  {
+    uint8_t want = (col < 4) ? T6963_ATTR_BLINK : T6963_ATTR_NORMAL;
+    rtn += emu.ram(ATTR_HOME + col) != want;
+  }
+  rtn += ui.render() != 4;
+  emu.resetCounters();
+  ui.setAttribute(0, 0, 4, T6963_ATTR_BLINK);
+  rtn += ui.render() != 0 || emu.counters.busCycles != 0;
+  rtn += emu.counters.errors;
+  return rtn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn printScreen
+///  @brief  Print the text area as ASCII and the graphic area as pixels
+////////////////////////////////////////////////////////////////////////////////
+static void printScreen(T6963Emulator& emu)
+{
+  for(int r = 0; r < HEIGHT / 8; r++)
+  {
+    for(int c = 0; c < COLUMNS; c++)
+    {
+      uint8_t code = emu.ram(emu.getTextHome() + r * emu.getTextArea() + c);
+      putchar(code < 0x5f ? code + 32 : '?');
+    }
+    putchar('\n');
+  }
+  putchar('\n');
+  for(int y = 0; y < HEIGHT; y++)
+  {
+    for(int x = 0; x < COLUMNS * FONT; x++)
+    {
+      uint8_t d = emu.ram(emu.getGraphicHome() + y * emu.getGraphicArea() + x / FONT);
+      putchar( (d >> (FONT - 1 - x % FONT)) & 1 ? '#' : '.');
+    }
+    putchar('\n');
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///  @fn main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  int ticks = 60;
+  bool quiet = false;
+  bool screen = false;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+    {
+      ticks = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-q") == 0)
+    {
+      quiet = true;
+    }
+    else if(strcmp(argv[i], "-s") == 0)
+    {
+      screen = true;
+    }
+  }
+
+  T6963Emulator emu(COLUMNS, HEIGHT, FONT);
+  T6963 lcd(emu);
+  lcd.ports_init();
+  lcd.setFontWidth(FONT);
+  lcd.setPanelSize(COLUMNS * FONT, HEIGHT);
+  lcd.setTextHomeAddress(0);
+  lcd.setTextArea(COLUMNS);
+  lcd.setGraphicHomeAddress(0x0800);
+  lcd.setGraphicArea(COLUMNS);
+  lcd.setOrMode();
+  lcd.setDisplayMode(1, 1);
+  lcd.clear();
+
+  static uint8_t textBuf[COLUMNS * HEIGHT / 8];
+  static uint8_t graphicBuf[COLUMNS * HEIGHT];
+  T6963Shadow shadow(lcd, HEIGHT);
+  T6963Graphics gfx(lcd, COLUMNS * FONT, HEIGHT);
+  shadow.begin(textBuf, graphicBuf);
+  gfx.setFramebuffer(&shadow);
+  T6963Ui ui(shadow, gfx);
+
+  T6963Group main;
+  T6963Label title(0, 0, 20, "BOILER 1");
+  T6963Label tempName(0, 1, 5, "Temp");
+  T6963Number temp(5, 1, 6, 1);
+  T6963Label pressName(0, 2, 5, "Bar");
+  T6963Number press(5, 2, 6, 2);
+  T6963Bar tempBar(90, 9, 96, 6, 0, 1000);
+  T6963Sparkline trend(90, 24, 64, 24, 0, 1000);
+  T6963Icon state(216, 0, 16, 16, idleIcon);
+  T6963Menu menu(0, 4, 12, 3);
+  main.add(title);
+  main.add(tempName);
+  main.add(temp);
+  main.add(pressName);
+  main.add(press);
+  main.add(tempBar);
+  main.add(trend);
+  main.add(state);
+  main.add(menu);
+  menu.setItems(menuItems, sizeof(menuItems) / sizeof(menuItems[0]));
+  ui.setScreen(&main);
+
+  unsigned long bad = 0;
+  unsigned long first = ui.render();
+  unsigned long full = sizeof(textBuf) + sizeof(graphicBuf);
+  int16_t t = 500;
+  int16_t pushed = 0;
+  if(!quiet)
+  {
+    printf("tick  0: %5lu bytes, %u widgets (first draw)\n", first, ui.getLastDrawn());
+  }
+  ui.resetCounters();
+  for(int tick = 1; tick <= ticks; tick++)
+  {
+    t += (tick * 37 % 11) - 5;
+    temp.setValue(t);
+    tempBar.setValue(t);
+    if(tick % 4 == 0)
+    {
+      trend.push(t);
+      pushed = t;
+    }
+    if(tick % 5 == 0)
+    {
+      press.setValue(150 + tick % 7);
+    }
+    if(tick % 10 == 0)
+    {
+      state.setBitmap_P( (tick / 10) % 2 ? flameIcon : idleIcon);
+    }
+    if(tick % 15 == 0)
+    {
+      menu.next();
+    }
+    ui.render();
+    if(!quiet)
+    {
+      printf("tick %2d: %5u bytes, %u widgets\n", tick, ui.getLastBytes(), ui.getLastDrawn());
+    }
+
+    // Text cells, formatted here rather than by T6963Number
+    char buf[16];
+    int16_t p = (tick >= 5) ? 150 + (tick - tick % 5) % 7 : 0;
+    snprintf(buf, sizeof(buf), "%4d.%d", t / 10, t % 10);
+    bad += textAt(emu, 5, 1, buf);
+    snprintf(buf, sizeof(buf), "%3d.%02d", p / 100, p % 100);
+    bad += textAt(emu, 5, 2, buf);
+    bad += textAt(emu, 0, 0, "BOILER 1");
+    uint8_t sel = (tick / 15) % 5;
+    uint8_t top = (sel < 3) ? 0 : sel - 2;
+    for(uint8_t r = 0; r < 3; r++)
+    {
+      menuRow(buf, 12, menuItems[top + r], top + r == sel, false);
+      bad += textAt(emu, 0, 4 + r, buf);
+    }
+
+    // Bar: frame, then t * 94 / 1000 pixels filled from the left
+    int fill = t * 94 / 1000;
+    for(int y = 9; y < 15; y++)
+    {
+      for(int x = 90; x < 186; x++)
+      {
+        bool frame = (y == 9 || y == 14 || x == 90 || x == 185);
+        bad += emu.pixel(x, y) != (frame || x - 91 < fill);
+      }
+    }
+
+    // Newest sparkline sample at the right edge
+    if(tick >= 4)
+    {
+      bad += !emu.pixel(90 + 63, 24 + 23 - pushed * 23 / 1000);
+    }
+
+    // Icon pixels
+    const uint8_t* bits = (tick >= 10 && (tick / 10) % 2) ? flameIcon : idleIcon;
+    for(int y = 0; y < 16; y++)
+    {
+      for(int x = 0; x < 16; x++)
+      {
+        bad += emu.pixel(216 + x, y) != ( (bits[y * 2 + x / 8] >> (7 - x % 8)) & 1);
+      }
+    }
+    bad += matchesShadow(emu, textBuf, graphicBuf);
+  }
+  printf("first draw %lu bytes; %d ticks sent %lu bytes, %lu per tick; "
+         "redrawing both areas is %lu per tick\n",
+         first, ticks, (unsigned long)ui.getTotalBytes(),
+         ticks > 0 ? (unsigned long)ui.getTotalBytes() / ticks : 0UL, full);
+  if(screen)
+  {
+    printScreen(emu);
+  }
+  bad += emu.counters.errors;
+  unsigned long attrBad = attributeScreen();
+  printf("widget screen: %lu bad; attribute screen: %lu bad\n", bad, attrBad);
+  printf("%s\n", bad == 0 && attrBad == 0 ? "PASS" : "FAIL");
+  return (bad == 0 && attrBad == 0) ? 0 : 1;
+}